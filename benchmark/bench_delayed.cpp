@@ -65,6 +65,29 @@ static void bench_tokens(benchmark::State& state) {
   }
 }
 
+// The same tokens, found by parlay::map_tokens, with a predicate that takes
+// the general path and with is_whitespace, which takes the vectorized one
+static void bench_map_tokens(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto str = parlay::tabulate(n, [] (size_t i) -> char { return (i%8 == 0) ? ' ' : 'a';});
+  auto is_space = [] (char c) {
+    switch (c)  {
+      case '\r': case '\t': case '\n': case ' ' : case '\v': case '\f': return true;
+      default : return false;
+    }
+  };
+  auto to_pair = [&] (auto&& t) { return std::make_pair(t.begin() - str.begin(), t.end() - str.begin()); };
+
+  for (auto _ : state) {
+    {
+      auto t = state.range(1) ? parlay::map_tokens(str, to_pair) : parlay::map_tokens(str, to_pair, is_space);
+      benchmark::DoNotOptimize(t);
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+}
+
 // ======================================================================
 //                             Primes
 // ======================================================================
@@ -387,6 +410,8 @@ static void bench_bfs(benchmark::State& state) {
 #define BENCH(NAME, N) BENCHMARK(bench_ ## NAME)->UseRealTime()->Unit(benchmark::kMillisecond)->Arg(N)->Iterations(20);
 
 BENCH(tokens, 500000000);
+BENCHMARK(bench_map_tokens)->UseRealTime()->Unit(benchmark::kMillisecond)->Args({500000000, 0})->Iterations(20);
+BENCHMARK(bench_map_tokens)->UseRealTime()->Unit(benchmark::kMillisecond)->Args({500000000, 1})->Iterations(20);
 BENCH(primes, 100000000);
 BENCH(bignum_add, 500000000);
 BENCH(bestcut, 200000000);
@@ -0,0 +1,116 @@
+// Benchmarks of the algorithms that are tuned by the cache sizes in
+// parlay's hardware profile, run with the profiles of several different
+// kinds of machines, so that the tuning can be evaluated without access
+// to each of them. Profile 0 is the detected profile, and profile 1
+// reproduces the constants that were used before the profile existed.
+
+#include <benchmark/benchmark.h>
+
+#include <parlay/hardware.h>
+#include <parlay/primitives.h>
+#include <parlay/random.h>
+#include <parlay/sequence.h>
+
+using benchmark::Counter;
+
+// Use this macro to avoid accidentally timing the destructors
+// of the output produced by algorithms that return data
+#define RUN_AND_CLEAR(e)      \
+  {                           \
+    auto result_ = (e);       \
+    state.PauseTiming();      \
+  }                           \
+  state.ResumeTiming();
+
+#define REPORT_STATS(n)                                                                  \
+  state.counters["    Elements/sec"] = Counter(state.iterations()*(n), Counter::kIsRate);
+
+static parlay::hardware_profile make_profile(size_t l2_kb, size_t l3_mb, size_t cpus_per_l3) {
+  parlay::hardware_profile p;
+  p.l1d_size = 32 << 10;
+  p.l2_size = l2_kb << 10;
+  p.l3_size = l3_mb << 20;
+  p.cpus_per_l3 = cpus_per_l3;
+  return p;
+}
+
+// Sets the profile for the duration of a benchmark
+struct profile_scope {
+  parlay::hardware_profile saved;
+
+  explicit profile_scope(size_t which) : saved(parlay::get_hardware_profile()) {
+    static const parlay::hardware_profile profiles[] = {
+      saved,                        // detected
+      make_profile(256, 32, 43),    // 1MB per thread, as previously assumed
+      make_profile(256, 8, 8),      // laptop
+      make_profile(1024, 48, 32),   // server with 1.5MB of L3 per core
+      make_profile(2048, 256, 64),  // server with 4MB of L3 per core
+    };
+    parlay::set_hardware_profile(profiles[which]);
+  }
+
+  ~profile_scope() { parlay::set_hardware_profile(saved); }
+};
+
+template<typename T>
+static void bench_histogram_by_key(benchmark::State& state) {
+  size_t n = state.range(0);
+  profile_scope scope(state.range(1));
+  parlay::random r(0);
+  auto S = parlay::tabulate(n, [&] (size_t i) -> T { return r.ith_rand(i) % (n / 16); });
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::histogram_by_key<T>(S));
+  }
+
+  REPORT_STATS(n);
+}
+
+template<typename T>
+static void bench_reduce_by_index(benchmark::State& state) {
+  size_t n = state.range(0);
+  profile_scope scope(state.range(1));
+  parlay::random r(0);
+  auto S = parlay::tabulate(n, [&] (size_t i) {
+    return std::make_pair(static_cast<size_t>(r.ith_rand(i) % (n / 16)), static_cast<T>(i));
+  });
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::reduce_by_index(S, n / 16));
+  }
+
+  REPORT_STATS(n);
+}
+
+template<typename T>
+static void bench_sort(benchmark::State& state) {
+  size_t n = state.range(0);
+  profile_scope scope(state.range(1));
+  parlay::random r(0);
+  auto S = parlay::tabulate(n, [&] (size_t i) -> T { return r.ith_rand(i); });
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::sort(S));
+  }
+
+  REPORT_STATS(n);
+}
+
+// ------------------------- Registration -------------------------------
+
+#define BENCH(NAME, T, N) BENCHMARK_TEMPLATE(bench_ ## NAME, T)                     \
+                          ->UseRealTime()                                           \
+                          ->Unit(benchmark::kMillisecond)                           \
+                          ->ArgsProduct({{N}, {0, 1, 2, 3, 4}});
+
+// If compiling in debug mode, use 1000x smaller inputs
+// or they will run forever or run out of RAM
+#ifndef NDEBUG
+#define PSIZE_FACTOR 1000
+#else
+#define PSIZE_FACTOR 1
+#endif
+
+BENCH(histogram_by_key, unsigned long, 100000000/PSIZE_FACTOR);
+BENCH(reduce_by_index, long, 100000000/PSIZE_FACTOR);
+BENCH(sort, long, 100000000/PSIZE_FACTOR);
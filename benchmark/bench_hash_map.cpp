@@ -0,0 +1,260 @@
+// Benchmarks of parlay's concurrent hash map and its fixed-size
+// hash tables
+
+#include <limits>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <parlay/concurrent_hash_map.h>
+#include <parlay/hash_table.h>
+#include <parlay/parallel.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+#include <parlay/swiss_hash_table.h>
+#include <parlay/utilities.h>
+
+using benchmark::Counter;
+
+#define REPORT_OPS(n)                                                                  \
+  state.counters["         Ops/sec"] = Counter(state.iterations()*(n), Counter::kIsRate);
+
+// n distinct keys in a random order
+static parlay::sequence<long> random_keys(size_t n) {
+  return parlay::tabulate(n, [](size_t i) { return static_cast<long>(parlay::hash64(i)); });
+}
+
+// Inserts n keys into a map that starts out empty and grows as needed
+static void bench_insert_grow(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = random_keys(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      parlay::concurrent_hash_map<long, long> map;
+      state.ResumeTiming();
+      parlay::parallel_for(0, n, [&](size_t i) { map.insert(keys[i], static_cast<long>(i)); });
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  REPORT_OPS(n);
+}
+
+// Inserts n keys into a map that is created large enough to hold them
+static void bench_insert_reserved(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = random_keys(n);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      parlay::concurrent_hash_map<long, long> map(n);
+      state.ResumeTiming();
+      parlay::parallel_for(0, n, [&](size_t i) { map.insert(keys[i], static_cast<long>(i)); });
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  REPORT_OPS(n);
+}
+
+// Looks up n keys, half of which are present, in a map holding n keys
+// at an average of load_percent/100 keys per bucket
+static void bench_find(benchmark::State& state) {
+  size_t n = state.range(0);
+  double load = static_cast<double>(state.range(1)) / 100;
+  auto keys = random_keys(2 * n);
+  parlay::concurrent_hash_map<long, long> map(n, load);
+  parlay::parallel_for(0, n, [&](size_t i) { map.insert(keys[2 * i], static_cast<long>(i)); });
+  for (auto _ : state) {
+    auto found = parlay::reduce(parlay::delayed_tabulate(n, [&](size_t i) -> size_t {
+      return map.find(keys[i]).has_value();
+    }));
+    benchmark::DoNotOptimize(found);
+  }
+  REPORT_OPS(n);
+}
+
+// Performs n operations on a map holding n/2 keys, of which
+// write_percent% are updates, split evenly between inserting a
+// new key and erasing an existing one, and the rest are finds
+static void bench_mixed(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t write_percent = state.range(1);
+  auto keys = random_keys(2 * n);
+  parlay::concurrent_hash_map<long, long> map(n);
+  parlay::parallel_for(0, n / 2, [&](size_t i) { map.insert(keys[i], static_cast<long>(i)); });
+  for (auto _ : state) {
+    parlay::parallel_for(0, n, [&](size_t i) {
+      size_t r = parlay::hash64(i) % 100;
+      long k = keys[parlay::hash64(i + n) % (2 * n)];
+      if (r >= write_percent) benchmark::DoNotOptimize(map.find(k));
+      else if (r % 2 == 0) map.insert(k, static_cast<long>(i));
+      else map.erase(k);
+    });
+  }
+  REPORT_OPS(n);
+}
+
+// The fixed-size hashtable, for comparison with insert_reserved
+static void bench_hashtable_insert(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::map(random_keys(n), [](long k) { return k & (std::numeric_limits<long>::max)(); });
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      parlay::hashtable<parlay::hash_numeric<long>> table(n, parlay::hash_numeric<long>{});
+      state.ResumeTiming();
+      parlay::parallel_for(0, n, [&](size_t i) { table.insert(keys[i]); });
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  REPORT_OPS(n);
+}
+
+// The same inserts as hashtable_insert, done with insert_batch
+static void bench_hashtable_insert_batch(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::map(random_keys(n), [](long k) { return k & (std::numeric_limits<long>::max)(); });
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      parlay::hashtable<parlay::hash_numeric<long>> table(n, parlay::hash_numeric<long>{});
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(table.insert_batch(keys));
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  REPORT_OPS(n);
+}
+
+// Looks up n keys, half of which are present, in a hashtable holding
+// n keys, one at a time from a parallel loop (batch = 0) or with find_batch
+static void bench_hashtable_find(benchmark::State& state) {
+  size_t n = state.range(0);
+  bool batch = state.range(1);
+  auto keys = parlay::map(random_keys(2 * n), [](long k) { return k & (std::numeric_limits<long>::max)(); });
+  parlay::hashtable<parlay::hash_numeric<long>> table(n, parlay::hash_numeric<long>{});
+  table.insert_batch(parlay::tabulate(n, [&](size_t i) { return keys[2 * i]; }));
+  auto queries = parlay::to_sequence(keys.cut(0, n));
+  for (auto _ : state) {
+    if (batch) {
+      benchmark::DoNotOptimize(table.find_batch(queries));
+    } else {
+      auto found = parlay::tabulate(n, [&](size_t i) { return table.find(queries[i]); });
+      benchmark::DoNotOptimize(found);
+    }
+  }
+  REPORT_OPS(n);
+}
+
+// Inserts n keys into a swiss_hashtable of the same size as in hashtable_insert
+static void bench_swiss_insert(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::map(random_keys(n), [](long k) { return k & (std::numeric_limits<long>::max)(); });
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      parlay::swiss_hashtable<parlay::hash_numeric<long>> table(n, parlay::hash_numeric<long>{});
+      state.ResumeTiming();
+      parlay::parallel_for(0, n, [&](size_t i) { table.insert(keys[i]); });
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  REPORT_OPS(n);
+}
+
+// The same lookups as hashtable_find with batch = 0
+static void bench_swiss_find(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::map(random_keys(2 * n), [](long k) { return k & (std::numeric_limits<long>::max)(); });
+  parlay::swiss_hashtable<parlay::hash_numeric<long>> table(n, parlay::hash_numeric<long>{});
+  parlay::parallel_for(0, n, [&](size_t i) { table.insert(keys[2 * i]); });
+  for (auto _ : state) {
+    auto found = parlay::tabulate(n, [&](size_t i) { return table.find(keys[i]); });
+    benchmark::DoNotOptimize(found);
+  }
+  REPORT_OPS(n);
+}
+
+struct hash_string {
+  using eType = std::string;
+  using kType = std::string;
+  eType empty() { return ""; }
+  const kType& getKey(const eType& v) { return v; }
+  size_t hash(const kType& v) { return parlay::hash64(std::hash<std::string>{}(v)); }
+  int cmp(const kType& a, const kType& b) { return a.compare(b); }
+};
+
+// Looks up n string keys with long common prefixes, half of which are
+// present, in a swiss_hashtable holding n keys
+static void bench_swiss_find_string(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::tabulate(2 * n, [](size_t i) {
+    return std::string("https://example.com/some/long/path/") + std::to_string(parlay::hash64(i));
+  });
+  parlay::swiss_hashtable<hash_string> table(n, hash_string{});
+  parlay::parallel_for(0, n, [&](size_t i) { table.insert(keys[2 * i]); });
+  for (auto _ : state) {
+    auto found = parlay::reduce(parlay::delayed_tabulate(n, [&](size_t i) -> size_t {
+      return table.contains(keys[i]);
+    }));
+    benchmark::DoNotOptimize(found);
+  }
+  REPORT_OPS(n);
+}
+
+// The same lookups with a concurrent_hash_map, which is the only other
+// parlay table that can hold strings
+static void bench_find_string(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto keys = parlay::tabulate(2 * n, [](size_t i) {
+    return std::string("https://example.com/some/long/path/") + std::to_string(parlay::hash64(i));
+  });
+  parlay::concurrent_hash_map<std::string, int> map(n);
+  parlay::parallel_for(0, n, [&](size_t i) { map.insert(keys[2 * i], 0); });
+  for (auto _ : state) {
+    auto found = parlay::reduce(parlay::delayed_tabulate(n, [&](size_t i) -> size_t {
+      return map.contains(keys[i]);
+    }));
+    benchmark::DoNotOptimize(found);
+  }
+  REPORT_OPS(n);
+}
+
+// ------------------------- Registration -------------------------------
+
+#define BENCH(NAME, ...) BENCHMARK(bench_ ## NAME)                                  \
+                          ->UseRealTime()                                           \
+                          ->Unit(benchmark::kMillisecond)                           \
+                          ->Args({__VA_ARGS__});
+
+// If compiling in debug mode, use 1000x smaller inputs
+// or they will run forever or run out of RAM
+#ifndef NDEBUG
+#define PSIZE_FACTOR 1000
+#else
+#define PSIZE_FACTOR 1
+#endif
+
+BENCH(insert_grow, 10000000/PSIZE_FACTOR);
+BENCH(insert_reserved, 10000000/PSIZE_FACTOR);
+BENCH(hashtable_insert, 10000000/PSIZE_FACTOR);
+BENCH(hashtable_insert_batch, 10000000/PSIZE_FACTOR);
+BENCH(hashtable_find, 10000000/PSIZE_FACTOR, 0);
+BENCH(hashtable_find, 10000000/PSIZE_FACTOR, 1);
+BENCH(swiss_insert, 10000000/PSIZE_FACTOR);
+BENCH(swiss_find, 10000000/PSIZE_FACTOR);
+BENCH(swiss_find_string, 1000000/PSIZE_FACTOR);
+BENCH(find_string, 1000000/PSIZE_FACTOR);
+BENCH(find, 10000000/PSIZE_FACTOR, 25);
+BENCH(find, 10000000/PSIZE_FACTOR, 50);
+BENCH(find, 10000000/PSIZE_FACTOR, 100);
+BENCH(find, 10000000/PSIZE_FACTOR, 200);
+BENCH(mixed, 10000000/PSIZE_FACTOR, 0);
+BENCH(mixed, 10000000/PSIZE_FACTOR, 10);
+BENCH(mixed, 10000000/PSIZE_FACTOR, 50);
+BENCH(mixed, 10000000/PSIZE_FACTOR, 100);
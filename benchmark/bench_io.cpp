@@ -0,0 +1,349 @@
+// Benchmarks of loading files into memory and writing them out. The input
+// file is written once per size into the temporary directory and reused by
+// every benchmark, so unless the page cache is dropped between runs these
+// measure reads from the page cache rather than from the device, except for
+// bench_file_map_modes, which evicts the file before each iteration.
+
+#include <cstdio>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <parlay/binary_io.h>
+#include <parlay/csv.h>
+#include <parlay/io.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+using benchmark::Counter;
+
+#define REPORT_BYTES(n)                                                                  \
+  state.counters["       Bytes/sec"] = Counter(state.iterations()*(n), Counter::kIsRate);
+
+// A file of n pseudo-random letters, removed at exit
+static const std::string& test_file(size_t n) {
+  struct file_guard {
+    std::string name;
+    explicit file_guard(size_t n) {
+      name = (std::filesystem::temp_directory_path() / ("parlay_bench_io_" + std::to_string(n))).string();
+      auto contents = parlay::tabulate(n, [](size_t i) -> char { return 'a' + parlay::hash64(i) % 26; });
+      std::ofstream out(name, std::ios::binary);
+      out.write(contents.data(), static_cast<std::streamsize>(n));
+    }
+    ~file_guard() { std::remove(name.c_str()); }
+  };
+  static file_guard guard(n);
+  return guard.name;
+}
+
+static void bench_chars_from_file(benchmark::State& state) {
+  size_t n = state.range(0);
+  const auto& name = test_file(n);
+  for (auto _ : state) {
+    auto s = parlay::chars_from_file(name);
+    benchmark::DoNotOptimize(s.data());
+  }
+  REPORT_BYTES(n);
+}
+
+static void bench_chars_from_file_parallel(benchmark::State& state) {
+  size_t n = state.range(0);
+  const auto& name = test_file(n);
+  parlay::file_read_options options;
+  options.block_size = state.range(1);
+  options.first_touch = state.range(2);
+  for (auto _ : state) {
+    auto s = parlay::chars_from_file_parallel(name, false, 0, 0, options);
+    benchmark::DoNotOptimize(s.data());
+  }
+  REPORT_BYTES(n);
+}
+
+static void bench_chars_from_file_direct(benchmark::State& state) {
+  size_t n = state.range(0);
+  const auto& name = test_file(n);
+  parlay::file_read_options options;
+  options.block_size = state.range(1);
+  options.direct_io = true;
+  for (auto _ : state) {
+    auto s = parlay::chars_from_file_parallel(name, false, 0, 0, options);
+    benchmark::DoNotOptimize(s.data());
+  }
+  REPORT_BYTES(n);
+}
+
+// Maps the file and copies it into a sequence in parallel
+static void bench_file_map_copy(benchmark::State& state) {
+  size_t n = state.range(0);
+  const auto& name = test_file(n);
+  for (auto _ : state) {
+    parlay::file_map f(name);
+    auto s = parlay::to_sequence(f);
+    benchmark::DoNotOptimize(s.data());
+  }
+  REPORT_BYTES(n);
+}
+
+// Maps the file with the options given by the second argument, then
+// counts one letter with reduce (if the third argument is 0) or computes
+// the lengths of the words separated by it with map_tokens (if it is 1).
+// The options are 0: none, 1: sequential access and will need, 2: populate
+// while mapping, 3: prefault in parallel, and 4: transparent huge pages.
+// Drops the file from the page cache, so that the next map of it reads
+// from the device. Only supported on Linux, elsewhere it does nothing.
+static void evict_from_page_cache(const std::string& name) {
+#if defined(__linux__)
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+#else
+  (void)name;
+#endif
+}
+
+// Compares the options of file_map on a cold cache, which is what they
+// differ on: the file is evicted from the page cache before each iteration
+static void bench_file_map_modes(benchmark::State& state) {
+  size_t n = state.range(0);
+  const auto& name = test_file(n);
+  parlay::file_map_options options;
+  switch (state.range(1)) {
+    case 1: options.access = parlay::file_map_options::access_pattern::sequential; options.will_need = true; break;
+    case 2: options.prefault = parlay::file_map_options::prefault_mode::populate; break;
+    case 3: options.prefault = parlay::file_map_options::prefault_mode::parallel; break;
+    case 4: options.huge_pages = true; break;
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    evict_from_page_cache(name);
+    state.ResumeTiming();
+    parlay::file_map f(name, options);
+    if (state.range(2) == 0) {
+      auto count = parlay::reduce(parlay::delayed_map(f, [](char c) -> size_t { return c == 'e'; }));
+      benchmark::DoNotOptimize(count);
+    }
+    else {
+      auto lengths = parlay::map_tokens(f, [](auto&& w) { return w.size(); }, [](char c) { return c == 'e'; });
+      benchmark::DoNotOptimize(lengths.data());
+    }
+  }
+  REPORT_BYTES(n);
+}
+
+static std::string output_file() {
+  return (std::filesystem::temp_directory_path() / "parlay_bench_io_out").string();
+}
+
+static void bench_chars_to_file(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto s = parlay::tabulate(n, [](size_t i) -> char { return 'a' + parlay::hash64(i) % 26; });
+  auto name = output_file();
+  for (auto _ : state) {
+    parlay::chars_to_file(s, name);
+  }
+  std::remove(name.c_str());
+  REPORT_BYTES(n);
+}
+
+static void bench_chars_to_file_parallel(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto s = parlay::tabulate(n, [](size_t i) -> char { return 'a' + parlay::hash64(i) % 26; });
+  auto name = output_file();
+  for (auto _ : state) {
+    parlay::chars_to_file_parallel(s, name, state.range(1));
+  }
+  std::remove(name.c_str());
+  REPORT_BYTES(n);
+}
+
+// Formats integers one per line via to_chars and flatten, then writes
+static void bench_format_flatten(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto a = parlay::tabulate(n, [](size_t i) { return static_cast<long>(parlay::hash64(i) >> 20); });
+  auto name = output_file();
+  for (auto _ : state) {
+    auto out = parlay::flatten(parlay::map(a, [](long x) {
+      auto c = parlay::to_chars(x);
+      c.push_back('\n');
+      return c;
+    }));
+    parlay::chars_to_file(out, name);
+  }
+  std::remove(name.c_str());
+  state.counters["       Elements/sec"] = Counter(state.iterations()*n, Counter::kIsRate);
+}
+
+static void bench_format_to_file(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto a = parlay::tabulate(n, [](size_t i) { return static_cast<long>(parlay::hash64(i) >> 20); });
+  auto name = output_file();
+  for (auto _ : state) {
+    parlay::format_to_file(a, name);
+  }
+  std::remove(name.c_str());
+  state.counters["       Elements/sec"] = Counter(state.iterations()*n, Counter::kIsRate);
+}
+
+// Reads a CSV file of n records, each an integer, a string that is quoted
+// every few records (sometimes around a newline) and a floating point number
+static void bench_read_csv(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto name = output_file();
+  auto text = parlay::flatten(parlay::tabulate(n, [](size_t i) {
+    auto h = parlay::hash64(i);
+    std::string r = std::to_string(h >> 40) + ",";
+    if (h % 8 == 0) r += "\"name " + std::to_string(i) + (h % 16 == 0 ? "\n" : ", ") + "x\"";
+    else r += "name" + std::to_string(i);
+    r += "," + std::to_string(static_cast<double>(h % 1000000) / 1000) + "\n";
+    return parlay::chars(r.begin(), r.end());
+  }));
+  parlay::chars_to_file(text, name);
+  for (auto _ : state) {
+    auto t = parlay::read_csv<long, parlay::chars, double>(name, {',', '"', false});
+    benchmark::DoNotOptimize(t);
+  }
+  std::remove(name.c_str());
+  REPORT_BYTES(text.size());
+}
+
+// Formats n longs (or doubles if the second argument is 1) separated by
+// spaces in memory, via to_chars and flatten or via format_range
+template<typename F>
+static void bench_format_numbers(benchmark::State& state, F&& format) {
+  size_t n = state.range(0);
+  auto h = parlay::tabulate(n, [](size_t i) { return parlay::hash64(i); });
+  if (state.range(1) == 0) {
+    auto a = parlay::map(h, [](uint64_t x) { return static_cast<long>(x >> 20); });
+    for (auto _ : state) benchmark::DoNotOptimize(format(a));
+  }
+  else {
+    auto a = parlay::map(h, [](uint64_t x) { return static_cast<double>(x >> 11) / (1 << (x % 30)); });
+    for (auto _ : state) benchmark::DoNotOptimize(format(a));
+  }
+  state.counters["       Elements/sec"] = Counter(state.iterations()*n, Counter::kIsRate);
+}
+
+static void bench_format_map_flatten(benchmark::State& state) {
+  bench_format_numbers(state, [](const auto& a) {
+    return parlay::flatten(parlay::map(a, [](auto x) {
+      auto c = parlay::to_chars(x);
+      c.push_back(' ');
+      return c;
+    }));
+  });
+}
+
+static void bench_format_range(benchmark::State& state) {
+  bench_format_numbers(state, [](const auto& a) { return parlay::format_range(a); });
+}
+
+// A graph in adjacency list form with n vertices of pseudo-random degree
+// averaging 10, as used by the graph examples
+static parlay::sequence<parlay::sequence<int>> test_graph(size_t n) {
+  return parlay::tabulate(n, [&](size_t i) {
+    return parlay::tabulate(parlay::hash64(i) % 21, [&](size_t j) {
+      return static_cast<int>(parlay::hash64(i * 21 + j) % n); });
+  });
+}
+
+static void bench_write_binary_graph(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto G = test_graph(n);
+  auto name = output_file();
+  for (auto _ : state) {
+    parlay::write_binary(G, name);
+  }
+  std::remove(name.c_str());
+  state.counters["       Vertices/sec"] = Counter(state.iterations()*n, Counter::kIsRate);
+}
+
+// Loads a graph saved with write_binary by copying it into nested
+// sequences (if the second argument is 0) or by mapping it (if it is 1),
+// then sums the degrees
+static void bench_read_binary_graph(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto name = output_file();
+  parlay::write_binary(test_graph(n), name);
+  for (auto _ : state) {
+    if (state.range(1) == 0) {
+      auto G = parlay::read_binary<parlay::sequence<int>>(name);
+      benchmark::DoNotOptimize(parlay::reduce(parlay::map(G, parlay::size_of())));
+    }
+    else {
+      auto G = parlay::map_binary<parlay::sequence<int>>(name);
+      benchmark::DoNotOptimize(parlay::reduce(parlay::map(G, parlay::size_of())));
+    }
+  }
+  std::remove(name.c_str());
+  state.counters["       Vertices/sec"] = Counter(state.iterations()*n, Counter::kIsRate);
+}
+
+// Counts the lines of a file of n bytes, streaming it in chunks of the
+// size given by the second argument with for_each_line_chunk, or (if it is
+// 0) reading it in whole with chars_from_file_parallel
+static void bench_count_lines(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto name = output_file();
+  parlay::chars_to_file(parlay::tabulate(n, [](size_t i) -> char {
+    return (parlay::hash64(i) % 64 == 0) ? '\n' : 'a' + i % 26; }), name);
+  size_t chunk_size = state.range(1);
+  for (auto _ : state) {
+    size_t lines = 0;
+    if (chunk_size == 0) {
+      lines = parlay::count(parlay::chars_from_file_parallel(name), '\n');
+    }
+    else {
+      parlay::for_each_line_chunk(name, [&](auto chunk) { lines += parlay::count(chunk, '\n'); }, chunk_size);
+    }
+    benchmark::DoNotOptimize(lines);
+  }
+  std::remove(name.c_str());
+  REPORT_BYTES(n);
+}
+
+constexpr long file_size = 1L << 30;
+
+#define BENCH_IO(NAME, ...) BENCHMARK(bench_ ## NAME)                               \
+                          ->UseRealTime()                                           \
+                          ->MeasureProcessCPUTime()                                 \
+                          ->Unit(benchmark::kMillisecond)                           \
+                          ->Args({__VA_ARGS__});
+
+BENCH_IO(chars_from_file, file_size);
+BENCH_IO(chars_from_file_parallel, file_size, 1L << 20, 0);
+BENCH_IO(chars_from_file_parallel, file_size, 1L << 22, 0);
+BENCH_IO(chars_from_file_parallel, file_size, 1L << 22, 1);
+BENCH_IO(chars_from_file_direct, file_size, 1L << 22);
+BENCH_IO(file_map_copy, file_size);
+BENCH_IO(file_map_modes, file_size, 0, 0);
+BENCH_IO(file_map_modes, file_size, 1, 0);
+BENCH_IO(file_map_modes, file_size, 2, 0);
+BENCH_IO(file_map_modes, file_size, 3, 0);
+BENCH_IO(file_map_modes, file_size, 4, 0);
+BENCH_IO(file_map_modes, file_size, 0, 1);
+BENCH_IO(file_map_modes, file_size, 3, 1);
+BENCH_IO(chars_to_file, file_size);
+BENCH_IO(chars_to_file_parallel, file_size, 1L << 22);
+BENCH_IO(format_flatten, 100000000);
+BENCH_IO(format_to_file, 100000000);
+BENCH_IO(format_map_flatten, 20000000, 0);
+BENCH_IO(format_map_flatten, 20000000, 1);
+BENCH_IO(format_range, 20000000, 0);
+BENCH_IO(format_range, 20000000, 1);
+BENCH_IO(read_csv, 20000000);
+BENCH_IO(count_lines, file_size, 0);
+BENCH_IO(count_lines, file_size, 1L << 24);
+BENCH_IO(count_lines, file_size, 1L << 26);
+BENCH_IO(write_binary_graph, 10000000);
+BENCH_IO(read_binary_graph, 10000000, 0);
+BENCH_IO(read_binary_graph, 10000000, 1);
@@ -3,6 +3,9 @@
 
 #include <cctype>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include <iomanip>
 #include <limits>
@@ -11,6 +14,8 @@
 #include <benchmark/benchmark.h>
 
 #include <parlay/io.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
 
 
 template<typename T>
@@ -180,6 +185,64 @@ static void bench_chars_to_long_double_slowpath(benchmark::State& state) {
   }
 }
 
+// ------------------------- Many numbers -------------------------------
+
+// n random numbers of type T, whitespace separated.  Doubles are printed
+// with all 17 significant digits, so most of them are not exactly
+// representable from their digits and need more than the fast path.
+template<typename T>
+parlay::chars number_text(size_t n) {
+  return parlay::flatten(parlay::tabulate(n, [](size_t i) {
+    char buf[32];
+    uint64_t h = parlay::hash64(i);
+    int len;
+    if constexpr (std::is_integral_v<T>) len = std::snprintf(buf, sizeof(buf), "%ld", static_cast<long>(h) >> (h % 48));
+    else len = std::snprintf(buf, sizeof(buf), "%.17g", static_cast<double>(h >> 11) / (1 << (h % 40)));
+    buf[len] = ' ';
+    return parlay::chars(buf, buf + len + 1);
+  }));
+}
+
+template<typename T>
+static void bench_parse_numbers(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto text = number_text<T>(n);
+  for (auto _ : state) {
+    auto result = parlay::parse_numbers<T>(text);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+// The same, by materializing the tokens and converting each with chars_to_*
+template<typename T>
+static void bench_tokens_chars_to(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto text = number_text<T>(n);
+  for (auto _ : state) {
+    auto result = parlay::map(parlay::tokens(text), [](const parlay::chars& s) {
+      if constexpr (std::is_integral_v<T>) return parlay::chars_to_long(s);
+      else return parlay::chars_to_double(s);
+    });
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+// The same, converting each token with strtol / strtod
+template<typename T>
+static void bench_tokens_strto(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto text = number_text<T>(n);
+  text.push_back(0);
+  for (auto _ : state) {
+    // the tokens are followed by a space or the null terminator
+    auto result = parlay::map_tokens(text.cut(0, text.size() - 1), [](auto s) {
+      if constexpr (std::is_integral_v<T>) return std::strtol(s.begin(), nullptr, 10);
+      else return std::strtod(s.begin(), nullptr);
+    });
+    benchmark::DoNotOptimize(result);
+  }
+}
+
 // ------------------------- Registration -------------------------------
 
 #define BENCH(NAME, T, ...) BENCHMARK_TEMPLATE(bench_ ## NAME, T)                   \
@@ -214,3 +277,9 @@ BENCH(chars_to_float_slowpath, float);
 BENCH(chars_to_double_slowpath, double);
 BENCH(chars_to_long_double_slowpath, long double);
 
+BENCH(parse_numbers, long, 10000000);
+BENCH(parse_numbers, double, 10000000);
+BENCH(tokens_chars_to, long, 10000000);
+BENCH(tokens_chars_to, double, 10000000);
+BENCH(tokens_strto, long, 10000000);
+BENCH(tokens_strto, double, 10000000);
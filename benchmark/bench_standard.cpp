@@ -2,6 +2,8 @@
 // The main set used to evaluate performance enhancements
 // to the library
 
+#include <cmath>
+
 #include <benchmark/benchmark.h>
 
 #include <parlay/monoid.h>
@@ -347,6 +349,62 @@ void bench_sort<parlay::sequence<char>>(benchmark::State& state) {
   REPORT_STATS(n, 0, 0);
 }
 
+template<typename T>
+static void bench_string_sort(benchmark::State& state) {
+  size_t n = state.range(0);
+  ngram_table words;
+  auto in = parlay::tabulate(n, [&] (size_t i) -> T {return words.word(i);});
+
+  while (state.KeepRunningBatch(10)) {
+    for (int i = 0; i < 10; i++) {
+      RUN_AND_CLEAR(parlay::internal::string_sort(parlay::make_slice(in)));
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+// Keys with a Zipfian distribution (exponent about 1), so the smallest
+// few values make up a large fraction of the input
+template<typename T>
+static auto zipfian_keys(size_t n) {
+  parlay::random r(0);
+  return parlay::tabulate(n, [&] (size_t i) -> T {
+    double u = static_cast<double>(r.ith_rand(i) % (1 << 30)) / (1 << 30);
+    return static_cast<T>(std::pow(static_cast<double>(n), u)) - 1;
+  });
+}
+
+template<typename T>
+static void bench_sort_zipfian(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto in = zipfian_keys<T>(n);
+
+  while (state.KeepRunningBatch(10)) {
+    for (int i = 0; i < 10; i++) {
+      RUN_AND_CLEAR(parlay::internal::sample_sort(parlay::make_slice(in), std::less<T>()));
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_sort_inplace_zipfian(benchmark::State& state) {
+  size_t n = state.range(0);
+  auto in = zipfian_keys<T>(n);
+  auto out = in;
+
+  while (state.KeepRunningBatch(10)) {
+    for (int i = 0; i < 10; i++) {
+      COPY_NO_TIME(out, in);
+      parlay::internal::sample_sort_inplace(parlay::make_slice(out), std::less<T>());
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
 template<typename T>
 static void bench_sort_inplace(benchmark::State& state) {
   size_t n = state.range(0);
@@ -364,6 +422,39 @@ static void bench_sort_inplace(benchmark::State& state) {
   REPORT_STATS(n, 0, 0);
 }
 
+template<typename T>
+static void bench_top_k(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t k = state.range(1);
+  parlay::random r(0);
+  auto in = parlay::tabulate(n, [&] (size_t i) -> T { return r.ith_rand(i) % n; });
+
+  while (state.KeepRunningBatch(10)) {
+    for (int i = 0; i < 10; i++) {
+      RUN_AND_CLEAR(parlay::top_k(in, k));
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_nth_element_inplace(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  auto in = parlay::tabulate(n, [&] (size_t i) -> T { return r.ith_rand(i) % n; });
+  auto out = in;
+
+  while (state.KeepRunningBatch(10)) {
+    for (int i = 0; i < 10; i++) {
+      COPY_NO_TIME(out, in);
+      parlay::nth_element_inplace(out, n / 2);
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
 template<typename T>
 static void bench_merge(benchmark::State& state) {
   size_t n = state.range(0);
@@ -516,6 +607,41 @@ void bench_histogram_by_key<parlay::sequence<char>>(benchmark::State& state) {
   REPORT_STATS(n, 0, 0);
 }
 
+// Histograms of consecutive batches of a stream of words, with and
+// without reusing a bucket plan across the batches
+template<typename T>
+static void bench_histogram_by_key_stream(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t batch = 50000;
+  ngram_table words;
+  auto S = parlay::tabulate(n, [&] (size_t i) {return words.word(i);});
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < n; i += batch) {
+      RUN_AND_CLEAR(parlay::histogram_by_key(S.cut(i, (std::min)(n, i + batch))));
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_histogram_by_key_stream_plan(benchmark::State& state) {
+  size_t n = state.range(0);
+  size_t batch = 50000;
+  ngram_table words;
+  auto S = parlay::tabulate(n, [&] (size_t i) {return words.word(i);});
+
+  for (auto _ : state) {
+    parlay::bucket_plan<T> plan;
+    for (size_t i = 0; i < n; i += batch) {
+      RUN_AND_CLEAR(parlay::histogram_by_key(S.cut(i, (std::min)(n, i + batch)), plan));
+    }
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
 template<typename T>
 static void bench_remove_duplicates(benchmark::State& state) {
   size_t n = state.range(0);
@@ -591,6 +717,109 @@ static void bench_group_by_key_sorted(benchmark::State& state) {
   REPORT_STATS(n, 0, 0);
 }
 
+// joins a table of n/10 distinct keys with n foreign keys into it
+template<typename T>
+static void bench_hash_join(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  using par = std::pair<T,T>;
+  auto build = parlay::tabulate(n/10, [&] (size_t i) -> par {
+      return par(i, r.ith_rand(i));});
+  auto probe = parlay::tabulate(n, [&] (size_t i) -> par {
+      return par(r.ith_rand(n + i) % (n/5), i);});
+  auto key = [] (const par& p) {return p.first;};
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::hash_join_indices(build, probe, key, key));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_semi_join(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  using par = std::pair<T,T>;
+  auto build = parlay::tabulate(n/10, [&] (size_t i) -> par {
+      return par(i, r.ith_rand(i));});
+  auto probe = parlay::tabulate(n, [&] (size_t i) -> par {
+      return par(r.ith_rand(n + i) % (n/5), i);});
+  auto key = [] (const par& p) {return p.first;};
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::semi_join(probe, build, key, key));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+// joins two sorted sequences of n/2 keys each, with about one match per key
+template<typename T>
+static void bench_merge_join(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  auto a = parlay::sort(parlay::tabulate(n/2, [&] (size_t i) -> T {
+      return r.ith_rand(i) % n;}));
+  auto b = parlay::sort(parlay::tabulate(n/2, [&] (size_t i) -> T {
+      return r.ith_rand(n + i) % n;}));
+  auto key = [] (T x) {return x;};
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::merge_join_indices(a, b, key, key));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+// matches each of n/2 sorted timestamps with those within 1 of it among n/2 others
+template<typename T>
+static void bench_band_join(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  auto a = parlay::sort(parlay::tabulate(n/2, [&] (size_t i) -> T {
+      return r.ith_rand(i) % n;}));
+  auto b = parlay::sort(parlay::tabulate(n/2, [&] (size_t i) -> T {
+      return r.ith_rand(n + i) % n;}));
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::band_join_indices(a, b, T(-1), T(1)));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_group_by_key_flat(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  using par = std::pair<T,T>;
+  auto S = parlay::tabulate(n, [&] (size_t i) -> par {
+      return par(r.ith_rand(i) % (n/20), i);});
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::group_by_key_flat(S));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
+template<typename T>
+static void bench_group_by_index_flat(benchmark::State& state) {
+  size_t n = state.range(0);
+  parlay::random r(0);
+  using par = std::pair<T,T>;
+  T num_buckets = (n/20);
+  auto S = parlay::tabulate(n, [&] (size_t i) -> par {
+      return par(r.ith_rand(i) % num_buckets, i);});
+
+  for (auto _ : state) {
+    RUN_AND_CLEAR(parlay::group_by_index_flat(S, num_buckets));
+  }
+
+  REPORT_STATS(n, 0, 0);
+}
+
 template<typename T>
 static void bench_group_by_index(benchmark::State& state) {
   size_t n = state.range(0);
@@ -655,8 +884,13 @@ BENCH(integer_sort_pair, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(sort, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(sort, long, 100000000/PSIZE_FACTOR);
 BENCH(sort, parlay::sequence<char>, 100000000/PSIZE_FACTOR);
+BENCH(string_sort, parlay::sequence<char>, 100000000/PSIZE_FACTOR);
 BENCH(sort_inplace, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(sort_inplace, long, 100000000/PSIZE_FACTOR);
+BENCH(sort_zipfian, long, 100000000/PSIZE_FACTOR);
+BENCH(sort_inplace_zipfian, long, 100000000/PSIZE_FACTOR);
+BENCH(top_k, long, 100000000/PSIZE_FACTOR, 1000);
+BENCH(nth_element_inplace, long, 100000000/PSIZE_FACTOR);
 BENCH(merge, long, 100000000/PSIZE_FACTOR);
 BENCH(merge_sort, long, 100000000/PSIZE_FACTOR);
 BENCH(quicksort, long, 100000000/PSIZE_FACTOR);
@@ -669,6 +903,7 @@ BENCH(reduce_by_index, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(remove_duplicate_integers, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(group_by_index_256, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(group_by_index, unsigned int, 100000000/PSIZE_FACTOR);
+BENCH(group_by_index_flat, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(reduce_by_key, unsigned long, 100000000/PSIZE_FACTOR);
 BENCH(histogram_by_key, unsigned long, 100000000/PSIZE_FACTOR);
 BENCH(histogram_by_key, unsigned int, 100000000/PSIZE_FACTOR);
@@ -676,9 +911,17 @@ BENCH(remove_duplicates, unsigned long, 100000000/PSIZE_FACTOR);
 BENCH(remove_duplicates, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(group_by_key, unsigned long, 100000000/PSIZE_FACTOR);
 BENCH(group_by_key, unsigned int, 100000000/PSIZE_FACTOR);
+BENCH(group_by_key_flat, unsigned long, 100000000/PSIZE_FACTOR);
+BENCH(group_by_key_flat, unsigned int, 100000000/PSIZE_FACTOR);
 BENCH(group_by_key_sorted, unsigned long, 100000000/PSIZE_FACTOR);
 BENCH(group_by_key_sorted, unsigned int, 100000000/PSIZE_FACTOR);
+BENCH(hash_join, unsigned long, 100000000/PSIZE_FACTOR);
+BENCH(semi_join, unsigned long, 100000000/PSIZE_FACTOR);
+BENCH(merge_join, long, 100000000/PSIZE_FACTOR);
+BENCH(band_join, long, 100000000/PSIZE_FACTOR);
 BENCH(histogram_by_key, parlay::sequence<char>, 100000000/PSIZE_FACTOR);
+BENCH(histogram_by_key_stream, parlay::sequence<char>, 10000000/PSIZE_FACTOR);
+BENCH(histogram_by_key_stream_plan, parlay::sequence<char>, 10000000/PSIZE_FACTOR);
 BENCH(remove_duplicates, parlay::sequence<char>, 100000000/PSIZE_FACTOR);
 BENCH(group_by_key, parlay::sequence<char>, 100000000/PSIZE_FACTOR);
 
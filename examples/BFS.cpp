@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 
+#include <parlay/binary_io.h>
 #include <parlay/primitives.h>
 #include <parlay/sequence.h>
 #include <parlay/internal/get_time.h>
@@ -16,29 +17,45 @@ using nested_seq = parlay::sequence<parlay::sequence<vertex>>;
 using graph = nested_seq;
 using utils = graph_utils<vertex>;
 
+template <typename graph_type>
+void run_BFS(const graph_type& G) {
+  nested_seq result;
+  parlay::internal::timer t("Time");
+  for (int i=0; i < 3; i++) {
+    result = BFS(1, G);
+    t.next("BFS");
+  }
+
+  long visited = parlay::reduce(parlay::map(result, parlay::size_of()));
+  std::cout << "num vertices visited: " << visited << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-  auto usage = "Usage: BFS <n> || BFS <filename>";
-  if (argc != 2) std::cout << usage << std::endl;
+  auto usage = "Usage: BFS <n> [<filename>.bin] || BFS <filename>";
+  if (argc != 2 && argc != 3) std::cout << usage << std::endl;
   else {
     long n = 0;
     graph G;
     try { n = std::stol(argv[1]); }
     catch (...) {}
+    if (n == 0 && utils::is_binary_file(argv[1])) {
+      // search the saved graph in place, without reading it in
+      parlay::internal::timer t("Time");
+      auto GB = parlay::map_binary<parlay::sequence<vertex>>(argv[1]);
+      t.next("map graph");
+      std::cout << "num vertices = " << GB.size() << std::endl;
+      std::cout << "num edges    = " << GB.num_elements() << std::endl;
+      run_BFS(GB);
+      return 0;
+    }
     if (n == 0) {
       G = utils::read_symmetric_graph_from_file(argv[1]);
       n = G.size();
     } else {
       G = utils::rmat_graph(n, 20*n);
+      if (argc == 3) utils::write_graph_to_binary_file(G, argv[2]);
     }
     utils::print_graph_stats(G);
-    nested_seq result;
-    parlay::internal::timer t("Time");
-    for (int i=0; i < 3; i++) {
-      result = BFS(1, G);
-      t.next("BFS");
-    }
-
-    long visited = parlay::reduce(parlay::map(result, parlay::size_of()));
-    std::cout << "num vertices visited: " << visited << std::endl;
+    run_BFS(G);
   }
 }
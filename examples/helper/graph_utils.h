@@ -3,6 +3,7 @@
 #include <parlay/primitives.h>
 #include <parlay/sequence.h>
 #include <parlay/io.h>
+#include <parlay/binary_io.h>
 
 template <typename vertex>
 struct graph_utils {
@@ -47,8 +48,8 @@ struct graph_utils {
   static graph symmetrize(const edges& Ein, long n) {
     auto E = filter(Ein, [] (auto e) {return e.first != e.second;});
     auto ET = map(E, [] (auto e) {return std::pair(e.second, e.first);});
-    auto G = group_by_index(E, n);
-    auto GT = group_by_index(ET, n);
+    auto G = group_by_index_flat(E, n);
+    auto GT = group_by_index_flat(ET, n);
     return parlay::tabulate(n, [&] (long i) {
       return remove_duplicates(append(G[i],GT[i]));});
   }
@@ -192,7 +193,9 @@ struct graph_utils {
     });
   }
 
+  // a file ending in .bin is loaded as saved by write_graph_to_binary_file
   static graph read_graph_from_file(const std::string& filename) {
+    if (is_binary_file(filename)) return read_graph_from_binary_file(filename);
     auto str = parlay::file_map(filename);
     auto tokens = parlay::tokens(str, [] (char c) {return c == '\n' || c == ' ';});
     long n = parlay::chars_to_long(tokens[0]);
@@ -213,8 +216,26 @@ struct graph_utils {
       return scan_inclusive(edges.cut(o[i], o[i]+lengths[i]));});
   }
 
-  // assumes each edge is kept in just one direction, so copied into other
+  // files with this suffix hold a graph saved by write_graph_to_binary_file
+  static bool is_binary_file(const std::string& filename) {
+    std::string suffix = ".bin";
+    return filename.size() >= suffix.size() &&
+      filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  // saves the graph as is, so it loads back without parsing or symmetrizing
+  static void write_graph_to_binary_file(const graph& G, const std::string& filename) {
+    parlay::write_binary(G, filename);
+  }
+
+  static graph read_graph_from_binary_file(const std::string& filename) {
+    return parlay::read_binary<vertices>(filename);
+  }
+
+  // assumes each edge is kept in just one direction, so copied into other,
+  // unless it is a binary file, which holds the graph as it was saved
   static graph read_symmetric_graph_from_file(const std::string& filename) {
+    if (is_binary_file(filename)) return read_graph_from_binary_file(filename);
     auto G = read_graph_from_file(filename);
     auto GT = transpose(G);
     return  parlay::tabulate(G.size(), [&] (long i) {
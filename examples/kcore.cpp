@@ -16,8 +16,8 @@ int main(int argc, char* argv[]) {
   using graph = parlay::sequence<parlay::sequence<vertex>>;
   using utils = graph_utils<vertex>;
 
-  auto usage = "Usage: kcore <n> || kcore <filename>";
-  if (argc != 2) std::cout << usage << std::endl;
+  auto usage = "Usage: kcore <n> [<filename>.bin] || kcore <filename>";
+  if (argc != 2 && argc != 3) std::cout << usage << std::endl;
   else {
     long n = 0;
     graph G;
@@ -28,6 +28,7 @@ int main(int argc, char* argv[]) {
       n = G.size();
     } else {
       G = utils::rmat_symmetric_graph(n, 20*n);
+      if (argc == 3) utils::write_graph_to_binary_file(G, argv[2]);
     }
     utils::print_graph_stats(G);
     parlay::internal::timer t("Time");
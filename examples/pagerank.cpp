@@ -23,8 +23,8 @@ int main(int argc, char* argv[]) {
 
   using utils = graph_utils<vertex>;
 
-  auto usage = "Usage: pagerank <n> || pagerank <filename>";
-  if (argc != 2) std::cout << usage << std::endl;
+  auto usage = "Usage: pagerank <n> [<filename>.bin] || pagerank <filename>";
+  if (argc != 2 && argc != 3) std::cout << usage << std::endl;
   else {
     long n = 0;
     graph G;
@@ -35,6 +35,7 @@ int main(int argc, char* argv[]) {
       n = G.size();
     } else {
       G = utils::rmat_graph(n, 20*n);
+      if (argc == 3) utils::write_graph_to_binary_file(G, argv[2]);
     }
     utils::print_graph_stats(G);
     sparse_matrix M = utils::to_normalized_matrix(G);
@@ -0,0 +1,256 @@
+// Incremental versions of reduce_by_key and histogram_by_key, which
+// maintain the aggregate of a stream of batches without rescanning the
+// batches that were added before.
+//
+// The aggregate is split into shards by the hash of the key, each of which
+// holds a small hash table. A batch is first reduced on its own with
+// reduce_by_key (or counted with histogram_by_key), so that each of its
+// distinct keys is merged into the state once, and the reduced batch is
+// then partitioned by shard with a counting sort and merged into all of
+// the shards in parallel.
+//
+// Shards are shared between the aggregator and its snapshots, and are
+// copied on write, so taking a snapshot costs time proportional to the
+// number of shards, and adding a batch afterwards only copies the shards
+// that the batch touches.
+
+#ifndef PARLAY_AGGREGATOR_H_
+#define PARLAY_AGGREGATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "internal/counting_sort.h"
+#include "internal/group_by.h"
+
+#include "delayed_sequence.h"
+#include "monoid.h"
+#include "parallel.h"
+#include "primitives.h"
+#include "range.h"
+#include "sequence.h"
+#include "utilities.h"
+
+namespace parlay {
+namespace internal {
+
+// The shard, out of 2^bits, that holds the keys with hash h, taken from its
+// high bits.  Zero bits means a single shard.
+inline size_t aggregator_shard_of(size_t h, size_t bits) {
+  return bits == 0 ? 0 : h >> (64 - bits);
+}
+
+// A sequential hash table from keys to values, which keeps its entries
+// contiguous so that they can be listed cheaply. The table maps hashes to
+// positions in the entries.
+template <typename K, typename V, typename Hash, typename Equal>
+struct aggregator_shard {
+  static constexpr uint32_t empty = (std::numeric_limits<uint32_t>::max)();
+
+  sequence<std::pair<K, V>> entries;
+  sequence<uint32_t> table;
+
+  // Combines v into the value of key k with f, or inserts it if k is new
+  template <typename F>
+  void add(size_t h, const K& k, const V& v, const F& f, const Hash& hash, const Equal& equal) {
+    if (2 * (entries.size() + 1) > table.size()) grow(hash);
+    size_t mask = table.size() - 1;
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+      uint32_t j = table[i];
+      if (j == empty) {
+        table[i] = static_cast<uint32_t>(entries.size());
+        entries.emplace_back(k, v);
+        return;
+      }
+      if (equal(entries[j].first, k)) {
+        entries[j].second = f(entries[j].second, v);
+        return;
+      }
+    }
+  }
+
+  const V* find(size_t h, const K& k, const Equal& equal) const {
+    if (table.empty()) return nullptr;
+    size_t mask = table.size() - 1;
+    for (size_t i = h & mask; ; i = (i + 1) & mask) {
+      uint32_t j = table[i];
+      if (j == empty) return nullptr;
+      if (equal(entries[j].first, k)) return &entries[j].second;
+    }
+  }
+
+  void grow(const Hash& hash) {
+    size_t m = (std::max)(size_t{16}, 2 * table.size());
+    table = sequence<uint32_t>(m, empty);
+    for (size_t j = 0; j < entries.size(); j++) {
+      size_t i = hash64_2(hash(entries[j].first)) & (m - 1);
+      while (table[i] != empty) i = (i + 1) & (m - 1);
+      table[i] = static_cast<uint32_t>(j);
+    }
+  }
+};
+
+}  // namespace internal
+
+// The state of a reduce_by_key_aggregator at the time it was taken. It is
+// not affected by batches that are added to the aggregator later, and it
+// can be read concurrently with them.
+template <typename K, typename V, typename Hash = parlay::hash<K>, typename Equal = std::equal_to<>>
+class aggregate_snapshot {
+  using shard = internal::aggregator_shard<K, V, Hash, Equal>;
+
+ public:
+  aggregate_snapshot(sequence<std::shared_ptr<const shard>> shards_, size_t size_,
+                     size_t shard_bits_, Hash hash_, Equal equal_)
+      : shards(std::move(shards_)), num_entries(size_), shard_bits(shard_bits_),
+        hash(std::move(hash_)), equal(std::move(equal_)) { }
+
+  // The number of distinct keys
+  size_t size() const { return num_entries; }
+
+  // The aggregated value of key k, if k has appeared
+  std::optional<V> find(const K& k) const {
+    size_t h = hash64_2(hash(k));
+    const V* v = shards[internal::aggregator_shard_of(h, shard_bits)]->find(h, k, equal);
+    return v ? std::optional<V>(*v) : std::nullopt;
+  }
+
+  // All of the (key, value) pairs, in an arbitrary order
+  sequence<std::pair<K, V>> entries() const {
+    return flatten(delayed_map(shards, [](const auto& s) -> const auto& { return s->entries; }));
+  }
+
+ private:
+  sequence<std::shared_ptr<const shard>> shards;
+  size_t num_entries;
+  size_t shard_bits;
+  Hash hash;
+  Equal equal;
+};
+
+// Maintains the result of reduce_by_key over all of the batches of
+// (key, value) pairs added to it. Values are combined with a monoid,
+// which must be on the value type. Adding batches and taking snapshots
+// must not happen concurrently with each other.
+template <typename K, typename V,
+          typename Monoid = parlay::plus<V>,
+          typename Hash = parlay::hash<K>,
+          typename Equal = std::equal_to<>>
+class reduce_by_key_aggregator {
+  using shard = internal::aggregator_shard<K, V, Hash, Equal>;
+
+ public:
+  using snapshot_type = aggregate_snapshot<K, V, Hash, Equal>;
+
+  // The state is split into 2^shard_bits shards, which is the granularity
+  // of both parallelism and copying on write.  shard_bits must be less
+  // than 32.
+  explicit reduce_by_key_aggregator(Monoid monoid_ = {}, Hash hash_ = {}, Equal equal_ = {},
+                                    size_t shard_bits_ = 8)
+      : monoid(std::move(monoid_)), hash(std::move(hash_)), equal(std::move(equal_)),
+        shard_bits(checked_shard_bits(shard_bits_)),
+        shards(sequence<std::shared_ptr<shard>>::from_function(size_t{1} << shard_bits_, [](size_t) {
+          return std::make_shared<shard>();
+        })) { }
+
+  // Adds a batch of (key, value) pairs
+  template <typename R>
+  void add_batch(R&& batch) {
+    static_assert(is_random_access_range_v<R>);
+    static_assert(is_pair_v<range_value_type_t<R>>);
+    add_reduced(parlay::reduce_by_key(std::forward<R>(batch), monoid, hash, equal));
+  }
+
+  // The number of distinct keys added so far
+  size_t size() const { return num_entries; }
+
+  // The aggregated value of key k, if k has been added
+  std::optional<V> find(const K& k) const {
+    size_t h = hash64_2(hash(k));
+    const V* v = shards[internal::aggregator_shard_of(h, shard_bits)]->find(h, k, equal);
+    return v ? std::optional<V>(*v) : std::nullopt;
+  }
+
+  // All of the (key, value) pairs, in an arbitrary order
+  sequence<std::pair<K, V>> entries() const { return snapshot().entries(); }
+
+  // Returns a read-only copy of the current state, which shares all of
+  // the shards until more batches are added
+  snapshot_type snapshot() const {
+    auto s = map(shards, [](const auto& p) { return std::shared_ptr<const shard>(p); });
+    return snapshot_type(std::move(s), num_entries, shard_bits, hash, equal);
+  }
+
+ protected:
+  // Merges pairs with distinct keys into the state
+  void add_reduced(sequence<std::pair<K, V>> pairs) {
+    size_t num_shards = shards.size();
+    auto hashes = map(pairs, [&](const auto& kv) { return static_cast<size_t>(hash64_2(hash(kv.first))); });
+    auto ids = map(hashes, [&](size_t h) { return internal::aggregator_shard_of(h, shard_bits); });
+    auto positions = tabulate(pairs.size(), [](size_t i) { return i; });
+    auto sorted = internal::count_sort(make_slice(positions), ids, num_shards);
+    auto& order = sorted.first;
+    auto& offsets = sorted.second;
+    auto added = tabulate(num_shards, [&](size_t s) -> size_t {
+      size_t start = offsets[s], end = offsets[s + 1];
+      if (start == end) return 0;
+      // copy the shard if a snapshot is still using it
+      if (shards[s].use_count() > 1) shards[s] = std::make_shared<shard>(*shards[s]);
+      shard& sh = *shards[s];
+      size_t before = sh.entries.size();
+      for (size_t i = start; i < end; i++) {
+        const auto& [k, v] = pairs[order[i]];
+        sh.add(hashes[order[i]], k, v, monoid, hash, equal);
+      }
+      return sh.entries.size() - before;
+    }, 1);
+    num_entries += reduce(added);
+  }
+
+  Monoid monoid;
+  Hash hash;
+  Equal equal;
+
+ private:
+  static size_t checked_shard_bits(size_t bits) {
+    if (bits >= 32) throw std::invalid_argument("reduce_by_key_aggregator: shard_bits must be less than 32");
+    return bits;
+  }
+
+  size_t shard_bits;
+  sequence<std::shared_ptr<shard>> shards;
+  size_t num_entries = 0;
+};
+
+// Maintains the result of histogram_by_key over all of the batches of
+// keys added to it, i.e., the number of times that each key has appeared
+template <typename K, typename sum_type = size_t,
+          typename Hash = parlay::hash<K>,
+          typename Equal = std::equal_to<>>
+class histogram_by_key_aggregator : public reduce_by_key_aggregator<K, sum_type, parlay::plus<sum_type>, Hash, Equal> {
+  using base = reduce_by_key_aggregator<K, sum_type, parlay::plus<sum_type>, Hash, Equal>;
+
+ public:
+  explicit histogram_by_key_aggregator(Hash hash_ = {}, Equal equal_ = {}, size_t shard_bits_ = 8)
+      : base({}, std::move(hash_), std::move(equal_), shard_bits_) { }
+
+  // Adds a batch of keys
+  template <typename R>
+  void add_batch(R&& batch) {
+    static_assert(is_random_access_range_v<R>);
+    this->add_reduced(parlay::histogram_by_key<sum_type>(std::forward<R>(batch), this->hash, this->equal));
+  }
+};
+
+}  // namespace parlay
+
+#endif  // PARLAY_AGGREGATOR_H_
@@ -0,0 +1,296 @@
+// Saving sequences of plain values (scalars, and types such as pairs of
+// them that are trivially copy constructible and destructible), and
+// sequences of such sequences (e.g., graphs in adjacency list form), to
+// files in a compact binary format, and loading them back.
+//
+// A file consists of a 64-byte header, then for nested sequences an
+// offsets section of size()+1 64-bit offsets, where the elements of the
+// i'th inner sequence are those in [offsets[i], offsets[i+1]), and finally
+// the elements themselves, starting at a multiple of 64 bytes.  Values are
+// stored in the native layout of the machine, and the header records the
+// element size and byte order so that a file written elsewhere is rejected
+// rather than misread.
+//
+// Files are written in parallel through a writable file_map.  map_binary
+// loads a file without copying it: the result is a read-only view of the
+// elements in place in a file_map, which can be used like the sequence
+// that was saved.  read_binary copies the contents into a new sequence.
+
+#ifndef PARLAY_BINARY_IO_H_
+#define PARLAY_BINARY_IO_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_sequence.h"
+#include "io.h"
+#include "parallel.h"
+#include "primitives.h"
+#include "range.h"
+#include "sequence.h"
+#include "slice.h"
+
+namespace parlay {
+
+// Raised when loading a file that is not in the binary format, or that
+// holds elements of a different type or nesting than requested
+class binary_format_error : public std::runtime_error {
+ public:
+  explicit binary_format_error(const std::string& what)
+    : std::runtime_error(what) {}
+};
+
+namespace internal {
+
+// Whether values of type T can be saved as their bytes
+template<typename T>
+inline constexpr bool is_binary_storable_v = std::is_trivially_copy_constructible_v<T> &&
+                                             std::is_trivially_destructible_v<T>;
+
+struct binary_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t nested;          // whether the file holds a sequence of sequences
+  uint64_t element_size;
+  uint64_t byte_order;      // binary_byte_order as written by the machine
+  uint64_t size;            // the number of elements, or of inner sequences
+  uint64_t num_elements;    // the total number of elements
+  uint64_t data_offset;     // the position of the elements in the file
+  uint64_t reserved;
+};
+
+static_assert(sizeof(binary_header) == 64);
+
+constexpr char binary_magic[8] = {'P', 'A', 'R', 'L', 'A', 'Y', 'B', '\0'};
+constexpr uint32_t binary_version = 1;
+constexpr uint64_t binary_byte_order = 0x0102030405060708;
+constexpr size_t binary_alignment = 64;
+
+inline binary_header make_binary_header(bool nested, size_t element_size, size_t size, size_t num_elements) {
+  binary_header h{};
+  std::memcpy(h.magic, binary_magic, sizeof(binary_magic));
+  h.version = binary_version;
+  h.nested = nested;
+  h.element_size = element_size;
+  h.byte_order = binary_byte_order;
+  h.size = size;
+  h.num_elements = num_elements;
+  size_t offsets_end = sizeof(binary_header) + (nested ? (size + 1) * sizeof(uint64_t) : 0);
+  h.data_offset = (offsets_end + binary_alignment - 1) / binary_alignment * binary_alignment;
+  return h;
+}
+
+// Reads and checks the header of a mapped file
+inline binary_header read_binary_header(const file_map& f, bool nested, size_t element_size) {
+  binary_header h;
+  if (f.size() < sizeof(binary_header)) throw binary_format_error("file is too short for a header");
+  std::memcpy(&h, &*f.begin(), sizeof(binary_header));
+  if (std::memcmp(h.magic, binary_magic, sizeof(binary_magic)) != 0) throw binary_format_error("not a binary sequence file");
+  if (h.version != binary_version) throw binary_format_error("unsupported version " + std::to_string(h.version));
+  if (h.byte_order != binary_byte_order) throw binary_format_error("file was written with a different byte order");
+  if (h.nested != static_cast<uint32_t>(nested)) {
+    throw binary_format_error(h.nested ? "file holds a nested sequence" : "file holds a flat sequence");
+  }
+  if (h.element_size != element_size) {
+    throw binary_format_error("file holds elements of size " + std::to_string(h.element_size) +
+                              ", not " + std::to_string(element_size));
+  }
+  auto expected = make_binary_header(nested, element_size, h.size, h.num_elements);
+  if (h.data_offset != expected.data_offset || f.size() != h.data_offset + h.num_elements * element_size) {
+    throw binary_format_error("file size does not match its header");
+  }
+  return h;
+}
+
+// Copies n bytes from src to dst in parallel blocks
+inline void parallel_memcpy(char* dst, const char* src, size_t n) {
+  constexpr size_t block_size = size_t{1} << 16;
+  parallel_for(0, (n + block_size - 1) / block_size, [&](size_t i) {
+    size_t s = i * block_size;
+    std::memcpy(dst + s, src + s, (std::min)(block_size, n - s));
+  }, 1);
+}
+
+// Stores the elements of r (which are of type T) at dst, in parallel if
+// the range is large
+template<typename T, typename Range>
+void store_elements(char* dst, const Range& r, bool parallel) {
+  auto it = std::begin(r);
+  size_t n = parlay::size(r);
+  if constexpr (std::is_pointer_v<decltype(it)>) {
+    if (parallel) parallel_memcpy(dst, reinterpret_cast<const char*>(it), n * sizeof(T));
+    else std::memcpy(dst, it, n * sizeof(T));
+  }
+  else {
+    auto store = [&](size_t i) {
+      T x = it[i];
+      std::memcpy(dst + i * sizeof(T), &x, sizeof(T));
+    };
+    if (parallel) parallel_for(0, n, store);
+    else for (size_t i = 0; i < n; i++) store(i);
+  }
+}
+
+template<typename T>
+struct binary_row {
+  const uint64_t* offsets;
+  const T* elements;
+  slice<const T*, const T*> operator()(size_t i) const {
+    return make_slice(elements + offsets[i], elements + offsets[i + 1]);
+  }
+};
+
+}  // namespace internal
+
+// Saves a random-access range of plain values, or a range of such ranges,
+// to a file in the binary format.
+template<typename Range>
+void write_binary(const Range& r, const std::string& filename) {
+  static_assert(is_random_access_range_v<Range>);
+  using value_type = range_value_type_t<Range>;
+  size_t n = parlay::size(r);
+
+  if constexpr (!is_random_access_range_v<value_type>) {
+    static_assert(internal::is_binary_storable_v<value_type>);
+    auto h = internal::make_binary_header(false, sizeof(value_type), n, n);
+    auto f = file_map::create(filename, h.data_offset + n * sizeof(value_type));
+    char* base = f.data();
+    std::memcpy(base, &h, sizeof(h));
+    internal::store_elements<value_type>(base + h.data_offset, r, true);
+  }
+  else {
+    using T = range_value_type_t<value_type>;
+    static_assert(internal::is_binary_storable_v<T>);
+    auto offsets = sequence<uint64_t>::from_function(n + 1, [&](size_t i) -> uint64_t {
+      return i < n ? parlay::size(r.begin()[i]) : 0; });
+    size_t m = scan_inplace(offsets);
+    auto h = internal::make_binary_header(true, sizeof(T), n, m);
+    auto f = file_map::create(filename, h.data_offset + m * sizeof(T));
+    char* base = f.data();
+    std::memcpy(base, &h, sizeof(h));
+    internal::parallel_memcpy(base + sizeof(h), reinterpret_cast<const char*>(offsets.data()),
+                              offsets.size() * sizeof(uint64_t));
+    char* data = base + h.data_offset;
+    parallel_for(0, n, [&](size_t i) {
+      internal::store_elements<T>(data + offsets[i] * sizeof(T), r.begin()[i], false);
+    });
+  }
+}
+
+// A read-only view of a sequence saved with write_binary, with the
+// elements left in place in the mapped file.  binary_view<T> holds a
+// sequence<T>, and binary_view<sequence<T>> holds a sequence of sequences
+// whose inner sequences are slices of the mapped elements.
+template<typename T>
+class binary_view {
+  static_assert(internal::is_binary_storable_v<T>);
+
+ public:
+  using value_type = T;
+  using reference = const T&;
+  using const_reference = const T&;
+  using iterator = const T*;
+  using const_iterator = const T*;
+
+  explicit binary_view(const std::string& filename, const file_map_options& options = {})
+      : file(filename, options) {
+    auto h = internal::read_binary_header(file, false, sizeof(T));
+    first = reinterpret_cast<const T*>(&*file.begin() + h.data_offset);
+    n = h.size;
+    assert(reinterpret_cast<uintptr_t>(first) % alignof(T) == 0);
+  }
+
+  const T* begin() const { return first; }
+  const T* end() const { return first + n; }
+  const T* data() const { return first; }
+  const T& operator[](size_t i) const { return first[i]; }
+  size_t size() const { return n; }
+  bool empty() const { return n == 0; }
+
+ private:
+  file_map file;
+  const T* first;
+  size_t n;
+};
+
+template<typename T>
+class binary_view<sequence<T>> {
+  static_assert(internal::is_binary_storable_v<T>);
+  using rows_type = delayed_sequence<slice<const T*, const T*>, slice<const T*, const T*>, internal::binary_row<T>>;
+
+ public:
+  using value_type = slice<const T*, const T*>;
+  using reference = value_type;
+  using const_reference = value_type;
+  using iterator = typename rows_type::iterator;
+  using const_iterator = iterator;
+
+  explicit binary_view(const std::string& filename, const file_map_options& options = {})
+      : file(filename, options), rows(init()) { }
+
+  iterator begin() const { return rows.begin(); }
+  iterator end() const { return rows.end(); }
+  value_type operator[](size_t i) const { return rows[i]; }
+  size_t size() const { return rows.size(); }
+  bool empty() const { return rows.empty(); }
+
+  // The total number of elements of the inner sequences, and all of them
+  // in order
+  size_t num_elements() const { return m; }
+  slice<const T*, const T*> elements() const { return make_slice(elements_p, elements_p + m); }
+
+ private:
+  file_map file;
+  const T* elements_p;
+  size_t m;
+  rows_type rows;
+
+  rows_type init() {
+    auto h = internal::read_binary_header(file, true, sizeof(T));
+    const char* base = &*file.begin();
+    auto offsets = reinterpret_cast<const uint64_t*>(base + sizeof(internal::binary_header));
+    elements_p = reinterpret_cast<const T*>(base + h.data_offset);
+    m = h.num_elements;
+    assert(reinterpret_cast<uintptr_t>(elements_p) % alignof(T) == 0);
+    if (offsets[0] != 0 || offsets[h.size] != m) throw binary_format_error("offsets do not match the header");
+    // so that every row lies within the elements, which reads all of the
+    // offsets (in parallel), but none of the elements
+    if (!parlay::is_sorted(make_slice(offsets, offsets + h.size + 1), std::less<>())) throw binary_format_error("offsets are not in order");
+    return rows_type(h.size, internal::binary_row<T>{offsets, elements_p});
+  }
+};
+
+// Loads a file saved by write_binary without copying it.  T is the element
+// type, or sequence<E> for a file holding a sequence of sequences of E.
+template<typename T>
+binary_view<T> map_binary(const std::string& filename, const file_map_options& options = {}) {
+  return binary_view<T>(filename, options);
+}
+
+// Loads a file saved by write_binary into a new sequence<T>, where T is
+// the element type, or sequence<E> for a sequence of sequences of E
+template<typename T>
+sequence<T> read_binary(const std::string& filename) {
+  file_map_options options;
+  options.access = file_map_options::access_pattern::sequential;
+  options.will_need = true;
+  auto v = map_binary<T>(filename, options);
+  if constexpr (internal::is_binary_storable_v<T>) {
+    return sequence<T>(v.begin(), v.end());
+  }
+  else {
+    return tabulate(v.size(), [&](size_t i) { return T(v[i].begin(), v[i].end()); });
+  }
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_BINARY_IO_H_
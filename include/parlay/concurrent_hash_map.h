@@ -0,0 +1,430 @@
+
+#ifndef PARLAY_CONCURRENT_HASH_MAP_H_
+#define PARLAY_CONCURRENT_HASH_MAP_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "internal/epoch.h"
+
+#include "parallel.h"
+#include "primitives.h"
+#include "sequence.h"
+#include "utilities.h"
+
+namespace parlay {
+
+// A concurrent hash map from keys of type K to values of type V that
+// grows as needed. Unlike hashtable, any mix of operations can run
+// concurrently, and keys and values can be of any copyable type.
+//
+// Each bucket holds a linked list of immutable nodes. Finds are lock free:
+// they just follow the list. Insertions, updates and erasures lock the one
+// bucket they modify, and never change a node that a find could be reading,
+// but link in a new node in place of the old one instead. Nodes that are
+// unlinked are reclaimed with epoch-based reclamation once no find can
+// still be reading them.
+//
+// When the load gets too high, a table with twice as many buckets is
+// allocated, and the buckets are moved over incrementally in chunks, by
+// whichever threads are performing updates at the time (or all at once
+// in parallel by reserve). Operations on a bucket that has been moved
+// are redirected to the new table.
+//
+// size() is exact when there are no concurrent updates. entries() does
+// not linearize with concurrent updates.
+template <typename K, typename V, typename Hash = parlay::hash<K>, typename Equal = std::equal_to<K>>
+class concurrent_hash_map {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+
+ private:
+  struct node {
+    size_t hash;
+    std::atomic<node*> next;
+    const std::pair<const K, V> kv;
+
+    template <typename KK, typename VV>
+    node(size_t hash_, node* next_, KK&& k, VV&& v)
+        : hash(hash_), next(next_), kv(std::forward<KK>(k), std::forward<VV>(v)) { }
+  };
+
+  // the low bits of a bucket's head pointer are used as flags
+  static constexpr uintptr_t locked_bit = 1;
+  static constexpr uintptr_t moved_bit = 2;
+  static constexpr uintptr_t flag_mask = 3;
+
+  static node* head_of(uintptr_t v) { return reinterpret_cast<node*>(v & ~flag_mask); }
+
+  struct table {
+    size_t mask;  // the number of buckets, which is a power of two, minus one
+    sequence<std::atomic<uintptr_t>> buckets;
+    std::atomic<table*> next{nullptr};  // the table being moved into, if any
+    std::atomic<size_t> claimed{0};     // the number of buckets claimed to be moved
+    std::atomic<size_t> moved{0};       // the number of buckets finished moving
+
+    explicit table(size_t size)
+        : mask(size - 1), buckets(tabulate<std::atomic<uintptr_t>>(size, [](size_t) { return 0; })) { }
+  };
+
+  struct alignas(64) counter {
+    std::atomic<long> value{0};
+  };
+
+  // the following parameters can be tuned
+  static constexpr size_t num_counters = 64;
+  static constexpr size_t move_chunk = 64;
+  static constexpr size_t min_buckets = 16;
+
+  std::atomic<table*> current;
+  std::unique_ptr<counter[]> counts;
+  Hash hasher;
+  Equal equal;
+  double max_load;
+
+  size_t hash_of(const K& k) const { return static_cast<size_t>(hash64_2(hasher(k))); }
+
+  counter& counter_of(size_t h) { return counts[(h >> 32) % num_counters]; }
+
+  static size_t buckets_for(size_t n, double load) {
+    size_t want = static_cast<size_t>(static_cast<double>(n) / load) + 1;
+    return size_t{1} << log2_up((std::max)(want, min_buckets));
+  }
+
+  // Locks the bucket and returns its head, or returns false if it has been moved
+  static bool lock(std::atomic<uintptr_t>& b, node*& head) {
+    while (true) {
+      uintptr_t v = b.load(std::memory_order_acquire);
+      if (v & moved_bit) return false;
+      if (!(v & locked_bit) && b.compare_exchange_weak(v, v | locked_bit, std::memory_order_acquire)) {
+        head = head_of(v);
+        return true;
+      }
+    }
+  }
+
+  // Unlocks the bucket, setting its head to the given node
+  static void unlock(std::atomic<uintptr_t>& b, node* head) {
+    b.store(reinterpret_cast<uintptr_t>(head), std::memory_order_release);
+  }
+
+  // Locks the bucket holding hash h in the newest table that has it, and
+  // calls f(bucket, head), which must unlock the bucket before returning
+  template <typename F>
+  auto with_bucket(size_t h, F&& f) {
+    table* t = current.load(std::memory_order_acquire);
+    help_move(t);
+    while (true) {
+      auto& b = t->buckets[h & t->mask];
+      node* head;
+      if (lock(b, head)) return f(b, head);
+      t = t->next.load(std::memory_order_acquire);
+    }
+  }
+
+  // Returns make(), which allocates a node while the bucket is locked, and
+  // unlocks the bucket, leaving it unchanged, if make throws
+  template <typename Make>
+  static node* make_locked(std::atomic<uintptr_t>& b, node* head, Make&& make) {
+    try {
+      return make();
+    } catch (...) {
+      unlock(b, head);
+      throw;
+    }
+  }
+
+  // Replaces the node p in the list starting at head with q (or removes
+  // it if q is null), and unlocks the bucket
+  static void replace(std::atomic<uintptr_t>& b, node* head, node* p, node* q) {
+    node* next = p->next.load(std::memory_order_relaxed);
+    if (q != nullptr) q->next.store(next, std::memory_order_relaxed);
+    node* replacement = (q != nullptr) ? q : next;
+    if (p == head) {
+      unlock(b, replacement);
+    } else {
+      node* prev = head;
+      while (prev->next.load(std::memory_order_relaxed) != p) prev = prev->next.load(std::memory_order_relaxed);
+      prev->next.store(replacement, std::memory_order_release);
+      unlock(b, head);
+    }
+    internal::retire(p);
+  }
+
+  node* find_in(node* p, size_t h, const K& k) const {
+    for (; p != nullptr; p = p->next.load(std::memory_order_acquire))
+      if (p->hash == h && equal(p->kv.first, k)) return p;
+    return nullptr;
+  }
+
+  // Starts moving t into a table with new_size buckets, unless it is
+  // already being moved
+  void start_resize(table* t, size_t new_size) {
+    if (t->next.load(std::memory_order_acquire) != nullptr) return;
+    table* nt = new table(new_size);
+    table* expected = nullptr;
+    if (!t->next.compare_exchange_strong(expected, nt)) delete nt;
+  }
+
+  void move_bucket(table* t, table* nt, size_t i) {
+    auto& b = t->buckets[i];
+    node* head;
+    [[maybe_unused]] bool locked = lock(b, head);
+    assert(locked);
+    // Nobody writes to the new buckets that this one maps to until it is
+    // marked as moved, so they can be filled in without locking them
+    for (node* p = head; p != nullptr; p = p->next.load(std::memory_order_relaxed)) {
+      auto& nb = nt->buckets[p->hash & nt->mask];
+      node* q = new node(p->hash, head_of(nb.load(std::memory_order_relaxed)), p->kv.first, p->kv.second);
+      nb.store(reinterpret_cast<uintptr_t>(q), std::memory_order_relaxed);
+    }
+    b.store(moved_bit, std::memory_order_release);
+    for (node* p = head; p != nullptr; ) {
+      node* next = p->next.load(std::memory_order_relaxed);
+      internal::retire(p);
+      p = next;
+    }
+  }
+
+  // If t is being resized, claims and moves a chunk of its buckets
+  void help_move(table* t) {
+    table* nt = t->next.load(std::memory_order_acquire);
+    if (nt == nullptr) return;
+    size_t n = t->mask + 1;
+    size_t start = t->claimed.fetch_add(move_chunk);
+    if (start >= n) return;
+    size_t end = (std::min)(n, start + move_chunk);
+    for (size_t i = start; i < end; i++) move_bucket(t, nt, i);
+    if (t->moved.fetch_add(end - start) + (end - start) == n) {
+      current.store(nt, std::memory_order_release);
+      internal::retire(t);
+    }
+  }
+
+  // Moves all remaining buckets of the current table in parallel, and
+  // waits until any other threads that are moving buckets are done
+  void finish_resize() {
+    internal::epoch_guard g;
+    table* t = current.load(std::memory_order_acquire);
+    if (t->next.load(std::memory_order_acquire) == nullptr) return;
+    size_t n = t->mask + 1;
+    parallel_for(0, (n + move_chunk - 1) / move_chunk, [&](size_t) {
+      internal::epoch_guard g2;
+      help_move(t);
+    }, 1);
+    while (current.load(std::memory_order_acquire) == t) { }
+  }
+
+  // Appends the entries of bucket i of t to out, following it into
+  // the new table if it has been moved there in the meantime
+  void collect(table* t, size_t i, sequence<value_type>& out) {
+    uintptr_t v = t->buckets[i].load(std::memory_order_acquire);
+    if (v & moved_bit) {
+      table* nt = t->next.load(std::memory_order_acquire);
+      for (size_t j = i; j <= nt->mask; j += t->mask + 1) collect(nt, j, out);
+      return;
+    }
+    for (node* p = head_of(v); p != nullptr; p = p->next.load(std::memory_order_acquire))
+      out.emplace_back(p->kv.first, p->kv.second);
+  }
+
+  void grow_if_needed(size_t h) {
+    long c = counter_of(h).value.fetch_add(1, std::memory_order_relaxed) + 1;
+    table* t = current.load(std::memory_order_acquire);
+    double limit = max_load * static_cast<double>(t->mask + 1) / num_counters;
+    if (static_cast<double>(c) > limit) start_resize(t, 2 * (t->mask + 1));
+  }
+
+ public:
+  // Creates a map with room for about capacity entries before it first
+  // needs to grow. It grows when the average number of entries per bucket
+  // exceeds max_load.
+  explicit concurrent_hash_map(size_t capacity = 0, double max_load_ = 1.0,
+                               Hash hasher_ = {}, Equal equal_ = {})
+      : current(new table(buckets_for(capacity, max_load_))),
+        counts(new counter[num_counters]),
+        hasher(std::move(hasher_)),
+        equal(std::move(equal_)),
+        max_load(max_load_) { }
+
+  concurrent_hash_map(const concurrent_hash_map&) = delete;
+  concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+  // Must not run concurrently with any other operation
+  ~concurrent_hash_map() {
+    finish_resize();
+    table* t = current.load();
+    parallel_for(0, t->mask + 1, [&](size_t i) {
+      node* p = head_of(t->buckets[i].load());
+      while (p != nullptr) {
+        node* next = p->next.load();
+        delete p;
+        p = next;
+      }
+    }, 1000);
+    delete t;
+  }
+
+  // Returns a copy of the value associated with k, if any
+  std::optional<V> find(const K& k) const {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    table* t = current.load(std::memory_order_acquire);
+    while (true) {
+      uintptr_t v = t->buckets[h & t->mask].load(std::memory_order_acquire);
+      if (v & moved_bit) {
+        t = t->next.load(std::memory_order_acquire);
+        continue;
+      }
+      node* p = find_in(head_of(v), h, k);
+      if (p == nullptr) return std::nullopt;
+      return p->kv.second;
+    }
+  }
+
+  bool contains(const K& k) const {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    table* t = current.load(std::memory_order_acquire);
+    while (true) {
+      uintptr_t v = t->buckets[h & t->mask].load(std::memory_order_acquire);
+      if (v & moved_bit) {
+        t = t->next.load(std::memory_order_acquire);
+        continue;
+      }
+      return find_in(head_of(v), h, k) != nullptr;
+    }
+  }
+
+  // Inserts (k, v) if k is not already present.
+  // Returns true if it was inserted.
+  bool insert(const K& k, const V& v) {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    bool inserted = with_bucket(h, [&](auto& b, node* head) {
+      if (find_in(head, h, k) != nullptr) {
+        unlock(b, head);
+        return false;
+      }
+      unlock(b, make_locked(b, head, [&] { return new node(h, head, k, v); }));
+      return true;
+    });
+    if (inserted) grow_if_needed(h);
+    return inserted;
+  }
+
+  // Inserts (k, v), or replaces the value of k with v if it is already
+  // present. Returns true if it was inserted.
+  bool insert_or_assign(const K& k, const V& v) {
+    return upsert(k, v, [&](const V&) { return v; });
+  }
+
+  // Replaces the value of k with f(old value) if it is present, or
+  // otherwise inserts (k, v). f is called while the bucket is locked, so
+  // concurrent upserts of the same key are atomic with respect to each
+  // other. If f throws, the key keeps its old value and the exception is
+  // propagated. Returns true if it was inserted.
+  template <typename F>
+  bool upsert(const K& k, const V& v, F&& f) {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    bool inserted = with_bucket(h, [&](auto& b, node* head) {
+      node* p = find_in(head, h, k);
+      if (p == nullptr) {
+        unlock(b, make_locked(b, head, [&] { return new node(h, head, k, v); }));
+        return true;
+      }
+      replace(b, head, p, make_locked(b, head, [&] { return new node(h, nullptr, p->kv.first, f(p->kv.second)); }));
+      return false;
+    });
+    if (inserted) grow_if_needed(h);
+    return inserted;
+  }
+
+  // Replaces the value of k with f(old value) if k is present, leaving it
+  // unchanged if f throws. Returns true if k was present.
+  template <typename F>
+  bool update(const K& k, F&& f) {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    return with_bucket(h, [&](auto& b, node* head) {
+      node* p = find_in(head, h, k);
+      if (p == nullptr) {
+        unlock(b, head);
+        return false;
+      }
+      replace(b, head, p, make_locked(b, head, [&] { return new node(h, nullptr, p->kv.first, f(p->kv.second)); }));
+      return true;
+    });
+  }
+
+  // Removes k. Returns true if it was present.
+  bool erase(const K& k) {
+    internal::epoch_guard g;
+    size_t h = hash_of(k);
+    bool erased = with_bucket(h, [&](auto& b, node* head) {
+      node* p = find_in(head, h, k);
+      if (p == nullptr) {
+        unlock(b, head);
+        return false;
+      }
+      replace(b, head, p, nullptr);
+      return true;
+    });
+    if (erased) counter_of(h).value.fetch_sub(1, std::memory_order_relaxed);
+    return erased;
+  }
+
+  size_t size() const {
+    long total = 0;
+    for (size_t i = 0; i < num_counters; i++) total += counts[i].value.load(std::memory_order_relaxed);
+    return static_cast<size_t>((std::max)(total, 0L));
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // The number of buckets in the current table
+  size_t bucket_count() const { return current.load()->mask + 1; }
+
+  // Grows the table, in parallel, so that it can hold at least
+  // n entries without growing again
+  void reserve(size_t n) {
+    finish_resize();
+    size_t new_size = buckets_for(n, max_load);
+    {
+      internal::epoch_guard g;
+      table* t = current.load(std::memory_order_acquire);
+      if (new_size <= t->mask + 1) return;
+      start_resize(t, new_size);
+    }
+    finish_resize();
+  }
+
+  // Returns all of the entries. If there are concurrent updates, it
+  // might or might not include their effects.
+  sequence<value_type> entries() {
+    finish_resize();
+    internal::epoch_guard g;
+    table* t = current.load(std::memory_order_acquire);
+    auto per_bucket = tabulate(t->mask + 1, [&](size_t i) {
+      sequence<value_type> r;
+      collect(t, i, r);
+      return r;
+    }, 100);
+    return flatten(std::move(per_bucket));
+  }
+};
+
+}  // namespace parlay
+
+#endif  // PARLAY_CONCURRENT_HASH_MAP_H_
@@ -0,0 +1,401 @@
+// Parallel reading of CSV and TSV files into typed columns.
+//
+// The input is split into fixed-size chunks which are scanned in parallel
+// for record boundaries, i.e., newlines that are not inside quoted fields.
+// Whether a chunk starts inside a quoted field is not known until the
+// chunks before it have been scanned, so each chunk speculatively records
+// the boundaries for both possibilities: since quotes (including the
+// doubled quotes that escape a quote inside a quoted field) toggle the
+// state, a newline is a boundary under one assumption exactly when it is
+// not under the other, depending on the parity of the quotes before it in
+// the chunk. A scan over the per-chunk quote counts then selects the right
+// set of boundaries for each chunk, and the records are split into fields
+// and parsed into the columns in parallel.
+//
+// Fields follow RFC 4180: a field may be enclosed in quotes, in which case
+// it may contain delimiters, newlines, and quotes written twice.  Records
+// end with "\n" or "\r\n", and blank lines are skipped.  Integer and
+// floating point fields are parsed with chars_to_int_t and chars_to_double
+// (or the float and long double versions), and fields can also be read as
+// chars or std::string.  Malformed input raises a csv_error that gives the
+// line on which the first offending record starts.
+
+#ifndef PARLAY_CSV_H_
+#define PARLAY_CSV_H_
+
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "io.h"
+#include "parallel.h"
+#include "primitives.h"
+#include "sequence.h"
+#include "slice.h"
+#include "utilities.h"
+
+#include "internal/char_scan.h"
+
+namespace parlay {
+
+struct csv_options {
+  // the character separating the fields of a record
+  char delimiter = ',';
+  // the character enclosing fields that contain delimiters, newlines or quotes
+  char quote = '"';
+  // whether the first record holds the names of the columns
+  bool header = true;
+};
+
+inline csv_options tsv_options() {
+  csv_options options;
+  options.delimiter = '\t';
+  return options;
+}
+
+// Raised for malformed input.  line() is the (1-based) line of the input
+// on which the offending record starts.
+class csv_error : public std::runtime_error {
+ public:
+  csv_error(size_t line, const std::string& what)
+    : std::runtime_error("line " + std::to_string(line) + ": " + what), line_(line) {}
+  size_t line() const { return line_; }
+ private:
+  size_t line_;
+};
+
+// The result of reading a CSV file: a column of type Ts for each field
+template<typename... Ts>
+struct csv_table {
+  // the column names if the input has a header, otherwise empty
+  sequence<chars> header;
+  std::tuple<sequence<Ts>...> columns;
+
+  size_t size() const { return std::get<0>(columns).size(); }
+
+  template<size_t I>
+  auto& column() { return std::get<I>(columns); }
+
+  template<size_t I>
+  const auto& column() const { return std::get<I>(columns); }
+};
+
+namespace internal {
+
+// the following parameter can be tuned, but must be a multiple of 64
+constexpr const size_t CSV_CHUNK_SIZE = size_t{1} << 16;
+
+// Returns the start of each record of s, followed by n
+template<typename Slice>
+sequence<size_t> csv_record_starts(const Slice& s, char quote) {
+  size_t n = s.size();
+  size_t num_chunks = (n + CSV_CHUNK_SIZE - 1) / CSV_CHUNK_SIZE;
+
+  // for each chunk, its number of quotes, and the newlines that follow an
+  // even (resp. odd) number of quotes within the chunk
+  auto quotes = sequence<size_t>::uninitialized(num_chunks);
+  auto even = sequence<sequence<size_t>>(num_chunks);
+  auto odd = sequence<sequence<size_t>>(num_chunks);
+  parallel_for(0, num_chunks, [&](size_t c) {
+    size_t start = c * CSV_CHUNK_SIZE;
+    size_t end = (std::min)(n, start + CSV_CHUNK_SIZE);
+    size_t q = 0;
+    if constexpr (is_byte_pointer_v<decltype(s.begin()), char>) {
+      // 64 characters at a time, where the newlines inside quotes are those
+      // at which the prefix xor of the quote mask is set
+      const char* p = s.begin();
+      uint64_t inside = 0;
+      for (size_t w = start; w < end; w += 64) {
+        bool full = w + 64 <= end;
+        uint64_t quote_mask = full ? match_mask(p + w, byte_matcher{quote}) : match_mask(p + w, end - w, byte_matcher{quote}, false);
+        uint64_t newlines = full ? match_mask(p + w, byte_matcher{'\n'}) : match_mask(p + w, end - w, byte_matcher{'\n'}, false);
+        uint64_t odd_mask = prefix_xor64(quote_mask) ^ inside;
+        for (uint64_t m = newlines & ~odd_mask; m != 0; m &= m - 1) even[c].push_back(w + count_trailing_zeros64(m) + 1);
+        for (uint64_t m = newlines & odd_mask; m != 0; m &= m - 1) odd[c].push_back(w + count_trailing_zeros64(m) + 1);
+        inside = (odd_mask >> 63) ? ~uint64_t{0} : 0;
+        q += popcount64(quote_mask);
+      }
+    }
+    else {
+      for (size_t i = start; i < end; i++) {
+        char x = s[i];
+        if (x == quote) q++;
+        else if (x == '\n') ((q & 1) ? odd[c] : even[c]).push_back(i + 1);
+      }
+    }
+    quotes[c] = q;
+  }, 1);
+  scan_inplace(quotes);
+
+  auto starts = flatten(tabulate(num_chunks + 2, [&](size_t c) -> sequence<size_t> {
+    if (c == 0) return sequence<size_t>(1, 0);
+    if (c == num_chunks + 1) return sequence<size_t>(1, n);
+    return std::move((quotes[c - 1] & 1) ? odd[c - 1] : even[c - 1]);
+  }, 1));
+  // a newline at the very end does not start a record
+  if (starts.size() > 1 && starts[starts.size() - 2] == n) starts.pop_back();
+  return starts;
+}
+
+// Splits the record s[start, end) into its fields, calling f(i, field,
+// quoted) for each, where quoted fields are given without their enclosing
+// quotes (but still with doubled quotes).  Returns the number of fields,
+// or sets error and returns 0 if the record is malformed.
+template<typename Slice, typename F>
+size_t csv_split_record(const Slice& s, size_t start, size_t end, const csv_options& options,
+                        std::string& error, F&& f) {
+  if (end > start && s[end - 1] == '\n') end--;
+  if (end > start && s[end - 1] == '\r') end--;
+  size_t i = start, k = 0;
+  while (true) {
+    if (i < end && s[i] == options.quote) {
+      size_t j = ++i;
+      while (true) {
+        while (j < end && s[j] != options.quote) j++;
+        if (j == end) { error = "unterminated quoted field"; return 0; }
+        if (j + 1 < end && s[j + 1] == options.quote) j += 2;
+        else break;
+      }
+      f(k++, s.cut(i, j), true);
+      i = j + 1;
+      if (i < end && s[i] != options.delimiter) {
+        error = "unexpected character after quoted field " + std::to_string(k);
+        return 0;
+      }
+    }
+    else {
+      size_t j = i;
+      while (j < end && s[j] != options.delimiter) j++;
+      f(k++, s.cut(i, j), false);
+      i = j;
+    }
+    if (i == end) return k;
+    i++;  // skip the delimiter
+  }
+}
+
+// Removes the doubled quotes from the contents of a quoted field
+template<typename Slice>
+chars csv_unescape(const Slice& field, bool quoted, char quote) {
+  chars result(field.begin(), field.end());
+  if (quoted) {
+    size_t j = 0;
+    for (size_t i = 0; i < result.size(); i++, j++) {
+      result[j] = result[i];
+      if (result[i] == quote) i++;
+    }
+    result.resize(j);
+  }
+  return result;
+}
+
+template<typename Slice>
+bool csv_is_integer(const Slice& s, bool is_signed) {
+  size_t i = 0;
+  if (i < s.size() && (s[i] == '+' || (is_signed && s[i] == '-'))) i++;
+  if (i == s.size()) return false;
+  for (; i < s.size(); i++)
+    if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+  return true;
+}
+
+template<typename Slice>
+bool csv_is_float(const Slice& s) {
+  size_t i = 0, n = s.size();
+  auto digits = [&]() {
+    size_t d = 0;
+    while (i < n && std::isdigit(static_cast<unsigned char>(s[i]))) { i++; d++; }
+    return d;
+  };
+  if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+  if (i < n && (s[i] == 'i' || s[i] == 'n')) {
+    std::string rest(s.begin() + i, s.end());
+    return rest == "inf" || rest == "infinity" || rest == "nan";
+  }
+  size_t d = digits();
+  if (i < n && s[i] == '.') { i++; d += digits(); }
+  if (d == 0) return false;
+  if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+    i++;
+    if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+    if (digits() == 0) return false;
+  }
+  return i == n;
+}
+
+// Whether the integer s, as accepted by csv_is_integer, fits in a T.
+// Integers with few enough digits always fit, and longer ones are
+// accumulated with a check against the limit.
+template<typename T, typename Slice>
+bool csv_integer_fits(const Slice& s) {
+  size_t i = 0;
+  bool negative = false;
+  if (s[0] == '-' || s[0] == '+') { negative = (s[0] == '-'); i = 1; }
+  while (i < s.size() && s[i] == '0') i++;
+  if (s.size() - i <= static_cast<size_t>(std::numeric_limits<T>::digits10)) return true;
+  uint64_t limit = static_cast<uint64_t>((std::numeric_limits<T>::max)());
+  if (negative) limit = std::is_signed_v<T> ? limit + 1 : 0;
+  uint64_t m = 0;
+  for (; i < s.size(); i++) {
+    uint64_t d = static_cast<uint64_t>(s[i] - '0');
+    if (limit < d || m > (limit - d) / 10) return false;
+    m = m * 10 + d;
+  }
+  return true;
+}
+
+// Parses an integer field s that is in a valid format as a T, or sets error
+template<typename T, typename Slice>
+T csv_parse_integer(const Slice& s, std::string& error) {
+  if (!csv_integer_fits<T>(s)) {
+    error = "number out of range \"" + std::string(s.begin(), s.end()) + "\"";
+    return T{};
+  }
+  return chars_to_int_t<T>(make_slice(s));
+}
+
+// Parses a field as a T, or sets error
+template<typename T, typename Slice>
+T csv_parse_field(const Slice& field, bool quoted, char quote, std::string& error) {
+  if constexpr (std::is_integral_v<T>) {
+    // unquoted integers are parsed in place
+    if (!quoted && csv_is_integer(field, std::is_signed_v<T>)) return csv_parse_integer<T>(field, error);
+  }
+  chars s = csv_unescape(field, quoted, quote);
+  if constexpr (std::is_same_v<T, chars>) {
+    return s;
+  }
+  else if constexpr (std::is_same_v<T, std::string>) {
+    return std::string(s.begin(), s.end());
+  }
+  else if constexpr (std::is_integral_v<T>) {
+    if (!csv_is_integer(s, std::is_signed_v<T>)) {
+      error = "invalid integer \"" + std::string(s.begin(), s.end()) + "\"";
+      return T{};
+    }
+    return csv_parse_integer<T>(s, error);
+  }
+  else if constexpr (std::is_floating_point_v<T>) {
+    if (!csv_is_float(s)) {
+      error = "invalid number \"" + std::string(s.begin(), s.end()) + "\"";
+      return T{};
+    }
+    // the slow path of the conversion throws if the value is out of range,
+    // which is an error only if it overflows rather than being subnormal
+    try {
+      if constexpr (std::is_same_v<T, float>) return chars_to_float(s);
+      else if constexpr (std::is_same_v<T, double>) return chars_to_double(s);
+      else return chars_to_long_double(s);
+    } catch (const std::out_of_range&) {
+      std::string str(s.begin(), s.end());
+      T v;
+      if constexpr (std::is_same_v<T, float>) v = std::strtof(str.c_str(), nullptr);
+      else if constexpr (std::is_same_v<T, double>) v = std::strtod(str.c_str(), nullptr);
+      else v = std::strtold(str.c_str(), nullptr);
+      if (std::isinf(v)) error = "number out of range \"" + str + "\"";
+      return v;
+    }
+  }
+  else {
+    static_assert(std::is_same_v<T, chars>, "csv fields can only be read as chars, std::string, integers or floats");
+  }
+}
+
+template<typename... Ts, typename Range, size_t... Is>
+csv_table<Ts...> parse_csv_(const Range& text, const csv_options& options, std::index_sequence<Is...>) {
+  constexpr size_t num_columns = sizeof...(Ts);
+  auto s = make_slice(text);
+  auto starts = csv_record_starts(s, options.quote);
+
+  // the first record that failed to parse, and why
+  std::atomic<size_t> error_record(starts.size());
+  std::string error_message;
+  std::mutex error_lock;
+  auto report = [&](size_t r, std::string&& what) {
+    write_min(&error_record, r, std::less<size_t>());
+    std::lock_guard<std::mutex> lock(error_lock);
+    if (error_record.load() == r) error_message = std::move(what);
+  };
+  auto is_blank = [&](size_t r) {
+    size_t len = starts[r + 1] - starts[r];
+    return len == 0 || (len == 1 && s[starts[r]] == '\n') ||
+        (len == 2 && s[starts[r]] == '\r' && s[starts[r] + 1] == '\n');
+  };
+
+  csv_table<Ts...> result;
+  size_t first = 0;
+  while (first + 1 < starts.size() && is_blank(first)) first++;
+  if (options.header && first + 1 < starts.size()) {
+    std::string error;
+    csv_split_record(s, starts[first], starts[first + 1], options, error,
+                     [&](size_t, auto field, bool quoted) {
+      result.header.push_back(csv_unescape(field, quoted, options.quote));
+    });
+    if (!error.empty()) report(first, std::move(error));
+    first++;
+  }
+
+  // the records with content, in order
+  auto records = pack_index(delayed_tabulate(starts.size() - 1, [&](size_t r) {
+    return r >= first && !is_blank(r); }));
+  size_t m = records.size();
+  ((std::get<Is>(result.columns) = sequence<Ts>(m)), ...);
+
+  parallel_for(0, m, [&](size_t i) {
+    size_t r = records[i];
+    std::string error;
+    size_t k = csv_split_record(s, starts[r], starts[r + 1], options, error,
+                                [&](size_t j, auto field, bool quoted) {
+      if (j >= num_columns || !error.empty()) return;
+      ((j == Is ? (void) (std::get<Is>(result.columns)[i] =
+          csv_parse_field<Ts>(field, quoted, options.quote, error)) : (void) 0), ...);
+      if (!error.empty()) error = "field " + std::to_string(j + 1) + ": " + error;
+    });
+    if (error.empty() && k != num_columns)
+      error = "expected " + std::to_string(num_columns) + " fields, found " + std::to_string(k);
+    if (!error.empty()) report(r, std::move(error));
+  });
+
+  size_t bad = error_record.load();
+  if (bad != starts.size()) {
+    size_t line = 1 + count(s.cut(0, starts[bad]), '\n');
+    throw csv_error(line, error_message);
+  }
+  return result;
+}
+
+}  // namespace internal
+
+// Parses CSV text held in a range of chars into columns of the types Ts
+template<typename... Ts, typename Range>
+csv_table<Ts...> parse_csv(const Range& text, const csv_options& options = {}) {
+  static_assert(sizeof...(Ts) > 0);
+  static_assert(is_random_access_range_v<Range>);
+  static_assert(std::is_convertible_v<range_reference_type_t<Range>, char>);
+  return internal::parse_csv_<Ts...>(text, options, std::index_sequence_for<Ts...>());
+}
+
+// Reads a CSV file into columns of the types Ts.  The file is mapped into
+// memory with file_map rather than read in.
+template<typename... Ts>
+csv_table<Ts...> read_csv(const std::string& filename, const csv_options& options = {}) {
+  file_map f(filename);
+  return parse_csv<Ts...>(f, options);
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_CSV_H_
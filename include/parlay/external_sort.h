@@ -0,0 +1,251 @@
+// External memory sorting of files of fixed-size records that may be
+// much larger than main memory.
+//
+// The input is read in chunks that fit in the given memory budget, each
+// of which is sorted in parallel with sort_inplace and spilled to disk as
+// a sorted run. The runs are then combined with a multiway merge in rounds:
+// every run keeps one block in memory and reads the next one ahead in the
+// background, and each round outputs everything no greater than the
+// smallest last element of any block, merged in parallel with merge_k,
+// while the previous round's output is written out in the background.
+// If there are too many runs to give each a reasonably large block, they
+// are merged in groups over several passes.
+
+#ifndef PARLAY_EXTERNAL_SORT_H_
+#define PARLAY_EXTERNAL_SORT_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "internal/merge_k.h"
+
+#include "primitives.h"
+#include "sequence.h"
+#include "slice.h"
+
+namespace parlay {
+namespace internal {
+
+// the following parameters can be tuned
+constexpr const size_t EXTERNAL_SORT_MIN_BLOCK_BYTES = size_t{1} << 20;
+constexpr const size_t EXTERNAL_SORT_MAX_FAN_IN = 256;
+
+// Reads exactly n records of type T from the current position of in
+template <typename T>
+sequence<T> read_records(std::ifstream& in, size_t n) {
+  auto buf = sequence<T>::uninitialized(n);
+  in.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(n * sizeof(T)));
+  assert(static_cast<size_t>(in.gcount()) == n * sizeof(T));
+  return buf;
+}
+
+template <typename T>
+void write_records(std::ofstream& out, const sequence<T>& buf) {
+  out.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size() * sizeof(T)));
+  assert(out.good());
+}
+
+inline size_t num_records_in_file(const std::string& filename, size_t record_size) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+  assert(file.is_open());
+  auto length = static_cast<size_t>(file.tellg());
+  assert(length % record_size == 0);
+  return length / record_size;
+}
+
+// The names of temporary files, which are removed when it is destroyed,
+// so that they are cleaned up even if the sort fails part way
+struct temporary_files {
+  std::vector<std::string> names;
+
+  temporary_files() = default;
+  temporary_files(const temporary_files&) = delete;
+  temporary_files& operator=(const temporary_files&) = delete;
+  ~temporary_files() {
+    for (const auto& name : names) std::remove(name.c_str());
+  }
+};
+
+// A sorted run being read from disk one block at a time. The block after
+// the current one is always being read in the background.
+template <typename T>
+struct run_reader {
+  std::ifstream in;
+  size_t remaining = 0;   // records not yet requested from the file
+  size_t block_size = 0;
+  sequence<T> buf;        // the current block, of which [pos, buf.size()) is unconsumed
+  size_t pos = 0;
+  std::future<sequence<T>> next;
+
+  void open(const std::string& filename, size_t block) {
+    remaining = num_records_in_file(filename, sizeof(T));
+    in.open(filename, std::ios::in | std::ios::binary);
+    assert(in.is_open());
+    block_size = block;
+    prefetch();
+    advance(0);
+  }
+
+  void prefetch() {
+    if (remaining == 0) return;
+    size_t m = (std::min)(block_size, remaining);
+    remaining -= m;
+    next = std::async(std::launch::async, [this, m]() { return read_records<T>(in, m); });
+  }
+
+  // Consumes m records of the current block, moving on to the next block
+  // if the current one is used up
+  void advance(size_t m) {
+    pos += m;
+    if (pos == buf.size() && next.valid()) {
+      buf = next.get();
+      pos = 0;
+      prefetch();
+    }
+  }
+
+  bool done() const { return pos == buf.size(); }
+  bool has_more_blocks() const { return next.valid(); }
+  auto current() { return make_slice(buf).cut(pos, buf.size()); }
+};
+
+// Merges the sorted runs stored in the given files into out_file, using
+// roughly memory_limit bytes of buffer space
+template <typename T, typename Compare>
+void merge_runs(const std::vector<std::string>& run_files, const std::string& out_file,
+                size_t memory_limit, const Compare& less) {
+  size_t k = run_files.size();
+
+  // Each run has a block being merged and one being read ahead, and the
+  // output has a round being merged and one being written, so there are
+  // about 4k blocks in memory at once
+  size_t block_size = (std::max)(size_t{1}, memory_limit / (4 * k * sizeof(T)));
+  std::vector<run_reader<T>> readers(k);
+  parallel_for(0, k, [&](size_t i) { readers[i].open(run_files[i], block_size); }, 1);
+
+  std::ofstream out(out_file, std::ios::out | std::ios::binary);
+  assert(out.is_open());
+  std::future<void> writing;
+
+  using slice_type = decltype(readers[0].current());
+  while (true) {
+    // Everything up to the smallest last element of a block that has more
+    // blocks after it is safe to output, since every record still on disk
+    // is at least that large. If no run has more blocks, output the rest.
+    const T* bound = nullptr;
+    for (auto& r : readers) {
+      if (!r.done() && r.has_more_blocks() && (bound == nullptr || less(r.buf.back(), *bound)))
+        bound = &r.buf.back();
+    }
+
+    auto pieces = sequence<slice_type>::from_function(k, [&](size_t i) {
+      auto cur = readers[i].current();
+      if (bound == nullptr) return cur;
+      return cur.cut(0, std::upper_bound(cur.begin(), cur.end(), *bound, less) - cur.begin());
+    });
+    auto merged = internal::merge_k(pieces, less);
+    if (merged.empty()) break;
+
+    if (writing.valid()) writing.get();
+    writing = std::async(std::launch::async, [&out, merged = std::move(merged)]() {
+      write_records(out, merged);
+    });
+    for (size_t i = 0; i < k; i++) readers[i].advance(pieces[i].size());
+  }
+  if (writing.valid()) writing.get();
+}
+
+template <typename T, typename Compare>
+void external_sort_(const std::string& in_file, const std::string& out_file,
+                    size_t memory_limit, const Compare& less, const std::string& tmp_prefix) {
+  size_t n = num_records_in_file(in_file, sizeof(T));
+
+  // One chunk is read ahead while the current one is sorted, which needs
+  // as much again for scratch space, and the previous one is written out
+  size_t chunk_size = (std::max)(size_t{1}, memory_limit / (4 * sizeof(T)));
+
+  std::ifstream in(in_file, std::ios::in | std::ios::binary);
+  assert(in.is_open());
+  if (n <= chunk_size) {
+    auto buf = read_records<T>(in, n);
+    parlay::sort_inplace(buf, less);
+    std::ofstream out(out_file, std::ios::out | std::ios::binary);
+    assert(out.is_open());
+    write_records(out, buf);
+    return;
+  }
+
+  // Form sorted runs, overlapping reading, sorting and writing. The runs
+  // are declared first so that, if anything throws, the background tasks
+  // finish before their files are removed.
+  temporary_files runs;
+  std::future<void> writing;
+  auto reading = std::async(std::launch::async, [&]() { return read_records<T>(in, chunk_size); });
+  for (size_t start = 0; start < n; start += chunk_size) {
+    auto buf = reading.get();
+    size_t next_start = start + chunk_size;
+    if (next_start < n) {
+      reading = std::async(std::launch::async, [&, next_start]() {
+        return read_records<T>(in, (std::min)(chunk_size, n - next_start));
+      });
+    }
+    parlay::sort_inplace(buf, less);
+    if (writing.valid()) writing.get();
+    runs.names.push_back(tmp_prefix + ".run0." + std::to_string(runs.names.size()));
+    writing = std::async(std::launch::async, [name = runs.names.back(), buf = std::move(buf)]() {
+      std::ofstream out(name, std::ios::out | std::ios::binary);
+      assert(out.is_open());
+      write_records(out, buf);
+    });
+  }
+  writing.get();
+
+  // Merge passes, each reducing the number of runs by a factor of fan_in
+  size_t fan_in = (std::min)(EXTERNAL_SORT_MAX_FAN_IN,
+                             (std::max)(size_t{2}, memory_limit / (4 * EXTERNAL_SORT_MIN_BLOCK_BYTES)));
+  for (size_t pass = 1; runs.names.size() > fan_in; pass++) {
+    temporary_files next_runs;
+    size_t num_runs = runs.names.size();
+    for (size_t i = 0; i < num_runs; i += fan_in) {
+      std::vector<std::string> group(runs.names.begin() + i, runs.names.begin() + (std::min)(i + fan_in, num_runs));
+      next_runs.names.push_back(tmp_prefix + ".run" + std::to_string(pass) + "." + std::to_string(next_runs.names.size()));
+      merge_runs<T>(group, next_runs.names.back(), memory_limit, less);
+      for (const auto& name : group) std::remove(name.c_str());
+    }
+    runs.names = std::move(next_runs.names);
+    next_runs.names.clear();
+  }
+  merge_runs<T>(runs.names, out_file, memory_limit, less);
+}
+
+}  // namespace internal
+
+// Sorts the records of type T stored back to back in in_file, writing
+// them to out_file. T must be trivially copyable, and the file is read and
+// written as raw bytes. At most about memory_limit bytes of records are held
+// in memory at once, so the file can be much larger than main memory.
+// Sorted runs are spilled to temporary files whose names start with
+// tmp_prefix, which defaults to the name of the output file. The sort is
+// not stable.
+template <typename T, typename Compare = std::less<>>
+void external_sort(const std::string& in_file, const std::string& out_file,
+                   size_t memory_limit, Compare&& less = {}, const std::string& tmp_prefix = "") {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(std::is_invocable_r_v<bool, Compare, const T&, const T&>);
+  internal::external_sort_<T>(in_file, out_file, memory_limit, less,
+                              tmp_prefix.empty() ? out_file : tmp_prefix);
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_EXTERNAL_SORT_H_
@@ -0,0 +1,137 @@
+// Detection of the cache sizes of the machine, which the algorithms whose
+// performance depends on their working set fitting in cache are tuned by.
+//
+// On Linux, the sizes are read from sysfs, which also tells how many
+// logical CPUs share each cache. Elsewhere they are read with sysconf if
+// it supports it. Sizes that can not be detected are given defaults that
+// are typical of a server. The profile can also be set by hand, which is
+// useful for tuning, or for machines on which detection gets it wrong
+// (e.g., virtual machines, which often report the whole L3 cache of the
+// host as belonging to a single CPU).
+
+#ifndef PARLAY_HARDWARE_H_
+#define PARLAY_HARDWARE_H_
+
+#include <cctype>
+#include <cstddef>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace parlay {
+
+struct hardware_profile {
+  size_t l1d_size = 0;    // in bytes, of each cache
+  size_t l2_size = 0;
+  size_t l3_size = 0;
+  size_t cpus_per_l2 = 1;  // the number of logical CPUs that share each cache
+  size_t cpus_per_l3 = 1;
+
+  // The amount of cache that each thread can expect to have to itself,
+  // which is its share of the L2 and L3 caches. It is capped at 4MB, since
+  // sharing is often under-reported (see above), and blocks that big are
+  // already much larger than needed to amortize the cost of a miss.
+  size_t cache_per_thread() const {
+    size_t share = l2_size / (std::max)(cpus_per_l2, size_t{1}) + l3_size / (std::max)(cpus_per_l3, size_t{1});
+    return (std::min)(share, size_t{4} << 20);
+  }
+};
+
+namespace internal {
+
+// defaults for sizes that can not be detected
+constexpr const size_t DEFAULT_L1D_SIZE = 32 * 1024;
+constexpr const size_t DEFAULT_L2_SIZE = 1024 * 1024;
+constexpr const size_t DEFAULT_L3_SIZE = 32 * 1024 * 1024;
+constexpr const size_t DEFAULT_CPUS_PER_L3 = 16;
+
+// Parses a size such as "48K" or "32M"
+inline size_t parse_cache_size(const std::string& s) {
+  size_t i = 0, size = 0;
+  while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) size = 10 * size + (s[i++] - '0');
+  if (i < s.size() && (s[i] == 'K' || s[i] == 'k')) size <<= 10;
+  else if (i < s.size() && (s[i] == 'M' || s[i] == 'm')) size <<= 20;
+  else if (i < s.size() && (s[i] == 'G' || s[i] == 'g')) size <<= 30;
+  return size;
+}
+
+// Counts the CPUs in a list such as "0-7,16-23"
+inline size_t count_cpu_list(const std::string& s) {
+  size_t count = 0, i = 0;
+  while (i < s.size()) {
+    size_t first = 0, last;
+    while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) first = 10 * first + (s[i++] - '0');
+    last = first;
+    if (i < s.size() && s[i] == '-') {
+      last = 0;
+      i++;
+      while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) last = 10 * last + (s[i++] - '0');
+    }
+    count += last - first + 1;
+    while (i < s.size() && !std::isdigit(static_cast<unsigned char>(s[i]))) i++;
+  }
+  return count;
+}
+
+inline hardware_profile detect_hardware_profile() {
+  hardware_profile p;
+#if defined(__linux__)
+  for (int i = 0; ; i++) {
+    std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + "/";
+    std::ifstream level_file(dir + "level");
+    if (!level_file.is_open()) break;
+    int level = 0;
+    std::string type, size, shared;
+    level_file >> level;
+    std::ifstream(dir + "type") >> type;
+    std::ifstream(dir + "size") >> size;
+    std::ifstream(dir + "shared_cpu_list") >> shared;
+    if (type == "Instruction") continue;
+    size_t bytes = parse_cache_size(size);
+    size_t cpus = (std::max)(count_cpu_list(shared), size_t{1});
+    if (level == 1) p.l1d_size = bytes;
+    else if (level == 2) { p.l2_size = bytes; p.cpus_per_l2 = cpus; }
+    else if (level == 3) { p.l3_size = bytes; p.cpus_per_l3 = cpus; }
+  }
+#endif
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+  if (p.l1d_size == 0) p.l1d_size = static_cast<size_t>((std::max)(sysconf(_SC_LEVEL1_DCACHE_SIZE), 0L));
+  if (p.l2_size == 0) p.l2_size = static_cast<size_t>((std::max)(sysconf(_SC_LEVEL2_CACHE_SIZE), 0L));
+  if (p.l3_size == 0) p.l3_size = static_cast<size_t>((std::max)(sysconf(_SC_LEVEL3_CACHE_SIZE), 0L));
+#endif
+  if (p.l1d_size == 0) p.l1d_size = DEFAULT_L1D_SIZE;
+  if (p.l2_size == 0) p.l2_size = DEFAULT_L2_SIZE;
+  if (p.l3_size == 0) {
+    p.l3_size = DEFAULT_L3_SIZE;
+    p.cpus_per_l3 = DEFAULT_CPUS_PER_L3;
+  }
+  return p;
+}
+
+inline hardware_profile& hardware_profile_storage() {
+  static hardware_profile profile = detect_hardware_profile();
+  return profile;
+}
+
+}  // namespace internal
+
+// Returns the profile of the machine, which is detected the first time
+// it is needed unless it has been set with set_hardware_profile
+inline const hardware_profile& get_hardware_profile() {
+  return internal::hardware_profile_storage();
+}
+
+// Overrides the detected profile. This must not be called while any
+// parallel algorithms are running.
+inline void set_hardware_profile(const hardware_profile& profile) {
+  internal::hardware_profile_storage() = profile;
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_HARDWARE_H_
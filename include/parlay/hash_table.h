@@ -4,11 +4,15 @@
 
 #include <cstddef>
 
+#include <algorithm>
 #include <atomic>
 #include <iostream>
+#include <iterator>
 
 #include "delayed_sequence.h"
 #include "parallel.h"
+#include "portability.h"
+#include "range.h"
 #include "sequence.h"
 #include "slice.h"
 #include "utilities.h"
@@ -59,24 +63,38 @@ class hashtable {
   }
   bool lessEqIndex(index a, index b) { return a == b || lessIndex(a, b); }
 
- public:
-  // Size is the maximum number of values the hash table will hold.
-  // Overfilling the table could put it into an infinite loop.
-  hashtable(size_t size, HASH hashF, double load = 1.5)
-    : m(100 + static_cast<size_t>(load * static_cast<double>(size))),
-      empty(hashF.empty()),
-      hashStruct(hashF),
-      TA(sequence<eType>(m, empty)) {
+  // the following parameters can be tuned
+  static constexpr size_t batch_block_size = 512;
+  static constexpr size_t prefetch_distance = 16;
+
+  // Calls f(j, h) on every j in [0, n) in parallel, where h is the first
+  // index to probe for the jth key, key(j). The keys are processed in
+  // blocks, whose hashes are all computed first, so that the slots a
+  // few keys ahead can be prefetched while each key is being probed.
+  // This overlaps the cache misses of many probes instead of taking
+  // them one at a time.
+  template <typename GetKey, typename F>
+  void for_each_prefetched(size_t n, GetKey&& key, F&& f, bool write) {
+    size_t num_blocks = (n + batch_block_size - 1) / batch_block_size;
+    parallel_for(0, num_blocks, [&](size_t b) {
+      size_t start = b * batch_block_size;
+      size_t len = (std::min)(batch_block_size, n - start);
+      index h[batch_block_size];
+      for (size_t j = 0; j < len; j++) h[j] = firstIndex(key(start + j));
+      for (size_t j = 0; j < (std::min)(prefetch_distance, len); j++) prefetch_slot(h[j], write);
+      for (size_t j = 0; j < len; j++) {
+        if (j + prefetch_distance < len) prefetch_slot(h[j + prefetch_distance], write);
+        f(start + j, h[j]);
+      }
+    }, 1);
   }
 
-  ~hashtable() { };
+  void prefetch_slot(index h, bool write) {
+    if (write) PARLAY_PREFETCH(TA.data() + h, 1, 1);
+    else PARLAY_PREFETCH(TA.data() + h, 0, 1);
+  }
 
-  // prioritized linear probing
-  //   a new key will bump an existing key up if it has a higher priority
-  //   an equal key will replace an old key if replaceQ(new,old) is true
-  // returns 0 if not inserted (i.e. equal and replaceQ false) and 1 otherwise
-  bool insert(eType v) {
-    index i = firstIndex(hashStruct.getKey(v));
+  bool insert_from(eType v, index i) {
     while (true) {
       eType c = TA[i];
       if (c == empty) {
@@ -98,37 +116,7 @@ class hashtable {
     }
   }
 
-  // prioritized linear probing
-  //   a new key will bump an existing key up if it has a higher priority
-  //   an equal key will replace an old key if replaceQ(new,old) is true
-  // returns 0 if not inserted (i.e. equal and replaceQ false) and 1 otherwise
-  bool update(eType v) {
-    index i = firstIndex(hashStruct.getKey(v));
-    while (true) {
-      eType c = TA[i];
-      if (c == empty) {
-        if (hashStruct.cas(&TA[i], c, v)) return true;
-      } else {
-        int cmp = hashStruct.cmp(hashStruct.getKey(v), hashStruct.getKey(c));
-        if (cmp == 0) {
-          if (!hashStruct.replaceQ(v, c))
-            return false;
-          else {
-            eType new_val = hashStruct.update(c, v);
-            if (hashStruct.cas(&TA[i], c, new_val)) return true;
-          }
-        } else if (cmp < 0)
-          i = incrementIndex(i);
-        else if (hashStruct.cas(&TA[i], c, v)) {
-          v = c;
-          i = incrementIndex(i);
-        }
-      }
-    }
-  }
-
-  bool deleteVal(kType v) {
-    index i = firstIndex(v);
+  bool delete_from(kType v, index i) {
     int cmp;
 
     // find first element less than or equal to v in priority order
@@ -203,11 +191,7 @@ class hashtable {
     }
   }
 
-  // Returns the value if an equal value is found in the table
-  // otherwise returns the "empty" element.
-  // due to prioritization, can quit early if v is greater than cell
-  eType find(kType v) {
-    index h = firstIndex(v);
+  eType find_from(kType v, index h) {
     eType c = TA[h];
     while (true) {
       if (c == empty) return empty;
@@ -223,10 +207,103 @@ class hashtable {
     }
   }
 
+ public:
+  // Size is the maximum number of values the hash table will hold.
+  // Overfilling the table could put it into an infinite loop.
+  hashtable(size_t size, HASH hashF, double load = 1.5)
+    : m(100 + static_cast<size_t>(load * static_cast<double>(size))),
+      empty(hashF.empty()),
+      hashStruct(hashF),
+      TA(sequence<eType>(m, empty)) {
+  }
+
+  ~hashtable() { };
+
+  // prioritized linear probing
+  //   a new key will bump an existing key up if it has a higher priority
+  //   an equal key will replace an old key if replaceQ(new,old) is true
+  // returns 0 if not inserted (i.e. equal and replaceQ false) and 1 otherwise
+  bool insert(eType v) { return insert_from(v, firstIndex(hashStruct.getKey(v))); }
+
+  // prioritized linear probing
+  //   a new key will bump an existing key up if it has a higher priority
+  //   an equal key will replace an old key if replaceQ(new,old) is true
+  // returns 0 if not inserted (i.e. equal and replaceQ false) and 1 otherwise
+  bool update(eType v) {
+    index i = firstIndex(hashStruct.getKey(v));
+    while (true) {
+      eType c = TA[i];
+      if (c == empty) {
+        if (hashStruct.cas(&TA[i], c, v)) return true;
+      } else {
+        int cmp = hashStruct.cmp(hashStruct.getKey(v), hashStruct.getKey(c));
+        if (cmp == 0) {
+          if (!hashStruct.replaceQ(v, c))
+            return false;
+          else {
+            eType new_val = hashStruct.update(c, v);
+            if (hashStruct.cas(&TA[i], c, new_val)) return true;
+          }
+        } else if (cmp < 0)
+          i = incrementIndex(i);
+        else if (hashStruct.cas(&TA[i], c, v)) {
+          v = c;
+          i = incrementIndex(i);
+        }
+      }
+    }
+  }
+
+  bool deleteVal(kType v) { return delete_from(v, firstIndex(v)); }
+
+  // Returns the value if an equal value is found in the table
+  // otherwise returns the "empty" element.
+  // due to prioritization, can quit early if v is greater than cell
+  eType find(kType v) { return find_from(v, firstIndex(v)); }
+
+  // Batched versions of insert, find and deleteVal, which are much faster
+  // than calling the single versions in a parallel loop when the table
+  // is much larger than the cache, since they prefetch the slots to be
+  // probed. The same phase restrictions apply as for the single versions.
+
+  // Inserts every value of the range, and returns how many were inserted
+  template <typename R>
+  size_t insert_batch(const R& values) {
+    static_assert(is_random_access_range_v<R>);
+    auto it = std::begin(values);
+    size_t n = parlay::size(values);
+    sequence<bool> inserted(n);
+    for_each_prefetched(n, [&](size_t j) { return hashStruct.getKey(it[j]); },
+                        [&](size_t j, index h) { inserted[j] = insert_from(it[j], h); }, true);
+    return internal::reduce(delayed_seq<size_t>(n, [&](size_t j) -> size_t { return inserted[j]; }),
+                            plus<size_t>());
+  }
+
+  // Returns the result of find for every key of the range
+  template <typename R>
+  sequence<eType> find_batch(const R& keys) {
+    static_assert(is_random_access_range_v<R>);
+    auto it = std::begin(keys);
+    size_t n = parlay::size(keys);
+    auto result = sequence<eType>::uninitialized(n);
+    for_each_prefetched(n, [&](size_t j) -> kType { return it[j]; },
+                        [&](size_t j, index h) { assign_uninitialized(result[j], find_from(it[j], h)); }, false);
+    return result;
+  }
+
+  // Deletes every key of the range
+  template <typename R>
+  void erase_batch(const R& keys) {
+    static_assert(is_random_access_range_v<R>);
+    auto it = std::begin(keys);
+    for_each_prefetched(parlay::size(keys), [&](size_t j) -> kType { return it[j]; },
+                        [&](size_t j, index h) { delete_from(it[j], h); }, true);
+  }
+
   // returns the number of entries
   size_t count() {
     auto is_full = [&](size_t i) -> size_t { return (TA[i] == empty) ? 0 : 1; };
-    return internal::reduce(delayed_seq<size_t>(m, is_full), addm<size_t>());
+    return internal::reduce(delayed_seq<size_t>(m, is_full), plus<size_t>());
   }
 
   // returns all the current entries compacted into a sequence
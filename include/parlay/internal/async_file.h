@@ -0,0 +1,224 @@
+#ifndef PARLAY_INTERNAL_ASYNC_FILE_H_
+#define PARLAY_INTERNAL_ASYNC_FILE_H_
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "file_io.h"
+
+#if defined(PARLAY_POSIX_FILE_IO) && !defined(PARLAY_USE_FALLBACK_FILE_IO)
+#define PARLAY_POSIX_ASYNC_FILE
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include) && !defined(PARLAY_USE_FALLBACK_ASYNC_IO)
+#if __has_include(<linux/io_uring.h>)
+#define PARLAY_IO_URING
+#include "linux/io_uring_queue.h"
+#endif
+#endif
+
+#else
+#include <fstream>
+#endif
+
+namespace parlay {
+
+// A file supporting asynchronous positioned reads and writes.  Each read
+// or write either returns a future for the number of bytes transferred,
+// or takes a callback that is given the number of bytes transferred, or
+// a negative error number (-errno) on failure.
+//
+// On Linux, requests go through io_uring and complete on a background
+// thread, so the caller can keep computing while they are in flight.
+// Callbacks then run on that thread, so they should be short (e.g.,
+// fulfil a promise or enqueue work) and must not themselves run parallel
+// algorithms.  A callback may issue further requests, but must not wait
+// for any (with wait() or a future), since they complete on its thread.  Where io_uring is unavailable, or if PARLAY_USE_FALLBACK_ASYNC_IO
+// is defined, every request is performed synchronously with pread/pwrite
+// by the caller before it returns.
+//
+// Buffers must stay valid until their request completes.  Destroying the
+// file waits for all of its outstanding requests (including their
+// callbacks), so a callback must not destroy the file it belongs to.
+class async_file {
+ public:
+  enum class mode { read, write, read_write };
+
+  // Opens a file for reading, or for writing (creating or truncating it),
+  // or for both (creating it if needed)
+  explicit async_file(const std::string& filename, mode m = mode::read) : pending(std::make_shared<pending_state>()) {
+#ifdef PARLAY_POSIX_ASYNC_FILE
+    int flags = (m == mode::read) ? O_RDONLY : (m == mode::write) ? (O_WRONLY | O_CREAT | O_TRUNC) : (O_RDWR | O_CREAT);
+    fd = ::open(filename.c_str(), flags, 0644);
+#ifdef PARLAY_IO_URING
+    if (fd != -1 && internal::get_io_uring_queue().is_open()) queue = &internal::get_io_uring_queue();
+#endif
+#else
+    auto flags = std::ios::binary | ((m == mode::read) ? std::ios::in : (m == mode::write) ? (std::ios::out | std::ios::trunc) : (std::ios::in | std::ios::out));
+    if (m == mode::read_write) std::ofstream(filename, std::ios::app | std::ios::binary);
+    file.open(filename, flags);
+#endif
+  }
+
+  ~async_file() {
+    wait();
+#ifdef PARLAY_POSIX_ASYNC_FILE
+    if (fd != -1) ::close(fd);
+#endif
+  }
+
+  async_file(const async_file&) = delete;
+  async_file& operator=(const async_file&) = delete;
+
+#ifdef PARLAY_POSIX_ASYNC_FILE
+  bool is_open() const { return fd != -1; }
+#else
+  bool is_open() const { return file.is_open(); }
+#endif
+
+  // True if requests complete asynchronously rather than on submission
+  bool is_async() const {
+#ifdef PARLAY_IO_URING
+    return queue != nullptr;
+#else
+    return false;
+#endif
+  }
+
+  // The current size of the file in bytes
+  size_t size() {
+#ifdef PARLAY_POSIX_ASYNC_FILE
+    struct stat sb;
+    [[maybe_unused]] int res = ::fstat(fd, &sb);
+    assert(res == 0);
+    return static_cast<size_t>(sb.st_size);
+#else
+    std::lock_guard<std::mutex> lock(file_lock);
+    file.seekg(0, std::ios::end);
+    return static_cast<size_t>(file.tellg());
+#endif
+  }
+
+  // Reads up to n bytes starting at offset into buf.  Fewer than n bytes
+  // are read only if the end of the file is reached.
+  template<typename F>
+  void read(char* buf, size_t n, size_t offset, F&& on_complete) {
+    submit(false, buf, n, offset, std::forward<F>(on_complete));
+  }
+
+  std::future<size_t> read(char* buf, size_t n, size_t offset) {
+    return submit_future(false, buf, n, offset);
+  }
+
+  // Writes n bytes from buf to the file starting at offset
+  template<typename F>
+  void write(const char* buf, size_t n, size_t offset, F&& on_complete) {
+    submit(true, const_cast<char*>(buf), n, offset, std::forward<F>(on_complete));
+  }
+
+  std::future<size_t> write(const char* buf, size_t n, size_t offset) {
+    return submit_future(true, const_cast<char*>(buf), n, offset);
+  }
+
+  // Waits until all requests on this file have completed
+  void wait() {
+    std::unique_lock<std::mutex> lock(pending->m);
+    pending->cv.wait(lock, [&]() { return pending->count == 0; });
+  }
+
+ private:
+  struct pending_state {
+    std::mutex m;
+    std::condition_variable cv;
+    size_t count = 0;
+  };
+
+  std::shared_ptr<pending_state> pending;
+#ifdef PARLAY_POSIX_ASYNC_FILE
+  int fd = -1;
+#else
+  std::fstream file;
+  std::mutex file_lock;
+#endif
+#ifdef PARLAY_IO_URING
+  internal::io_uring_queue* queue = nullptr;
+#endif
+
+  template<typename F>
+  void submit(bool write, char* buf, size_t n, size_t offset, F&& on_complete) {
+    assert(is_open());
+#ifdef PARLAY_IO_URING
+    if (queue != nullptr) {
+      {
+        std::lock_guard<std::mutex> lock(pending->m);
+        pending->count++;
+      }
+      queue->submit(write, fd, buf, n, offset,
+          [p = pending, f = std::forward<F>(on_complete)](std::ptrdiff_t result) mutable {
+        f(result);
+        {
+          std::lock_guard<std::mutex> lock(p->m);
+          p->count--;
+        }
+        p->cv.notify_all();
+      });
+      return;
+    }
+#endif
+    on_complete(transfer(write, buf, n, offset));
+  }
+
+  std::future<size_t> submit_future(bool write, char* buf, size_t n, size_t offset) {
+    std::promise<size_t> promise;
+    auto result = promise.get_future();
+    submit(write, buf, n, offset, [promise = std::move(promise)](std::ptrdiff_t r) mutable {
+      if (r < 0) promise.set_exception(std::make_exception_ptr(
+          std::system_error(static_cast<int>(-r), std::generic_category())));
+      else promise.set_value(static_cast<size_t>(r));
+    });
+    return result;
+  }
+
+  // Performs a request synchronously
+  std::ptrdiff_t transfer(bool write, char* buf, size_t n, size_t offset) {
+#ifdef PARLAY_POSIX_ASYNC_FILE
+    size_t done = 0;
+    while (done < n) {
+      auto r = write ? ::pwrite(fd, buf + done, n - done, static_cast<off_t>(offset + done))
+                     : ::pread(fd, buf + done, n - done, static_cast<off_t>(offset + done));
+      if (r == -1 && errno == EINTR) continue;
+      if (r == -1) return -errno;
+      if (r == 0) break;
+      done += static_cast<size_t>(r);
+    }
+    return static_cast<std::ptrdiff_t>(done);
+#else
+    std::lock_guard<std::mutex> lock(file_lock);
+    file.clear();
+    if (write) {
+      file.seekp(static_cast<std::streamoff>(offset));
+      file.write(buf, static_cast<std::streamsize>(n));
+      return file ? static_cast<std::ptrdiff_t>(n) : -EIO;
+    }
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(buf, static_cast<std::streamsize>(n));
+    return static_cast<std::ptrdiff_t>(file.gcount());
+#endif
+  }
+};
+
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_ASYNC_FILE_H_
@@ -0,0 +1,242 @@
+#ifndef PARLAY_INTERNAL_CHAR_SCAN_H_
+#define PARLAY_INTERNAL_CHAR_SCAN_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../monoid.h"
+#include "../parallel.h"
+#include "../sequence.h"
+#include "../slice.h"
+
+#include "sequence_ops.h"
+
+namespace parlay {
+namespace internal {
+
+// Finding the positions of characters of a given class in a character
+// array, 64 positions at a time.  Each 64 bytes are compared against the
+// class with vector instructions (32 bytes per instruction with AVX2, 16
+// with SSE2) to produce a 64-bit mask, and positions are then read off the
+// masks with popcount and count-trailing-zeros.
+
+#if defined(__AVX2__)
+using simd_bytes = __m256i;
+constexpr size_t simd_width = 32;
+inline simd_bytes simd_load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline simd_bytes simd_set1(char c) { return _mm256_set1_epi8(c); }
+inline simd_bytes simd_eq(simd_bytes a, simd_bytes b) { return _mm256_cmpeq_epi8(a, b); }
+inline simd_bytes simd_or(simd_bytes a, simd_bytes b) { return _mm256_or_si256(a, b); }
+inline simd_bytes simd_sub(simd_bytes a, simd_bytes b) { return _mm256_sub_epi8(a, b); }
+inline simd_bytes simd_min_unsigned(simd_bytes a, simd_bytes b) { return _mm256_min_epu8(a, b); }
+inline uint64_t simd_movemask(simd_bytes a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#elif defined(__SSE2__)
+using simd_bytes = __m128i;
+constexpr size_t simd_width = 16;
+inline simd_bytes simd_load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline simd_bytes simd_set1(char c) { return _mm_set1_epi8(c); }
+inline simd_bytes simd_eq(simd_bytes a, simd_bytes b) { return _mm_cmpeq_epi8(a, b); }
+inline simd_bytes simd_or(simd_bytes a, simd_bytes b) { return _mm_or_si128(a, b); }
+inline simd_bytes simd_sub(simd_bytes a, simd_bytes b) { return _mm_sub_epi8(a, b); }
+inline simd_bytes simd_min_unsigned(simd_bytes a, simd_bytes b) { return _mm_min_epu8(a, b); }
+inline uint64_t simd_movemask(simd_bytes a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+#endif
+
+// Matches ' ', '\t', '\n', '\v', '\f' and '\r', i.e., std::isspace in the C locale
+struct whitespace_matcher {
+  bool operator()(char c) const {
+    auto u = static_cast<unsigned char>(c);
+    return u == ' ' || static_cast<unsigned char>(u - '\t') <= 4;
+  }
+#if defined(__AVX2__) || defined(__SSE2__)
+  simd_bytes operator()(simd_bytes x) const {
+    simd_bytes t = simd_sub(x, simd_set1('\t'));
+    return simd_or(simd_eq(x, simd_set1(' ')), simd_eq(simd_min_unsigned(t, simd_set1(4)), t));
+  }
+#endif
+};
+
+// Matches a single given character
+struct byte_matcher {
+  char c;
+  bool operator()(char x) const { return x == c; }
+#if defined(__AVX2__) || defined(__SSE2__)
+  simd_bytes operator()(simd_bytes x) const { return simd_eq(x, simd_set1(c)); }
+#endif
+};
+
+// Matches every byte except zero, e.g., the true values of an array of bools
+struct nonzero_matcher {
+  bool operator()(char x) const { return x != 0; }
+#if defined(__AVX2__) || defined(__SSE2__)
+  simd_bytes operator()(simd_bytes x) const {
+    simd_bytes zero = simd_set1(0);
+    return simd_eq(simd_eq(x, zero), zero);
+  }
+#endif
+};
+
+inline size_t popcount64(uint64_t x) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_popcountll(x));
+#else
+  size_t c = 0;
+  for (; x != 0; x &= x - 1) c++;
+  return c;
+#endif
+}
+
+inline size_t count_trailing_zeros64(uint64_t x) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctzll(x));
+#else
+  size_t i = 0;
+  while (!(x & 1)) { x >>= 1; i++; }
+  return i;
+#endif
+}
+
+// Bit i of the result is the xor of bits 0 through i of x, e.g., given
+// the mask of quote characters, it marks the positions inside quotes
+inline uint64_t prefix_xor64(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// Returns the mask of which of the 64 bytes starting at p match m
+template<typename Matcher>
+uint64_t match_mask(const char* p, const Matcher& m) {
+#if defined(__AVX2__) || defined(__SSE2__)
+  uint64_t mask = 0;
+  for (size_t i = 0; i < 64; i += simd_width)
+    mask |= simd_movemask(m(simd_load(p + i))) << i;
+  return mask;
+#else
+  uint64_t mask = 0;
+  for (size_t i = 0; i < 64; i++) mask |= static_cast<uint64_t>(m(p[i])) << i;
+  return mask;
+#endif
+}
+
+// As above, but only the first len < 64 bytes are read, and the
+// remaining positions are set to pad
+template<typename Matcher>
+uint64_t match_mask(const char* p, size_t len, const Matcher& m, bool pad) {
+  char buf[64] = {};
+  if (len > 0) std::memcpy(buf, p, len);
+  uint64_t mask = (len == 0) ? 0 : match_mask(buf, m) & ((~uint64_t{0}) >> (64 - len));
+  if (pad) mask |= (len == 0) ? ~uint64_t{0} : ((~uint64_t{0}) << len);
+  return mask;
+}
+
+// Number of 64-byte words handled by one parallel task
+constexpr size_t char_scan_block_words = 64;
+
+// Calls f(i) for each position i in [0, n) of s that matches m,
+// in increasing order
+template<typename Matcher, typename F>
+void for_each_match(const char* s, size_t n, size_t word_lo, size_t word_hi, const Matcher& m, F&& f) {
+  for (size_t w = word_lo; w < word_hi; w++) {
+    size_t start = 64 * w;
+    uint64_t mask = (start + 64 <= n) ? match_mask(s + start, m) : match_mask(s + start, n - start, m, false);
+    for (; mask != 0; mask &= mask - 1) f(start + count_trailing_zeros64(mask));
+  }
+}
+
+// Returns the positions in [0, n) of s that match m, in increasing order
+template<typename Matcher>
+sequence<size_t> match_positions(const char* s, size_t n, const Matcher& m) {
+  size_t num_words = (n + 63) / 64;
+  size_t num_blocks = (num_words + char_scan_block_words - 1) / char_scan_block_words;
+  auto block_range = [&](size_t b) {
+    return std::make_pair(b * char_scan_block_words, (std::min)(num_words, (b + 1) * char_scan_block_words));
+  };
+  auto counts = tabulate(num_blocks, [&](size_t b) {
+    auto [lo, hi] = block_range(b);
+    size_t c = 0;
+    for (size_t w = lo; w < hi; w++) {
+      size_t start = 64 * w;
+      c += popcount64((start + 64 <= n) ? match_mask(s + start, m) : match_mask(s + start, n - start, m, false));
+    }
+    return c;
+  }, 1);
+  size_t total = scan_inplace(make_slice(counts), plus<size_t>());
+  auto result = sequence<size_t>::uninitialized(total);
+  parallel_for(0, num_blocks, [&](size_t b) {
+    auto [lo, hi] = block_range(b);
+    size_t k = counts[b];
+    for_each_match(s, n, lo, hi, m, [&](size_t i) { result[k++] = i; });
+  }, 1);
+  return result;
+}
+
+// Returns the start positions and end positions (one past the last
+// character) of the tokens of s, i.e., the maximal runs of characters
+// that do not match is_space, in increasing order
+template<typename Matcher>
+std::pair<sequence<size_t>, sequence<size_t>> token_bounds(const char* s, size_t n, const Matcher& is_space) {
+  // The words cover the positions [0, n], where position n, and any
+  // beyond it, count as space so that a token at the end is terminated
+  size_t num_words = n / 64 + 1;
+  size_t num_blocks = (num_words + char_scan_block_words - 1) / char_scan_block_words;
+
+  // Calls f(start_mask, end_mask, position of bit 0) for each word of block b
+  auto for_each_word = [&](size_t b, auto&& f) {
+    size_t lo = b * char_scan_block_words;
+    size_t hi = (std::min)(num_words, lo + char_scan_block_words);
+    // whether the character before the block is a space (or there is none)
+    uint64_t prev = (lo == 0) ? 1 : static_cast<uint64_t>(is_space(s[64 * lo - 1]));
+    for (size_t w = lo; w < hi; w++) {
+      size_t start = 64 * w;
+      uint64_t sp = (start + 64 <= n) ? match_mask(s + start, is_space) : match_mask(s + start, n - start, is_space, true);
+      uint64_t shifted = (sp << 1) | prev;
+      f(~sp & shifted, sp & ~shifted, start);
+      prev = sp >> 63;
+    }
+  };
+
+  using ipair = std::pair<size_t, size_t>;
+  auto counts = tabulate(num_blocks, [&](size_t b) {
+    ipair c(0, 0);
+    for_each_word(b, [&](uint64_t starts, uint64_t ends, size_t) {
+      c.first += popcount64(starts);
+      c.second += popcount64(ends);
+    });
+    return c;
+  }, 1);
+  auto add = make_monoid([](ipair a, ipair b) { return ipair(a.first + b.first, a.second + b.second); }, ipair(0, 0));
+  auto total = scan_inplace(make_slice(counts), add);
+  assert(total.first == total.second);
+
+  auto starts = sequence<size_t>::uninitialized(total.first);
+  auto ends = sequence<size_t>::uninitialized(total.second);
+  parallel_for(0, num_blocks, [&](size_t b) {
+    size_t i = counts[b].first, j = counts[b].second;
+    for_each_word(b, [&](uint64_t st, uint64_t en, size_t start) {
+      for (; st != 0; st &= st - 1) starts[i++] = start + count_trailing_zeros64(st);
+      for (; en != 0; en &= en - 1) ends[j++] = start + count_trailing_zeros64(en);
+    });
+  }, 1);
+  return std::make_pair(std::move(starts), std::move(ends));
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_CHAR_SCAN_H_
@@ -2,13 +2,17 @@
 #define PARLAY_COLLECT_REDUCE_H_
 
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 
 #include <algorithm>
+#include <limits>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "../hardware.h"
 #include "../parallel.h"
 #include "../sequence.h"
 #include "../slice.h"
@@ -73,6 +77,71 @@ auto collect_reduce_few(Seq const &A, Helper const &helper, size_t num_buckets)
     return o_val; }, 1);
 }
 
+// Samples 2^bits of the n keys key_at(i) into a hash table, and returns a
+// table (of size 4 * 2^bits) holding each key that appears at least
+// copy_cutoff times in the sample, numbered consecutively from 0, along
+// with how many such heavy keys there are.
+template <typename key_type, typename KeyAt, typename Hash, typename Equal>
+std::pair<sequence<std::pair<key_type, int>>, size_t>
+sample_heavy_keys(size_t n, KeyAt const &key_at, Hash const &hash, Equal const &equal, size_t bits) {
+  using KI = std::pair<key_type, int>;
+  size_t num_buckets = size_t{1} << bits;
+  int copy_cutoff = 5; // number of copies in sample to be considered a heavy hitter
+  size_t num_samples = num_buckets;
+  size_t table_size = 4 * num_samples;
+  size_t table_mask = table_size - 1;
+
+  auto hash_table_count = sequence<KI>(table_size, std::make_pair(key_type(), -1));
+
+  // insert sample into hash table with one less than the
+  // count of how many times appears (since it starts with -1)
+  for (size_t i = 0; i < num_samples; i++) {
+    const auto& s = key_at(hash64(i) % n);
+    size_t idx = hash(s) & table_mask;
+    while (1) {
+      if (hash_table_count[idx].second == -1) {
+        hash_table_count[idx] = std::make_pair(s, 0);
+        break;
+      } else if (equal(hash_table_count[idx].first, s)) {
+        hash_table_count[idx].second += 1;
+        break;
+      } else
+        idx = (idx + 1) & table_mask;
+    }
+  }
+
+  // add to the hash table if at least copy_cutoff copies appear in sample
+  // give added items consecutive numbers.
+  size_t heavy_hitters = 0;
+  auto hash_table = sequence<KI>(table_size, std::make_pair(key_type(), -1));
+  for (size_t i = 0; i < table_size; i++) {
+    if (hash_table_count[i].second + 2 > copy_cutoff) {
+      key_type key = hash_table_count[i].first;
+      size_t idx = hash(key) & table_mask;
+      if (hash_table[idx].second == -1)
+        hash_table[idx] = std::make_pair(key, heavy_hitters++);
+    }
+  }
+  return std::make_pair(std::move(hash_table), heavy_hitters);
+}
+
+// The bucket for a key with the given hash value.
+// uses chosen bucket from preprocessing if key appears many times (heavy)
+// otherwise uses one of the remaining buckets
+template <typename KI, typename key_type, typename Equal>
+size_t heavy_key_bucket(sequence<KI> const &hash_table, size_t heavy_hitters, size_t bucket_mask,
+                        key_type const &key, size_t hash_val, Equal const &equal) {
+  if (heavy_hitters > 0) {
+    auto &h = hash_table[hash_val & (hash_table.size() - 1)];
+    if (h.second != -1 && equal(h.first, key)) return h.second;
+    hash_val = hash_val & bucket_mask;
+    if (hash_val < heavy_hitters)
+      return hash_val % (bucket_mask+1-heavy_hitters) + heavy_hitters;
+    return hash_val;
+  }
+  return hash_val & bucket_mask;
+}
+
 // The idea is to return a hash function that maps any items
 // that appear many times into their own bucket.
 // Otherwise items can end up in the same bucket.
@@ -87,7 +156,6 @@ struct get_bucket {
   using key_type = typename HashEq::key_type;
   using KI = std::pair<key_type, int>;
   sequence<KI> hash_table;
-  size_t table_mask;
   size_t bucket_mask;
   size_t heavy_hitters;
   const HashEq hasheq;
@@ -98,64 +166,83 @@ struct get_bucket {
   // heavy_hitters will indicate how many of these there are
   template <typename Seq>
   get_bucket(Seq const &A, HashEq const &hasheq, size_t bits) : hasheq(hasheq) {
-    size_t n = A.size();
-    size_t num_buckets = size_t{1} << bits;
-    int copy_cutoff = 5; // number of copies in sample to be considered a heavy hitter
-    size_t num_samples = num_buckets;
-    size_t table_size = 4 * num_samples;
-    table_mask = table_size - 1;
-    bucket_mask = num_buckets - 1;
-
-    auto hash_table_count = sequence<KI>(table_size, std::make_pair(key_type(), -1));
-
-    // insert sample into hash table with one less than the
-    // count of how many times appears (since it starts with -1)
-    for (size_t i = 0; i < num_samples; i++) {
-      const auto& a = A[hash64(i) % n];
-      const auto& s = hasheq.get_key(a);
-      size_t idx = hasheq.hash(s) & table_mask;
-      while (1) {
-        if (hash_table_count[idx].second == -1) {
-          hash_table_count[idx] = std::make_pair(s, 0);
-          break;
-        } else if (hasheq.equal(hash_table_count[idx].first, s)) {
-          hash_table_count[idx].second += 1;
-          break;
-        } else
-          idx = (idx + 1) & table_mask;
-      }
-    }
-
-    // add to the hash table if at least copy_cutoff copies appear in sample
-    // give added items consecutive numbers.   
-    heavy_hitters = 0;
-    hash_table = sequence<KI>(table_size, std::make_pair(key_type(), -1));
-    for (size_t i = 0; i < table_size; i++) {
-      if (hash_table_count[i].second + 2 > copy_cutoff) {
-        key_type key = hash_table_count[i].first;
-        size_t idx = hasheq.hash(key) & table_mask;
-        if (hash_table[idx].second == -1)
-          hash_table[idx] = std::make_pair(key, heavy_hitters++);
-      }
-    }
+    bucket_mask = (size_t{1} << bits) - 1;
+    std::tie(hash_table, heavy_hitters) = sample_heavy_keys<key_type>(A.size(),
+        [&] (size_t i) -> decltype(auto) { return this->hasheq.get_key(A[i]); },
+        [&] (key_type const &k) { return this->hasheq.hash(k); },
+        [&] (key_type const &a, key_type const &b) { return this->hasheq.equal(a, b); }, bits);
   }
 
   // the hash function.
-  // uses chosen bucket from preprocessing if key appears many times (heavy)
-  // otherwise uses one of the remaining buckets
   size_t operator()(in_type const &v) const {
-    //key_type& key = ;
-    auto hash_val = hasheq.hash(hasheq.get_key(v));
-    if (heavy_hitters > 0) {
-      auto &h = hash_table[hash_val & table_mask];
-      if (h.second != -1 && hasheq.equal(h.first, hasheq.get_key(v))) return h.second;
-      hash_val = hash_val & bucket_mask;
-      if ((hash_val & bucket_mask) < heavy_hitters)
-        return hash_val % (bucket_mask+1-heavy_hitters) + heavy_hitters;
-      return hash_val & bucket_mask;
+    const auto& key = hasheq.get_key(v);
+    return heavy_key_bucket(hash_table, heavy_hitters, bucket_mask, key, hasheq.hash(key),
+        [&] (key_type const &a, key_type const &b) { return hasheq.equal(a, b); });
+  }
+};
+
+// A bucketing plan that can be kept across calls to collect_reduce_sparse
+// over inputs with a similar key distribution, so that sampling for heavy
+// keys is not repeated on every call.  Each call checks the bucket sizes it
+// produced, and marks the plan stale if a light bucket grew far beyond the
+// average (a new heavy key) or most heavy keys are no longer heavy.  A stale
+// plan, or one built for a different number of buckets, is resampled from
+// the input of the next call.  A plan must not be used by concurrent calls.
+template <typename key_type, typename Hash, typename Equal>
+struct bucket_plan_ {
+  using KI = std::pair<key_type, int>;
+
+  explicit bucket_plan_(Hash hash_ = {}, Equal equal_ = {})
+      : hash(std::move(hash_)), equal(std::move(equal_)) {}
+
+  // Forces the next call using this plan to resample
+  void invalidate() { is_stale = true; }
+
+  bool stale() const { return is_stale; }
+  size_t num_buckets() const { return bucket_mask + 1; }
+  size_t num_heavy_keys() const { return heavy_hitters; }
+
+  // The number of times the plan has been (re)built
+  size_t num_samplings() const { return samplings; }
+
+  const Hash& hash_function() const { return hash; }
+  const Equal& key_eq() const { return equal; }
+
+  // Used by collect_reduce_sparse
+
+  template <typename KeyAt>
+  void resample(size_t n, KeyAt const &key_at, size_t bits) {
+    bucket_mask = (size_t{1} << bits) - 1;
+    std::tie(hash_table, heavy_hitters) = sample_heavy_keys<key_type>(n, key_at, hash, equal, bits);
+    is_stale = false;
+    samplings++;
+  }
+
+  size_t operator()(key_type const &key) const {
+    return heavy_key_bucket(hash_table, heavy_hitters, bucket_mask, key, hash(key), equal);
+  }
+
+  template <typename Offsets>
+  void observe(Offsets const &bucket_offsets) {
+    size_t nb = num_buckets();
+    size_t avg = bucket_offsets[nb] / nb;
+    size_t faded = 0;
+    for (size_t i = 0; i < nb; i++) {
+      size_t size = bucket_offsets[i + 1] - bucket_offsets[i];
+      if (i < heavy_hitters) faded += (size < avg);
+      else if (size > 8 * avg + 64) is_stale = true;
     }
-    return hash_val & bucket_mask;
+    if (2 * faded > heavy_hitters) is_stale = true;
   }
+
+ private:
+  Hash hash;
+  Equal equal;
+  sequence<KI> hash_table;
+  size_t bucket_mask = 0;
+  size_t heavy_hitters = 0;
+  size_t samplings = 0;
+  bool is_stale = true;
 };
 
 template <typename Seq, class Helper>
@@ -166,10 +253,9 @@ auto collect_reduce(Seq const &A, Helper const &helper, size_t num_buckets) {
   //using val_type = typename Helper::val_type;
   using result_type = decltype(helper.init());
 
-  // #bits is selected so each block fits into L3 cache
-  //   assuming an L3 cache of size 1M per thread
+  // #bits is selected so each block fits into each thread's share of the cache
   // the counting sort uses 2 x input size due to copy
-  size_t cache_per_thread = 1000000;
+  size_t cache_per_thread = get_hardware_profile().cache_per_thread();
   size_t bits = std::max<size_t>(
       log2_up(1 + (2 * (size_t) sizeof(T) * n) / cache_per_thread), 4);
   size_t num_blocks = size_t{1} << bits;
@@ -275,40 +361,35 @@ auto seq_collect_reduce_sparse(Slice A, Helper const &helper) {
   return r_s;
 }
 
-// this one is for more buckets than the length of A (i.e. sparse)
-//  A is a sequence of key-value pairs
-//  monoid has fields m.identity and m.f (a binary associative function)
-template <typename assignment_tag, typename Slice, typename Helper>
-auto collect_reduce_sparse_(Slice A, Helper const &helper) {
+// #bits is selected so each block fits into each thread's share of the cache
+// the counting sort uses 2 x input size due to copy
+template <typename in_type>
+size_t collect_reduce_sparse_bits(size_t n) {
+  size_t cache_per_thread = get_hardware_profile().cache_per_thread();
+  size_t bits = log2_up(static_cast<size_t>(
+      1 + (1.2 * 2 * sizeof(in_type) * static_cast<double>(n)) / static_cast<double>(cache_per_thread)));
+  return std::max<size_t>(bits, 4);
+}
+
+// Buckets A with bucket_of (into 2^bits buckets, of which the first
+// heavy_cutoff each hold a single key) and reduces each bucket.
+// observe is given the bucket offsets.
+template <typename assignment_tag, typename Slice, typename Helper, typename GetBucket, typename Observe>
+auto collect_reduce_sparse_buckets(Slice A, Helper const &helper, GetBucket const &bucket_of,
+                                   size_t bits, size_t heavy_cutoff, Observe &&observe) {
   timer t("collect reduce sparse", false);
   using in_type = std::remove_const_t<typename Helper::in_type>;
   size_t n = A.size();
-
-  if (n < 10000) return seq_collect_reduce_sparse<assignment_tag>(A, helper);
-
-  // #bits is selected so each block fits into L3 cache
-  //   assuming an L3 cache of size 1M per thread
-  // the counting sort uses 2 x input size due to copy
-  size_t cache_per_thread = 1000000;
-  size_t bits = log2_up(static_cast<size_t>(
-      1 + (1.2 * 2 * sizeof(in_type) * static_cast<double>(n)) / static_cast<double>(cache_per_thread)));
-  bits = std::max<size_t>(bits, 4);
   size_t num_buckets = (1 << bits);
 
-  // Returns a map (hash) from key to bucket.
-  // Keys with many elements (heavy) have their own bucket while
-  // others share a bucket.
-  auto gb = get_bucket<Helper>(A, helper, bits);
-
   // first bucket based on hash using an integer sort
   uninitialized_sequence<in_type> B(n);
-  auto keys = delayed_tabulate(n, [&] (size_t i) {return gb(A[i]);});
+  auto keys = delayed_tabulate(n, [&] (size_t i) {return bucket_of(A[i]);});
   auto bucket_offsets =
       count_sort<assignment_tag>(make_slice(A), make_slice(B),
                                  make_slice(keys), num_buckets).first;
   t.next("integer sort");
-  // all buckets up to heavy_cutoff have a single key in them
-  size_t heavy_cutoff = gb.heavy_hitters;
+  observe(bucket_offsets);
 
   // now in parallel process each bucket sequentially, returning a sequence
   // of the results within that bucket
@@ -317,6 +398,8 @@ auto collect_reduce_sparse_(Slice A, Helper const &helper) {
   auto tables = tabulate(num_buckets, [&] (size_t i) {
     auto block = make_slice(B).cut(bucket_offsets[i], bucket_offsets[i+1]);
     if (i < heavy_cutoff) {
+      // a reused plan can name a heavy key that this input does not have
+      if (block.size() == 0) return decltype(sequence(1,helper.reduce(block)))();
       auto a = sequence(1,helper.reduce(block));
       if constexpr (!std::is_trivially_destructible_v<in_type>)
         parallel_for(0, block.size(), [&] (size_t i) {block[i].~in_type();}, 1000);
@@ -329,6 +412,138 @@ auto collect_reduce_sparse_(Slice A, Helper const &helper) {
   return flatten(std::move(tables));
 }
 
+// this one is for more buckets than the length of A (i.e. sparse)
+//  A is a sequence of key-value pairs
+//  monoid has fields m.identity and m.f (a binary associative function)
+template <typename assignment_tag, typename Slice, typename Helper>
+auto collect_reduce_sparse_(Slice A, Helper const &helper) {
+  using in_type = std::remove_const_t<typename Helper::in_type>;
+  size_t n = A.size();
+
+  if (n < 10000) return seq_collect_reduce_sparse<assignment_tag>(A, helper);
+
+  size_t bits = collect_reduce_sparse_bits<in_type>(n);
+
+  // Returns a map (hash) from key to bucket.
+  // Keys with many elements (heavy) have their own bucket while
+  // others share a bucket.
+  auto gb = get_bucket<Helper>(A, helper, bits);
+
+  // all buckets up to heavy_cutoff have a single key in them
+  return collect_reduce_sparse_buckets<assignment_tag>(A, helper, gb, bits, gb.heavy_hitters,
+                                                       [] (auto const&) {});
+}
+
+// As above, but buckets with a plan that is resampled only when it is
+// stale or was built for a different number of buckets
+template <typename assignment_tag, typename Slice, typename Helper, typename Plan>
+auto collect_reduce_sparse_(Slice A, Helper const &helper, Plan &plan) {
+  using in_type = std::remove_const_t<typename Helper::in_type>;
+  size_t n = A.size();
+
+  if (n < 10000) return seq_collect_reduce_sparse<assignment_tag>(A, helper);
+
+  size_t bits = collect_reduce_sparse_bits<in_type>(n);
+  if (plan.stale() || plan.num_buckets() != (size_t{1} << bits))
+    plan.resample(n, [&] (size_t i) -> decltype(auto) { return helper.get_key(A[i]); }, bits);
+
+  auto bucket_of = [&] (in_type const &v) { return plan(helper.get_key(v)); };
+  return collect_reduce_sparse_buckets<assignment_tag>(A, helper, bucket_of, bits, plan.num_heavy_keys(),
+      [&] (auto const &bucket_offsets) { plan.observe(bucket_offsets); });
+}
+
+// Groups the key-value pairs of A by key without allocating per group.
+// Returns a tuple of the distinct keys, offsets (one per key, plus a final n)
+// and the values of all groups concatenated in the order of the keys.
+// Uses the same bucketing as collect_reduce_sparse_, then groups each bucket
+// sequentially in place.  Within a group, values are in input order.
+template <typename Slice, typename Helper>
+auto collect_groups_sparse(Slice A, Helper const &helper) {
+  using in_type = std::remove_const_t<typename Helper::in_type>;
+  using key_type = typename Helper::key_type;
+  using val_type = typename Helper::val_type;
+  size_t n = A.size();
+
+  // first bucket based on hash using a counting sort
+  sequence<in_type> B;
+  sequence<size_t> bucket_offsets;
+  size_t heavy_cutoff = 0;
+  if (n < 10000) {
+    B = sequence<in_type>(A.begin(), A.end());
+    bucket_offsets = sequence<size_t>({0, n});
+  } else {
+    size_t bits = collect_reduce_sparse_bits<in_type>(n);
+    auto gb = get_bucket<Helper>(A, helper, bits);
+    heavy_cutoff = gb.heavy_hitters;
+    auto keys = delayed_tabulate(n, [&] (size_t i) {return gb(A[i]);});
+    std::tie(B, bucket_offsets) = count_sort(A, keys, size_t{1} << bits);
+  }
+  size_t num_buckets = bucket_offsets.size() - 1;
+
+  // for each bucket, the position of the first element of each group and the
+  // group sizes, and for each element its group within the bucket
+  auto group_of = sequence<uint32_t>::uninitialized(n);
+  sequence<sequence<uint32_t>> firsts(num_buckets);
+  sequence<sequence<size_t>> sizes(num_buckets);
+  parallel_for(0, num_buckets, [&] (size_t i) {
+    size_t start = bucket_offsets[i];
+    size_t m = bucket_offsets[i + 1] - start;
+    if (m == 0) return;
+    if (i < heavy_cutoff) {
+      firsts[i] = sequence<uint32_t>(1, 0);
+      sizes[i] = sequence<size_t>(1, m);
+      return;
+    }
+    constexpr uint32_t empty = (std::numeric_limits<uint32_t>::max)();
+    size_t table_size = 3 * m / 2 + 1;
+    sequence<uint32_t> table(table_size, empty);
+    auto& first = firsts[i];
+    auto& size = sizes[i];
+    for (size_t j = 0; j < m; j++) {
+      const auto& key = helper.get_key(B[start + j]);
+      size_t k = ((size_t) helper.hash(key)) % table_size;
+      while (table[k] != empty && !helper.equal(helper.get_key(B[start + first[table[k]]]), key))
+        k = (k + 1 == table_size) ? 0 : k + 1;
+      if (table[k] == empty) {
+        table[k] = static_cast<uint32_t>(first.size());
+        first.push_back(static_cast<uint32_t>(j));
+        size.push_back(0);
+      }
+      group_of[start + j] = table[k];
+      size[table[k]]++;
+    }
+  }, 1);
+
+  auto group_starts = internal::map(firsts, [] (auto const& f) { return f.size(); });
+  size_t num_groups = scan_inplace(make_slice(group_starts), plus<size_t>());
+
+  auto keys = sequence<key_type>::uninitialized(num_groups);
+  auto offsets = sequence<size_t>::uninitialized(num_groups + 1);
+  auto values = sequence<val_type>::uninitialized(n);
+  parallel_for(0, num_buckets, [&] (size_t i) {
+    size_t start = bucket_offsets[i];
+    size_t m = bucket_offsets[i + 1] - start;
+    auto& first = firsts[i];
+    auto& size = sizes[i];
+    size_t o = start;
+    for (size_t g = 0; g < first.size(); g++) {
+      assign_uninitialized(keys[group_starts[i] + g], std::move(std::get<0>(B[start + first[g]])));
+      size_t count = size[g];
+      offsets[group_starts[i] + g] = o;
+      size[g] = o;  // now the next position for the group
+      o += count;
+    }
+    if (i < heavy_cutoff)
+      parallel_for(0, m, [&] (size_t j) {
+        assign_uninitialized(values[start + j], std::move(std::get<1>(B[start + j]))); }, 1000);
+    else
+      for (size_t j = 0; j < m; j++)
+        assign_uninitialized(values[size[group_of[start + j]]++], std::move(std::get<1>(B[start + j])));
+  }, 1);
+  offsets[num_groups] = n;
+  return std::make_tuple(std::move(keys), std::move(offsets), std::move(values));
+}
+
 template <typename T, typename Helper>
 auto collect_reduce_sparse(sequence<T> &&A, Helper const &helper) {
   auto r = collect_reduce_sparse_<uninitialized_relocate_tag>(make_slice(A), helper);
@@ -341,6 +556,18 @@ auto collect_reduce_sparse(Range const &A, Helper const &helper) {
   return collect_reduce_sparse_<uninitialized_copy_tag>(make_slice(A), helper);
 }
 
+template <typename T, typename Helper, typename Plan>
+auto collect_reduce_sparse(sequence<T> &&A, Helper const &helper, Plan &plan) {
+  auto r = collect_reduce_sparse_<uninitialized_relocate_tag>(make_slice(A), helper, plan);
+  clear_relocated(A);
+  return r;
+}
+
+template <typename Range, typename Helper, typename Plan>
+auto collect_reduce_sparse(Range const &A, Helper const &helper, Plan &plan) {
+  return collect_reduce_sparse_<uninitialized_copy_tag>(make_slice(A), helper, plan);
+}
+
 } // namespace internal
 
 }  // namespace parlay
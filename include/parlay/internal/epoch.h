@@ -0,0 +1,154 @@
+// Epoch-based memory reclamation for lock-free data structures.
+//
+// A thread announces the current global epoch while it may hold pointers
+// into a shared structure (by holding an epoch_guard). An object that has
+// been unlinked from the structure is retired rather than deleted, and is
+// only deleted once the global epoch has advanced twice since, which can
+// only happen after every thread that could have seen it has left its guard.
+//
+// Each thread gets a slot from a global list the first time it needs one,
+// and hands it back (along with any objects still waiting to be deleted) to
+// be reused by another thread when it exits.
+
+#ifndef PARLAY_INTERNAL_EPOCH_H_
+#define PARLAY_INTERNAL_EPOCH_H_
+
+#include <cstddef>
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+namespace parlay {
+namespace internal {
+
+class epoch_manager {
+ public:
+  static constexpr size_t inactive = (std::numeric_limits<size_t>::max)();
+
+  // the following parameter can be tuned
+  static constexpr size_t retire_threshold = 512;
+
+  struct retired_object {
+    void* p;
+    void (*deleter)(void*);
+    size_t epoch;
+  };
+
+  struct alignas(64) slot {
+    std::atomic<size_t> announced{inactive};
+    std::atomic<bool> in_use{true};
+    size_t depth = 0;
+    std::vector<retired_object> retired;
+    slot* next = nullptr;
+  };
+
+  // Finds a free slot or adds a new one to the list
+  slot* acquire_slot() {
+    for (slot* s = slots.load(std::memory_order_acquire); s != nullptr; s = s->next) {
+      bool expected = false;
+      if (!s->in_use.load(std::memory_order_relaxed) && s->in_use.compare_exchange_strong(expected, true))
+        return s;
+    }
+    slot* s = new slot;
+    s->next = slots.load(std::memory_order_relaxed);
+    while (!slots.compare_exchange_weak(s->next, s)) { }
+    return s;
+  }
+
+  void release_slot(slot* s) {
+    s->in_use.store(false, std::memory_order_release);
+  }
+
+  void enter(slot* s) {
+    if (s->depth++ == 0) {
+      // the epoch could advance between reading and announcing it. The
+      // sequentially consistent store and load order the announcement
+      // before any reads of the structure.
+      size_t e;
+      do {
+        e = epoch.load();
+        s->announced.store(e);
+      } while (epoch.load() != e);
+    }
+  }
+
+  void exit(slot* s) {
+    if (--s->depth == 0) s->announced.store(inactive, std::memory_order_release);
+  }
+
+  void retire(slot* s, void* p, void (*deleter)(void*)) {
+    s->retired.push_back(retired_object{p, deleter, epoch.load()});
+    if (s->retired.size() >= retire_threshold) {
+      try_advance();
+      collect(s);
+    }
+  }
+
+ private:
+  std::atomic<size_t> epoch{0};
+  std::atomic<slot*> slots{nullptr};
+
+  // Advances the epoch if every thread in a guard has seen the current one
+  void try_advance() {
+    size_t e = epoch.load();
+    for (slot* s = slots.load(std::memory_order_acquire); s != nullptr; s = s->next) {
+      size_t a = s->announced.load();
+      if (a != inactive && a != e) return;
+    }
+    epoch.compare_exchange_strong(e, e + 1);
+  }
+
+  // Deletes the objects retired at least two epochs ago
+  void collect(slot* s) {
+    size_t e = epoch.load();
+    size_t j = 0;
+    for (size_t i = 0; i < s->retired.size(); i++) {
+      auto r = s->retired[i];
+      if (r.epoch + 2 <= e) r.deleter(r.p);
+      else s->retired[j++] = r;
+    }
+    s->retired.resize(j);
+  }
+};
+
+// The manager is never destroyed, since threads may still be
+// retiring objects during static destruction
+inline epoch_manager& get_epoch_manager() {
+  static epoch_manager* manager = new epoch_manager;
+  return *manager;
+}
+
+inline epoch_manager::slot* my_epoch_slot() {
+  struct slot_holder {
+    epoch_manager::slot* s = get_epoch_manager().acquire_slot();
+    ~slot_holder() { get_epoch_manager().release_slot(s); }
+  };
+  thread_local slot_holder holder;
+  return holder.s;
+}
+
+// Protects the objects reachable from a shared structure from being
+// deleted while it is alive. Guards can be nested.
+class epoch_guard {
+ public:
+  epoch_guard() : s(my_epoch_slot()) { get_epoch_manager().enter(s); }
+  ~epoch_guard() { get_epoch_manager().exit(s); }
+  epoch_guard(const epoch_guard&) = delete;
+  epoch_guard& operator=(const epoch_guard&) = delete;
+
+ private:
+  epoch_manager::slot* s;
+};
+
+// Deletes p once no thread can be holding a pointer to it. The
+// caller must have already made it unreachable from the structure.
+template <typename T>
+void retire(T* p) {
+  get_epoch_manager().retire(my_epoch_slot(), p, [](void* q) { delete static_cast<T*>(q); });
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_EPOCH_H_
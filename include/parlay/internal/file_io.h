@@ -0,0 +1,257 @@
+#ifndef PARLAY_INTERNAL_FILE_IO_H_
+#define PARLAY_INTERNAL_FILE_IO_H_
+
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32)
+#include <unistd.h>
+#if defined(_POSIX_VERSION)
+#define PARLAY_POSIX_FILE_IO
+#endif
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#if defined(PARLAY_POSIX_FILE_IO) && !defined(PARLAY_USE_FALLBACK_FILE_IO)
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace parlay {
+namespace internal {
+
+// Block size and alignment used for direct (unbuffered) I/O
+constexpr size_t direct_io_alignment = 4096;
+
+#if defined(PARLAY_POSIX_FILE_IO) && !defined(PARLAY_USE_FALLBACK_FILE_IO)
+
+// A file that can be read at arbitrary offsets from many threads at once,
+// using pread on a shared descriptor.  If direct is true, reads bypass the
+// page cache with O_DIRECT where the file system supports it, going through
+// an aligned buffer; otherwise they fall back to ordinary reads.
+class positioned_reader {
+ public:
+  explicit positioned_reader(const std::string& filename, bool direct = false) {
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1) return;
+    struct stat sb;
+    if (::fstat(fd, &sb) == 0) length = static_cast<size_t>(sb.st_size);
+#ifdef O_DIRECT
+    if (direct) direct_fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+#else
+    (void) direct;
+#endif
+  }
+
+  ~positioned_reader() {
+    if (fd != -1) ::close(fd);
+    if (direct_fd != -1) ::close(direct_fd);
+  }
+
+  positioned_reader(const positioned_reader&) = delete;
+  positioned_reader& operator=(const positioned_reader&) = delete;
+
+  bool is_open() const { return fd != -1; }
+  size_t size() const { return length; }
+  bool direct() const { return direct_fd != -1; }
+
+  // Reads up to n bytes at offset into buf, returning the number read,
+  // which is less than n only at the end of the file
+  size_t read(char* buf, size_t n, size_t offset) const {
+    if (direct_fd != -1) {
+      size_t r;
+      if (read_direct(buf, n, offset, r)) return r;
+    }
+    return read_all(fd, buf, n, offset);
+  }
+
+ private:
+  int fd = -1;
+  int direct_fd = -1;
+  size_t length = 0;
+
+  static size_t read_all(int f, char* buf, size_t n, size_t offset) {
+    size_t done = 0;
+    while (done < n) {
+      auto r = ::pread(f, buf + done, n - done, static_cast<off_t>(offset + done));
+      if (r == -1 && errno == EINTR) continue;
+      assert(r != -1);
+      if (r <= 0) break;
+      done += static_cast<size_t>(r);
+    }
+    return done;
+  }
+
+  // Reads [offset, offset + n) with direct reads.  Where buf is aligned
+  // the same as offset, the whole blocks in the range are read straight
+  // into it, and only the partial blocks at either end go through an
+  // aligned buffer.  Returns false if the file system rejected the read.
+  bool read_direct(char* buf, size_t n, size_t offset, size_t& result) const {
+    size_t a = direct_io_alignment;
+    size_t lo = (offset + a - 1) / a * a;
+    size_t hi = (offset + n) / a * a;
+    if ((reinterpret_cast<uintptr_t>(buf) - offset) % a != 0 || lo >= hi) {
+      return read_bounced(buf, n, offset, result);
+    }
+    size_t head = lo - offset, r = 0;
+    if (head > 0) {
+      if (!read_bounced(buf, head, offset, r)) return false;
+      if (r < head) { result = r; return true; }
+    }
+    if (!read_aligned(buf + head, hi - lo, lo, r)) return false;
+    result = head + r;
+    if (r < hi - lo || hi == offset + n) return true;
+    if (!read_bounced(buf + result, offset + n - hi, hi, r)) return false;
+    result += r;
+    return true;
+  }
+
+  // Reads the aligned range around [offset, offset + n) into an aligned
+  // buffer and copies out the requested part
+  bool read_bounced(char* buf, size_t n, size_t offset, size_t& result) const {
+    size_t a = direct_io_alignment;
+    size_t lo = offset / a * a;
+    size_t hi = (offset + n + a - 1) / a * a;
+    char* tmp = static_cast<char*>(std::aligned_alloc(a, hi - lo));
+    if (tmp == nullptr) return false;
+    size_t done;
+    bool ok = read_aligned(tmp, hi - lo, lo, done);
+    if (ok) {
+      size_t skip = offset - lo;
+      result = (done > skip) ? (std::min)(n, done - skip) : 0;
+      std::memcpy(buf, tmp + skip, result);
+    }
+    std::free(tmp);
+    return ok;
+  }
+
+  // Reads n bytes at offset into buf, all of which are aligned, stopping
+  // early only at the end of the file.  Returns false if the first read
+  // failed.
+  bool read_aligned(char* buf, size_t n, size_t offset, size_t& done) const {
+    done = 0;
+    while (done < n) {
+      auto r = ::pread(direct_fd, buf + done, n - done, static_cast<off_t>(offset + done));
+      if (r == -1 && errno == EINTR) continue;
+      if (r == -1) return done > 0;
+      if (r == 0) break;
+      done += static_cast<size_t>(r);
+      if (done % direct_io_alignment != 0) break;  // a short read only happens at the end of the file
+    }
+    return true;
+  }
+};
+
+// A file that can be written at arbitrary offsets from many threads at
+// once, using pwrite on a shared descriptor.  The file is created, or
+// truncated if it exists.
+class positioned_writer {
+ public:
+  explicit positioned_writer(const std::string& filename) {
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  ~positioned_writer() {
+    if (fd != -1) ::close(fd);
+  }
+
+  positioned_writer(const positioned_writer&) = delete;
+  positioned_writer& operator=(const positioned_writer&) = delete;
+
+  bool is_open() const { return fd != -1; }
+
+  // Sets the final size of the file up front so that writes at
+  // different offsets do not each have to extend it
+  void resize(size_t n) {
+    [[maybe_unused]] int r = ::ftruncate(fd, static_cast<off_t>(n));
+    assert(r == 0);
+  }
+
+  // Writes n bytes from buf at offset, returning the number written
+  size_t write(const char* buf, size_t n, size_t offset) const {
+    size_t done = 0;
+    while (done < n) {
+      auto r = ::pwrite(fd, buf + done, n - done, static_cast<off_t>(offset + done));
+      if (r == -1 && errno == EINTR) continue;
+      assert(r != -1);
+      if (r <= 0) break;
+      done += static_cast<size_t>(r);
+    }
+    return done;
+  }
+
+ private:
+  int fd = -1;
+};
+
+#else
+
+// A platform-independent simulation of positioned_reader that opens a
+// separate stream for each read, so that reads can proceed concurrently.
+class positioned_reader {
+ public:
+  explicit positioned_reader(const std::string& filename, bool = false) : name(filename) {
+    std::ifstream file(name, std::ios::in | std::ios::binary | std::ios::ate);
+    open = file.is_open();
+    if (open) length = static_cast<size_t>(file.tellg());
+  }
+
+  bool is_open() const { return open; }
+  size_t size() const { return length; }
+  bool direct() const { return false; }
+
+  size_t read(char* buf, size_t n, size_t offset) const {
+    if (offset >= length) return 0;
+    n = (std::min)(n, length - offset);
+    std::ifstream file(name, std::ios::in | std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file.read(buf, static_cast<std::streamsize>(n));
+    return static_cast<size_t>(file.gcount());
+  }
+
+ private:
+  std::string name;
+  bool open = false;
+  size_t length = 0;
+};
+
+// A platform-independent simulation of positioned_writer that opens a
+// separate stream for each write, so that writes can proceed concurrently.
+class positioned_writer {
+ public:
+  explicit positioned_writer(const std::string& filename) : name(filename) {
+    std::ofstream file(name, std::ios::out | std::ios::binary | std::ios::trunc);
+    open = file.is_open();
+  }
+
+  bool is_open() const { return open; }
+
+  void resize(size_t) {}
+
+  size_t write(const char* buf, size_t n, size_t offset) const {
+    std::fstream file(name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
+    file.write(buf, static_cast<std::streamsize>(n));
+    return file ? n : 0;
+  }
+
+ private:
+  std::string name;
+  bool open = false;
+};
+
+#endif
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_FILE_IO_H_
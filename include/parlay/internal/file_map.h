@@ -15,6 +15,55 @@
 #define PARLAY_NO_FILE_MAP
 #endif
 
+#include <cstddef>
+
+#include "../parallel.h"
+
+namespace parlay {
+
+// Options for how a file_map maps its file.  Hints that a platform does
+// not support are ignored.
+struct file_map_options {
+  enum class access_pattern { normal, sequential, random };
+  enum class prefault_mode { none, populate, parallel };
+
+  // The expected order of accesses, which lets the kernel read further
+  // ahead (sequential) or not at all (random)
+  access_pattern access = access_pattern::normal;
+
+  // Asks the kernel to start reading the whole file in the background
+  bool will_need = false;
+
+  // Whether to fault in every page of the file before the constructor
+  // returns: populate has the kernel do so while mapping (MAP_POPULATE),
+  // while parallel touches the pages from all workers at once, each in
+  // order over its own part of the file.  Otherwise the first pass over a
+  // cold file takes its page faults in whatever order the workers reach
+  // the pages.
+  prefault_mode prefault = prefault_mode::none;
+
+  // Asks for the map to be backed by transparent huge pages, which Linux
+  // supports for files on some file systems (e.g., tmpfs)
+  bool huge_pages = false;
+
+  // Maps the file for writing as well as reading, through data().  The
+  // map is shared, so writes go to the file itself.
+  bool writable = false;
+};
+
+namespace internal {
+
+// Reads one byte of each page of [p, p + n) in parallel
+inline void prefault_pages(const char* p, size_t n) {
+  constexpr size_t page_size = 4096;
+  parallel_for(0, (n + page_size - 1) / page_size, [&](size_t i) {
+    [[maybe_unused]] char c = *static_cast<const volatile char*>(p + i * page_size);
+  });
+}
+
+}  // namespace internal
+}  // namespace parlay
+
 #if defined(PARLAY_WINDOWS_FILE_MAP) && !defined(PARLAY_USE_FALLBACK_FILE_MAP)
 #include "windows/file_map_impl_windows.h"
 #endif
@@ -25,18 +74,24 @@
 
 #if defined(PARLAY_NO_FILE_MAP) || defined(PARLAY_USE_FALLBACK_FILE_MAP)
 
+#include <cassert>
+
 #include <fstream>
 #include <string>
+#include <utility>
 
 namespace parlay {
 
 // A platform-independent simulation of file map. This one reads in the entire file
 // to main memory all at once. This could be slow, and even worse, could fail badly
-// if the file is so large that it does not fit in main memory!
+// if the file is so large that it does not fit in main memory!  A writable
+// map is written back to the file by flush and when it is closed.
 
 class file_map {
   private:
     std::string contents;
+    std::string filename;
+    bool writable = false;
   public:
     using value_type = std::string::value_type;
     using reference = std::string::reference;
@@ -51,11 +106,18 @@ class file_map {
     char operator[] (size_t i) const { return contents[i]; }
     auto begin() const { return contents.begin(); }
     auto end() const { return contents.end(); }
+
+    // The contents of a writable map, for writing
+    char* data() {
+      assert(writable);
+      return contents.data();
+    }
     
-    size_t size() const { return end() - begin(); }
+    size_t size() const { return contents.size(); }
 
-    explicit file_map(const std::string& filename) {
-      std::ifstream in(filename);
+    explicit file_map(const std::string& filename_, const file_map_options& options = {})
+        : filename(filename_), writable(options.writable) {
+      std::ifstream in(filename, std::ios::in | std::ios::binary);
       assert(in.is_open());
       in.seekg(0, std::ios::end);
       size_t sz = static_cast<size_t>(in.tellg());
@@ -64,25 +126,54 @@ class file_map {
       in.read(&(*contents.begin()), sz);
     }
 
+    // Creates (or truncates) a file of the given size, and maps it for writing
+    static file_map create(const std::string& filename, size_t size, file_map_options options = {}) {
+      std::ofstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+      options.writable = true;
+      file_map f(filename, options);
+      f.contents.resize(size);
+      return f;
+    }
+
     ~file_map() {
-      contents.clear();
+      close();
     }
     
-    file_map(file_map&& other) noexcept : contents(std::move(other.contents)) {
+    file_map(file_map&& other) noexcept : contents(std::move(other.contents)),
+        filename(std::move(other.filename)), writable(other.writable) {
       other.contents.clear();
+      other.writable = false;
     }
     
     file_map& operator=(file_map&& other) {
-      contents = std::move(other.contents);
-      other.contents.clear();
+      close();
+      swap(other);
       return *this;
     }
     
     file_map(const file_map&) = delete;
     file_map operator=(const file_map&) = delete;
+
+    bool is_writable() const { return writable; }
+
+    // Writes the contents of a writable map to the file
+    void flush() {
+      if (writable) {
+        std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+      }
+    }
+
+    void close() {
+      flush();
+      contents.clear();
+      writable = false;
+    }
     
     void swap(file_map& other) {
       std::swap(contents, other.contents);
+      std::swap(filename, other.filename);
+      std::swap(writable, other.writable);
     }
 
     bool empty() const {
@@ -127,6 +127,28 @@ auto reduce_by_key(R&& A, Monoid&& monoid = {}, Hash&& hash = {}, Equal&& equal
   return internal::collect_reduce_sparse(std::forward<R>(A), helper);
 }
 
+// A bucketing plan for the hash-based reduce_by_key, group_by_key and
+// histogram_by_key. Each call without a plan samples its input for heavy
+// keys; passing the same plan to repeated calls over inputs with a similar
+// key distribution (e.g. batches of a stream) samples once and then reuses
+// the result. The plan is resampled automatically when the bucket sizes of
+// a call show that the heavy keys have changed, or when the input size
+// calls for a different number of buckets. Calls sharing a plan must not
+// run concurrently.
+template <typename K, typename Hash = parlay::hash<K>, typename Equal = std::equal_to<>>
+using bucket_plan = internal::bucket_plan_<K, Hash, Equal>;
+
+// As above, but bucketing with the given plan, and hashing and comparing
+// keys with the plan's functions
+template <typename R, typename K, typename Hash, typename Equal,
+    typename Monoid = parlay::plus<std::tuple_element_t<1, range_value_type_t<R>>>>
+auto reduce_by_key(R&& A, bucket_plan<K, Hash, Equal>& plan, Monoid&& monoid = {}) {
+  static_assert(is_random_access_range_v<R>);
+  auto helper = reduce_by_key_helper<range_value_type_t<R>,Monoid,Hash,Equal>{
+      monoid,plan.hash_function(),plan.key_eq()};
+  return internal::collect_reduce_sparse(std::forward<R>(A), helper, plan);
+}
+
 template <typename arg_type, typename Hash, typename Equal>
 struct group_by_key_helper {
   using in_type = arg_type;
@@ -161,6 +183,46 @@ auto group_by_key(R&& A, Hash&& hash = {}, Equal&& equal = {}) {
   return internal::collect_reduce_sparse(std::forward<R>(A), helper);
 }
 
+template <typename R, typename K, typename Hash, typename Equal>
+auto group_by_key(R&& A, bucket_plan<K, Hash, Equal>& plan) {
+  static_assert(is_random_access_range_v<R>);
+  auto helper = group_by_key_helper<range_value_type_t<R>,Hash,Equal>{plan.hash_function(),plan.key_eq()};
+  return internal::collect_reduce_sparse(std::forward<R>(A), helper, plan);
+}
+
+// Groups in compressed sparse row form: the values of group i are
+// values[offsets[i], offsets[i+1]), so all groups share one allocation.
+template <typename V>
+struct flat_groups {
+  sequence<size_t> offsets = sequence<size_t>(1, 0);
+  sequence<V> values;
+
+  size_t size() const { return offsets.size() - 1; }
+  auto operator[](size_t i) const { return values.cut(offsets[i], offsets[i + 1]); }
+};
+
+// As above, with the key of group i in keys[i]
+template <typename K, typename V>
+struct flat_key_groups : flat_groups<V> {
+  sequence<K> keys;
+};
+
+// Like group_by_key, but returns the groups as a flat_key_groups instead of
+// a sequence of nested sequences. Values within a group are in input order.
+// Groups are returned in an arbitrary order that depends on the hash function.
+template <typename R,
+    typename Hash = parlay::hash<std::tuple_element_t<0, range_value_type_t<R>>>,
+    typename Equal = std::equal_to<>>
+auto group_by_key_flat(R&& A, Hash&& hash = {}, Equal&& equal = {}) {
+  static_assert(is_random_access_range_v<R>);
+  using KV = range_value_type_t<R>;
+  using K = std::tuple_element_t<0, KV>;
+  using V = std::tuple_element_t<1, KV>;
+  auto helper = group_by_key_helper<KV,Hash,Equal>{hash,equal};
+  auto [keys, offsets, values] = internal::collect_groups_sparse(make_slice(A), helper);
+  return flat_key_groups<K, V>{{std::move(offsets), std::move(values)}, std::move(keys)};
+}
+
 template <typename arg_type, typename sum_type, typename Hash, typename Equal>
 struct count_by_key_helper {
   using in_type = arg_type;
@@ -192,6 +254,13 @@ auto histogram_by_key(R &&A, Hash&& hash = {}, Equal&& equal = {}) {
   return internal::collect_reduce_sparse(std::forward<R>(A), helper);
 }
 
+template <typename sum_type = size_t, typename R, typename K, typename Hash, typename Equal>
+auto histogram_by_key(R &&A, bucket_plan<K, Hash, Equal>& plan) {
+  static_assert(is_random_access_range_v<R>);
+  auto helper = count_by_key_helper<range_value_type_t<R>,sum_type,Hash,Equal>{plan.hash_function(),plan.key_eq()};
+  return internal::collect_reduce_sparse(std::forward<R>(A), helper, plan);
+}
+
 template <typename arg_type, typename Hash, typename Equal>
 struct remove_duplicates_helper {
   using in_type = arg_type;
@@ -313,6 +382,32 @@ auto group_by_index_(R&& A, Integer_t num_buckets) {
   }
 }
 
+// Like group_by_index, but returns the groups as a flat_groups with
+// num_buckets groups instead of a sequence of nested sequences.
+// Values within a group are in input order.
+template <typename Integer_t, typename R>
+auto group_by_index_flat(R&& A, Integer_t num_buckets) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_pair_v<range_value_type_t<R>>);
+  using V = std::tuple_element_t<1, range_value_type_t<R>>;
+
+  if (A.size() > static_cast<size_t>(num_buckets)*num_buckets) {
+    auto keys = internal::delayed_map(A, [] (auto const &kv) { return std::get<0>(kv); });
+    auto vals = internal::delayed_map(A, [] (auto const &kv) { return std::get<1>(kv); });
+    auto [values, offsets] = internal::count_sort(make_slice(vals), keys, static_cast<size_t>(num_buckets));
+    return flat_groups<V>{std::move(offsets), std::move(values)};
+  }
+  else {
+    auto [key_vals,lengths] = internal::integer_sort_with_counts(make_slice(A),
+      [] (auto p) { return std::get<0>(p); }, num_buckets);
+    auto offsets = sequence<size_t>::uninitialized(lengths.size() + 1);
+    parallel_for(0, lengths.size(), [&] (size_t i) { offsets[i] = lengths[i]; });
+    offsets[lengths.size()] = internal::scan_inplace(make_slice(offsets).cut(0, lengths.size()), plus<size_t>());
+    auto values = internal::map(key_vals, [] (auto const &kv) { return std::get<1>(kv); });
+    return flat_groups<V>{std::move(offsets), std::move(values)};
+  }
+}
+
 template <typename Integer_t, typename R>
 auto group_by_index(R&& A, Integer_t num_buckets) {
   static_assert(is_random_access_range_v<R>);
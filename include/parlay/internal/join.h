@@ -0,0 +1,440 @@
+#ifndef PARLAY_INTERNAL_JOIN_H_
+#define PARLAY_INTERNAL_JOIN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "../delayed_sequence.h"
+#include "../hardware.h"
+#include "../monoid.h"
+#include "../parallel.h"
+#include "../range.h"
+#include "../sequence.h"
+#include "../slice.h"
+#include "../utilities.h"
+
+#include "counting_sort.h"
+#include "sequence_ops.h"
+
+namespace parlay {
+namespace internal {
+
+// An element of one side of a join: the hash of its key, its position,
+// and, if the key is small and trivially copyable, a copy of the key, so
+// that comparing keys does not need a random access to the input.
+template <typename K, typename = void>
+struct join_entry {
+  static constexpr bool inline_key = false;
+  size_t hash;
+  size_t index;
+};
+
+template <typename K>
+struct join_entry<K, std::enable_if_t<std::is_trivially_copyable_v<K> && sizeof(K) <= 16>> {
+  static constexpr bool inline_key = true;
+  size_t hash;
+  size_t index;
+  K key;
+};
+
+template <typename Keys, typename Hash>
+auto make_join_entry(const Keys& keys, const Hash& hasher, size_t i) {
+  using K = std::decay_t<decltype(keys[i])>;
+  using entry = join_entry<K>;
+  if constexpr (entry::inline_key) {
+    K k = keys[i];
+    return entry{static_cast<size_t>(hash64_2(hasher(k))), i, k};
+  } else {
+    return entry{static_cast<size_t>(hash64_2(hasher(keys[i]))), i};
+  }
+}
+
+// A hash table over the build side of a join, split into partitions by
+// the top bits of the hash, so that each partition's part of the table
+// fits in the L2 cache. Both sides are radix partitioned with count_sort, each
+// partition's table is built by one worker, and the probe side is then
+// processed in partition order, so that consecutive probes hit the same
+// partition's table. The probe side is partitioned in chunks, so that it
+// does not need to be copied all at once.
+template <typename BuildKeys, typename Hash, typename Equal>
+struct join_table {
+  using slot = join_entry<std::decay_t<decltype(std::declval<const BuildKeys&>()[0])>>;
+  static constexpr size_t empty = (std::numeric_limits<size_t>::max)();
+  static constexpr size_t probe_chunk_size = size_t{1} << 22;
+
+  const BuildKeys& keys;  // the keys of the build side, e.g. a delayed sequence
+  const Hash& hasher;
+  const Equal& equal;
+  size_t bits;             // the number of bits of the hash that select a partition
+  sequence<size_t> table_offsets;
+  sequence<slot> table;
+
+  size_t partition_of(size_t h) const { return bits == 0 ? 0 : h >> (64 - bits); }
+
+  join_table(const BuildKeys& keys_, const Hash& hasher_, const Equal& equal_)
+      : keys(keys_), hasher(hasher_), equal(equal_) {
+    size_t n = keys.size();
+    // each build element takes up to four slots in its partition's table,
+    // which should take at most a quarter of a core's share of the L2 cache,
+    // so that the stream of probes and the output do not evict it
+    const auto& hw = get_hardware_profile();
+    size_t table_bytes = hw.l2_size / (std::max)(hw.cpus_per_l2, size_t{1}) / 4;
+    size_t per_partition = (std::max)(size_t{1}, table_bytes / (4 * sizeof(slot)));
+    bits = log2_up((std::max)(size_t{1}, n / per_partition));
+    size_t num_partitions = size_t{1} << bits;
+
+    auto hashed = internal::tabulate(n, [&](size_t i) { return make_join_entry(keys, hasher, i); });
+    auto parts = delayed_seq<size_t>(n, [&](size_t i) { return partition_of(hashed[i].hash); });
+    auto offsets = count_sort_inplace(make_slice(hashed), parts, num_partitions);
+
+    // each partition's table has a power of two size that is at least twice its size
+    table_offsets = internal::tabulate(num_partitions + 1, [&](size_t p) -> size_t {
+      if (p == num_partitions) return 0;
+      size_t m = offsets[p + 1] - offsets[p];
+      return m == 0 ? 0 : size_t{1} << log2_up(2 * m);
+    });
+    size_t total = internal::scan_inplace(make_slice(table_offsets).cut(0, num_partitions), plus<size_t>());
+    table_offsets[num_partitions] = total;
+    table = sequence<slot>::uninitialized(total);
+    parallel_for(0, total, [&](size_t i) { table[i].index = empty; });
+
+    parallel_for(0, num_partitions, [&](size_t p) {
+      size_t start = table_offsets[p];
+      size_t mask = table_offsets[p + 1] - start - 1;
+      for (size_t j = offsets[p]; j < offsets[p + 1]; j++) {
+        size_t s = hashed[j].hash & mask;
+        while (table[start + s].index != empty) s = (s + 1) & mask;
+        table[start + s] = hashed[j];
+      }
+    }, 1);
+  }
+
+  // Calls f(i) for the index i of each build element whose key equals the
+  // key of the probe entry q, and returns the number of them
+  template <typename ProbeKeys, typename Entry, typename F>
+  size_t for_each_match(const ProbeKeys& probe_keys, const Entry& q, const F& f) const {
+    size_t p = partition_of(q.hash);
+    size_t start = table_offsets[p], m = table_offsets[p + 1] - start;
+    if (m == 0) return 0;
+    size_t count = 0;
+    for (size_t s = q.hash & (m - 1); table[start + s].index != empty; s = (s + 1) & (m - 1)) {
+      const slot& e = table[start + s];
+      if (e.hash == q.hash && keys_equal(e, probe_keys, q)) {
+        f(e.index);
+        count++;
+      }
+    }
+    return count;
+  }
+
+  template <typename ProbeKeys, typename Entry>
+  bool keys_equal(const slot& e, const ProbeKeys& probe_keys, const Entry& q) const {
+    if constexpr (slot::inline_key && Entry::inline_key) return equal(e.key, q.key);
+    else if constexpr (slot::inline_key) return equal(e.key, probe_keys[q.index]);
+    else if constexpr (Entry::inline_key) return equal(keys[e.index], q.key);
+    else return equal(keys[e.index], probe_keys[q.index]);
+  }
+
+  // Calls f(probes) for each chunk of the given keys, where probes holds the
+  // entries of the keys in the chunk, grouped by partition. Chunks are
+  // partitioned one at a time to bound the memory used.
+  template <typename ProbeKeys, typename F>
+  void for_each_probe_chunk(const ProbeKeys& probe_keys, const F& f) const {
+    size_t n = probe_keys.size();
+    for (size_t start = 0; start < n; start += probe_chunk_size) {
+      size_t end = (std::min)(n, start + probe_chunk_size);
+      auto probes = internal::tabulate(end - start, [&](size_t i) { return make_join_entry(probe_keys, hasher, start + i); });
+      if (bits > 0) {
+        auto parts = delayed_seq<size_t>(probes.size(), [&](size_t i) { return partition_of(probes[i].hash); });
+        count_sort_inplace(make_slice(probes), parts, size_t{1} << bits);
+      }
+      f(probes);
+    }
+  }
+};
+
+// Returns the pairs of indices (i, j) such that the key of build[i] equals
+// the key of probe[j]
+template <typename BuildKeys, typename ProbeKeys, typename Hash, typename Equal>
+sequence<std::pair<size_t, size_t>> hash_join_indices(const BuildKeys& build_keys, const ProbeKeys& probe_keys,
+                                                     const Hash& hash, const Equal& equal) {
+  join_table<BuildKeys, Hash, Equal> table(build_keys, hash, equal);
+  sequence<sequence<std::pair<size_t, size_t>>> results;
+  table.for_each_probe_chunk(probe_keys, [&](const auto& probes) {
+    auto counts = sequence<size_t>::uninitialized(probes.size());
+    parallel_for(0, probes.size(), [&](size_t j) {
+      counts[j] = table.for_each_match(probe_keys, probes[j], [](size_t) {});
+    });
+    size_t total = internal::scan_inplace(make_slice(counts), plus<size_t>());
+    auto result = sequence<std::pair<size_t, size_t>>::uninitialized(total);
+    parallel_for(0, probes.size(), [&](size_t j) {
+      size_t pos = counts[j], i = probes[j].index;
+      table.for_each_match(probe_keys, probes[j], [&](size_t b) {
+        assign_uninitialized(result[pos++], std::make_pair(b, i));
+      });
+    });
+    results.push_back(std::move(result));
+  });
+  if (results.size() == 1) return std::move(results[0]);
+  auto offsets = internal::tabulate(results.size(), [&](size_t k) { return results[k].size(); });
+  size_t total = internal::scan_inplace(make_slice(offsets), plus<size_t>());
+  auto all = sequence<std::pair<size_t, size_t>>::uninitialized(total);
+  parallel_for(0, results.size(), [&](size_t k) {
+    parallel_for(0, results[k].size(), [&](size_t j) { assign_uninitialized(all[offsets[k] + j], results[k][j]); });
+  }, 1);
+  return all;
+}
+
+// Returns for each element of the probe side whether its key matches the key
+// of any element of the build side
+template <typename BuildKeys, typename ProbeKeys, typename Hash, typename Equal>
+sequence<bool> hash_join_flags(const BuildKeys& build_keys, const ProbeKeys& probe_keys,
+                               const Hash& hash, const Equal& equal) {
+  join_table<BuildKeys, Hash, Equal> table(build_keys, hash, equal);
+  auto flags = sequence<bool>::uninitialized(probe_keys.size());
+  table.for_each_probe_chunk(probe_keys, [&](const auto& probes) {
+    parallel_for(0, probes.size(), [&](size_t j) {
+      flags[probes[j].index] = table.for_each_match(probe_keys, probes[j], [](size_t) {}) > 0;
+    });
+  });
+  return flags;
+}
+
+template <typename R, typename F>
+auto join_keys(const R& r, const F& key) {
+  return internal::delayed_map(r, [&](const auto& x) -> decltype(auto) { return key(x); });
+}
+
+
+// The number of elements of A among the first k elements of the stable
+// merge of A and B (of sizes nA and nB), where b_before_a(i, j) is true
+// if B[j] goes before A[i], i.e., if it is strictly less
+template <typename F>
+size_t co_rank(size_t k, size_t nA, size_t nB, const F& b_before_a) {
+  size_t lo = (k > nB) ? k - nB : 0, hi = (std::min)(k, nA);
+  while (lo < hi) {
+    size_t mid = (lo + hi + 1) / 2;
+    // A[mid - 1] is in the prefix if it goes before B[k - mid]
+    if (!b_before_a(mid - 1, k - mid)) lo = mid;
+    else hi = mid - 1;
+  }
+  return lo;
+}
+
+// Returns the pairs of indices (i, j) such that below(i, j) is false and
+// within(i, j) is true, sorted by i and then j, where for each i the j's
+// for which below(i, j) is true and within(i, j) is false are a prefix and
+// a suffix of B respectively, and both grow with i. This is the case for
+// an equijoin (below is B[j] < A[i] and within is !(A[i] < B[j])), and
+// for a band join, where keys of B are compared with the key of A plus
+// the ends of the band.
+//
+// The merge of A and B by below is split into blocks of equal size by
+// co-ranking, and in each block the range of j's for each i is found by
+// walking a pointer for the start of the range, and galloping from the
+// end of the previous range for its end. So the work is linear in the
+// input and output, and the depth is logarithmic, even if some keys have
+// very many matches.
+template <typename Below, typename Within>
+sequence<std::pair<size_t, size_t>> sorted_join_indices(size_t nA, size_t nB, const Below& below, const Within& within) {
+  constexpr size_t block_size = 4096;
+  size_t n = nA + nB;
+  size_t num_blocks = (n + block_size - 1) / block_size;
+  auto splits = internal::tabulate(num_blocks + 1, [&](size_t b) {
+    size_t k = (std::min)(n, b * block_size);
+    size_t i = co_rank(k, nA, nB, below);
+    return std::make_pair(i, k - i);
+  });
+
+  auto starts = sequence<size_t>::uninitialized(nA);
+  auto counts = sequence<size_t>::uninitialized(nA);
+  parallel_for(0, num_blocks, [&](size_t b) {
+    size_t j = splits[b].second, end = j;
+    for (size_t i = splits[b].first; i < splits[b + 1].first; i++) {
+      while (j < nB && below(i, j)) j++;
+      end = (std::max)(end, j);
+      // gallop, then binary search, for the first position past the range
+      size_t step = 1;
+      while (end + step <= nB && within(i, end + step - 1)) { end += step; step *= 2; }
+      size_t hi = (std::min)(nB, end + step - 1);
+      while (end < hi) {
+        size_t mid = (end + hi) / 2;
+        if (within(i, mid)) end = mid + 1;
+        else hi = mid;
+      }
+      starts[i] = j;
+      counts[i] = end - j;
+    }
+  }, 1);
+
+  size_t total = internal::scan_inplace(make_slice(counts), plus<size_t>());
+  auto result = sequence<std::pair<size_t, size_t>>::uninitialized(total);
+  parallel_for(0, nA, [&](size_t i) {
+    size_t offset = counts[i], len = (i + 1 < nA ? counts[i + 1] : total) - offset;
+    parallel_for(0, len, [&](size_t k) {
+      assign_uninitialized(result[offset + k], std::make_pair(i, starts[i] + k));
+    }, 1024);
+  });
+  return result;
+}
+
+template <typename R1, typename R2>
+auto join_pairs(const R1& left, const R2& right, const sequence<std::pair<size_t, size_t>>& idx) {
+  auto l = std::begin(left);
+  auto r = std::begin(right);
+  return internal::map(idx, [&](const auto& ij) { return std::make_pair(l[ij.first], r[ij.second]); });
+}
+
+}  // namespace internal
+
+// Returns the pairs (i, j) of positions such that the key of left[i] equals
+// the key of right[j], where keys are given by key_l and key_r. The hash
+// table is built on left, which should be the smaller side. The result is in
+// an arbitrary order.
+template <typename R1, typename R2, typename KeyL, typename KeyR,
+          typename Hash = parlay::hash<std::decay_t<std::invoke_result_t<KeyL, range_reference_type_t<R1>>>>,
+          typename Equal = std::equal_to<>>
+sequence<std::pair<size_t, size_t>> hash_join_indices(const R1& left, const R2& right, KeyL&& key_l, KeyR&& key_r,
+                                                      Hash&& hash = {}, Equal&& equal = {}) {
+  static_assert(is_random_access_range_v<R1>);
+  static_assert(is_random_access_range_v<R2>);
+  return internal::hash_join_indices(internal::join_keys(left, key_l), internal::join_keys(right, key_r), hash, equal);
+}
+
+// Returns the pairs (left[i], right[j]) whose keys are equal, in an
+// arbitrary order. See hash_join_indices.
+template <typename R1, typename R2, typename KeyL, typename KeyR,
+          typename Hash = parlay::hash<std::decay_t<std::invoke_result_t<KeyL, range_reference_type_t<R1>>>>,
+          typename Equal = std::equal_to<>>
+auto hash_join(const R1& left, const R2& right, KeyL&& key_l, KeyR&& key_r,
+               Hash&& hash = {}, Equal&& equal = {}) {
+  return internal::join_pairs(left, right, hash_join_indices(left, right, key_l, key_r, hash, equal));
+}
+
+// Returns the elements of left whose key matches the key of some element of
+// right, in their original order
+template <typename R1, typename R2, typename KeyL, typename KeyR,
+          typename Hash = parlay::hash<std::decay_t<std::invoke_result_t<KeyL, range_reference_type_t<R1>>>>,
+          typename Equal = std::equal_to<>>
+auto semi_join(const R1& left, const R2& right, KeyL&& key_l, KeyR&& key_r,
+               Hash&& hash = {}, Equal&& equal = {}) {
+  static_assert(is_random_access_range_v<R1>);
+  static_assert(is_random_access_range_v<R2>);
+  auto flags = internal::hash_join_flags(internal::join_keys(right, key_r), internal::join_keys(left, key_l), hash, equal);
+  return internal::pack(make_slice(left), flags);
+}
+
+// Returns the elements of left whose key does not match the key of any element
+// of right, in their original order
+template <typename R1, typename R2, typename KeyL, typename KeyR,
+          typename Hash = parlay::hash<std::decay_t<std::invoke_result_t<KeyL, range_reference_type_t<R1>>>>,
+          typename Equal = std::equal_to<>>
+auto anti_join(const R1& left, const R2& right, KeyL&& key_l, KeyR&& key_r,
+               Hash&& hash = {}, Equal&& equal = {}) {
+  static_assert(is_random_access_range_v<R1>);
+  static_assert(is_random_access_range_v<R2>);
+  auto flags = internal::hash_join_flags(internal::join_keys(right, key_r), internal::join_keys(left, key_l), hash, equal);
+  return internal::pack(make_slice(left), internal::delayed_map(flags, [](bool b) { return !b; }));
+}
+
+// Returns the pairs (i, j) of positions such that the key of a[i] is
+// equivalent to the key of b[j], where a and b are sorted by their keys,
+// which are given by key_a and key_b and compared with less. The result
+// is sorted by i and then j.
+template <typename R1, typename R2, typename KeyA, typename KeyB, typename Less = std::less<>>
+sequence<std::pair<size_t, size_t>> merge_join_indices(const R1& a, const R2& b, KeyA&& key_a, KeyB&& key_b,
+                                                       Less&& less = {}) {
+  static_assert(is_random_access_range_v<R1>);
+  static_assert(is_random_access_range_v<R2>);
+  auto A = std::begin(a);
+  auto B = std::begin(b);
+  return internal::sorted_join_indices(parlay::size(a), parlay::size(b),
+      [&](size_t i, size_t j) { return less(key_b(B[j]), key_a(A[i])); },
+      [&](size_t i, size_t j) { return !less(key_a(A[i]), key_b(B[j])); });
+}
+
+// Returns the pairs (a[i], b[j]) whose keys are equivalent, in the order of
+// merge_join_indices
+template <typename R1, typename R2, typename KeyA, typename KeyB, typename Less = std::less<>>
+auto merge_join(const R1& a, const R2& b, KeyA&& key_a, KeyB&& key_b, Less&& less = {}) {
+  return internal::join_pairs(a, b, merge_join_indices(a, b, key_a, key_b, less));
+}
+
+namespace internal {
+
+// Whether x < y for integers of any types, comparing their values (as
+// std::cmp_less does in C++20)
+template <typename X, typename Y>
+constexpr bool int_less(X x, Y y) {
+  if constexpr (std::is_signed_v<X> == std::is_signed_v<Y>) return x < y;
+  else if constexpr (std::is_signed_v<X>) return x < 0 || static_cast<std::make_unsigned_t<X>>(x) < y;
+  else return y >= 0 && x < static_cast<std::make_unsigned_t<Y>>(y);
+}
+
+// The sign of b - (a + d). For integers, b - a is compared with d as an
+// unsigned distance, so that neither a + d nor b - a can overflow, even
+// for unsigned keys with a negative d or keys near the limits of the type.
+template <typename KA, typename KB, typename T>
+int band_compare(const KA& a, const KB& b, const T& d) {
+  if constexpr (std::is_integral_v<KA> && std::is_integral_v<KB> && std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<std::common_type_t<KA, KB, T>>;
+    if (int_less(b, a)) {
+      if (!int_less(d, 0)) return -1;
+      U distance = static_cast<U>(a) - static_cast<U>(b), neg_d = U{0} - static_cast<U>(d);
+      return (distance > neg_d) ? -1 : (distance < neg_d) ? 1 : 0;
+    }
+    if (int_less(d, 0)) return 1;
+    U distance = static_cast<U>(b) - static_cast<U>(a), pos_d = static_cast<U>(d);
+    return (distance < pos_d) ? -1 : (distance > pos_d) ? 1 : 0;
+  }
+  else {
+    return (b < a + d) ? -1 : (a + d < b) ? 1 : 0;
+  }
+}
+
+}  // namespace internal
+
+// Returns the pairs (i, j) of positions such that
+//   key_a(a[i]) + lo <= key_b(b[j]) <= key_a(a[i]) + hi,
+// where a and b are sorted by their keys. For example, with timestamps as
+// keys, lo = -d and hi = d matches the events that are at most d apart.
+// The result is sorted by i and then j. For integer keys, the bounds are
+// evaluated exactly, even where key + lo or key + hi would overflow.
+template <typename R1, typename R2, typename T, typename KeyA, typename KeyB>
+sequence<std::pair<size_t, size_t>> band_join_indices(const R1& a, const R2& b, const T& lo, const T& hi,
+                                                      KeyA&& key_a, KeyB&& key_b) {
+  static_assert(is_random_access_range_v<R1>);
+  static_assert(is_random_access_range_v<R2>);
+  auto A = std::begin(a);
+  auto B = std::begin(b);
+  return internal::sorted_join_indices(parlay::size(a), parlay::size(b),
+      [&](size_t i, size_t j) { return internal::band_compare(key_a(A[i]), key_b(B[j]), lo) < 0; },
+      [&](size_t i, size_t j) { return internal::band_compare(key_a(A[i]), key_b(B[j]), hi) <= 0; });
+}
+
+// band_join_indices, where the elements are their own keys
+template <typename R1, typename R2, typename T>
+sequence<std::pair<size_t, size_t>> band_join_indices(const R1& a, const R2& b, const T& lo, const T& hi) {
+  auto id = [](const auto& x) -> const auto& { return x; };
+  return band_join_indices(a, b, lo, hi, id, id);
+}
+
+// Returns the pairs (a[i], b[j]) in the order of band_join_indices
+template <typename R1, typename R2, typename T, typename KeyA, typename KeyB>
+auto band_join(const R1& a, const R2& b, const T& lo, const T& hi, KeyA&& key_a, KeyB&& key_b) {
+  return internal::join_pairs(a, b, band_join_indices(a, b, lo, hi, key_a, key_b));
+}
+
+template <typename R1, typename R2, typename T>
+auto band_join(const R1& a, const R2& b, const T& lo, const T& hi) {
+  return internal::join_pairs(a, b, band_join_indices(a, b, lo, hi));
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_JOIN_H_
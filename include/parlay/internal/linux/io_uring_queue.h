@@ -0,0 +1,259 @@
+#ifndef PARLAY_INTERNAL_LINUX_IO_URING_QUEUE_H_
+#define PARLAY_INTERNAL_LINUX_IO_URING_QUEUE_H_
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <linux/io_uring.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace parlay {
+namespace internal {
+
+// A submission/completion queue pair for asynchronous positioned reads
+// and writes using Linux io_uring.  The ring is driven directly through
+// the io_uring system calls so that no library is needed.  A dedicated
+// thread reaps completions and runs the callback of each request once
+// all of its bytes have been transferred, it reached the end of the
+// file, or it failed.
+//
+// If the kernel does not support io_uring (or it is disabled, e.g. by a
+// seccomp filter), is_open() returns false and the queue must not be used.
+class io_uring_queue {
+ public:
+  explicit io_uring_queue(unsigned entries = 256) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd < 0) return;
+    ring_fd = fd;
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) sq_size = cq_size = (std::max)(sq_size, cq_size);
+
+    sq_ptr = map(sq_size, IORING_OFF_SQ_RING);
+    cq_ptr = single_mmap ? sq_ptr : map(cq_size, IORING_OFF_CQ_RING);
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(map(sqes_size, IORING_OFF_SQES));
+    if (sq_ptr == nullptr || cq_ptr == nullptr || sqes == nullptr) {
+      release();
+      return;
+    }
+
+    auto sq = static_cast<char*>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    auto cq = static_cast<char*>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    // At most one entry per request is ever outstanding, so bounding the
+    // number of requests by the submission queue size ensures that the
+    // (twice as large) completion queue can not overflow
+    capacity = p.sq_entries;
+    reaper = std::thread([this]() { reap(); });
+  }
+
+  ~io_uring_queue() {
+    if (ring_fd == -1) return;
+    wait();
+    std::unique_lock<std::mutex> lock(m);
+    push(IORING_OP_NOP, -1, nullptr, 0, 0);
+    lock.unlock();
+    reaper.join();
+    release();
+  }
+
+  io_uring_queue(const io_uring_queue&) = delete;
+  io_uring_queue& operator=(const io_uring_queue&) = delete;
+
+  bool is_open() const { return ring_fd != -1; }
+
+  // Starts reading (or writing) n bytes at the given offset of the file
+  // fd into (or from) buf.  When the request is complete, on_complete is
+  // called on the completion thread with the number of bytes transferred,
+  // or a negative error number if the request failed.  Blocks while the
+  // queue is full, except when called from a callback, since only the
+  // completion thread frees up the queue: the request is then held back
+  // until another one completes.
+  template<typename F>
+  void submit(bool write, int fd, char* buf, size_t n, size_t offset, F&& on_complete) {
+    auto r = new request<std::decay_t<F>>(std::forward<F>(on_complete));
+    r->write = write;
+    r->fd = fd;
+    r->buf = buf;
+    r->n = n;
+    r->offset = offset;
+    std::unique_lock<std::mutex> lock(m);
+    if (in_flight >= capacity && std::this_thread::get_id() == reaper.get_id()) {
+      deferred.push_back(r);
+      return;
+    }
+    not_full.wait(lock, [&]() { return in_flight < capacity; });
+    in_flight++;
+    push(r);
+  }
+
+  // Waits until every submitted request has completed.  Must not be
+  // called from a callback.
+  void wait() {
+    std::unique_lock<std::mutex> lock(m);
+    not_full.wait(lock, [&]() { return in_flight == 0; });
+  }
+
+ private:
+  struct request_base {
+    bool write;
+    int fd;
+    char* buf;
+    size_t n;
+    size_t offset;
+    size_t done = 0;
+    iovec iov;
+    virtual void complete(std::ptrdiff_t result) = 0;
+    virtual ~request_base() = default;
+  };
+
+  template<typename F>
+  struct request : public request_base {
+    F f;
+    explicit request(F&& f_) : f(std::move(f_)) {}
+    void complete(std::ptrdiff_t result) override { f(result); }
+  };
+
+  int ring_fd = -1;
+  bool single_mmap = false;
+  size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+  void* sq_ptr = nullptr;
+  void* cq_ptr = nullptr;
+  io_uring_sqe* sqes = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned sq_mask = 0;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_cqe* cqes = nullptr;
+
+  std::mutex m;
+  std::condition_variable not_full;
+  size_t capacity = 0;
+  size_t in_flight = 0;
+  std::deque<request_base*> deferred;   // submitted by callbacks while full
+  std::thread reaper;
+
+  void* map(size_t size, off_t offset) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+    return (p == MAP_FAILED) ? nullptr : p;
+  }
+
+  void release() {
+    if (sqes != nullptr) ::munmap(sqes, sqes_size);
+    if (cq_ptr != nullptr && !single_mmap) ::munmap(cq_ptr, cq_size);
+    if (sq_ptr != nullptr) ::munmap(sq_ptr, sq_size);
+    ::close(ring_fd);
+    ring_fd = -1;
+  }
+
+  static int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  // Submits the remaining part of r.  Must hold the lock.
+  void push(request_base* r) {
+    r->iov.iov_base = r->buf + r->done;
+    r->iov.iov_len = r->n - r->done;
+    push(r->write ? IORING_OP_WRITEV : IORING_OP_READV, r->fd, &r->iov, 1, r->offset + r->done,
+         reinterpret_cast<std::uint64_t>(r));
+  }
+
+  void push(int opcode, int fd, const iovec* iov, unsigned len, size_t offset, std::uint64_t user_data = 0) {
+    unsigned tail = *sq_tail;
+    unsigned index = tail & sq_mask;
+    io_uring_sqe& e = sqes[index];
+    std::memset(&e, 0, sizeof(e));
+    e.opcode = static_cast<std::uint8_t>(opcode);
+    e.fd = fd;
+    e.addr = reinterpret_cast<std::uint64_t>(iov);
+    e.len = len;
+    e.off = offset;
+    e.user_data = user_data;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    int res;
+    do { res = enter(ring_fd, 1, 0, 0); } while (res < 0 && (errno == EINTR || errno == EAGAIN));
+    assert(res >= 0);
+  }
+
+  // Runs on the completion thread until it sees the shutdown entry
+  void reap() {
+    while (true) {
+      unsigned head = *cq_head;
+      if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+        enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+        continue;
+      }
+      io_uring_cqe cqe = cqes[head & cq_mask];
+      __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+      if (cqe.user_data == 0) return;
+      handle(reinterpret_cast<request_base*>(cqe.user_data), cqe.res);
+    }
+  }
+
+  void handle(request_base* r, int res) {
+    // r was published to the kernel while the submitter held the lock, so
+    // taking it here also orders its fields before our reads of them
+    std::unique_lock<std::mutex> lock(m);
+    if (res > 0) r->done += static_cast<size_t>(res);
+    // resubmit the rest after a short transfer that is not at end of file
+    if (res == -EINTR || res == -EAGAIN || (res > 0 && r->done < r->n)) {
+      push(r);
+      return;
+    }
+    std::ptrdiff_t result = (res < 0) ? res : static_cast<std::ptrdiff_t>(r->done);
+    // a deferred request takes over the slot, so in_flight only drops once
+    // there are none left
+    if (!deferred.empty()) {
+      push(deferred.front());
+      deferred.pop_front();
+      lock.unlock();
+    } else {
+      in_flight--;
+      lock.unlock();
+      not_full.notify_all();
+    }
+    r->complete(result);
+    delete r;
+  }
+};
+
+// The queue shared by all asynchronous files in the process
+inline io_uring_queue& get_io_uring_queue() {
+  static io_uring_queue queue;
+  return queue;
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_LINUX_IO_URING_QUEUE_H_
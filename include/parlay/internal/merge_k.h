@@ -0,0 +1,169 @@
+// Parallel k-way merge of sorted runs in a single pass over memory.
+//
+// Splitter elements are picked from a regular sample of the runs, and every
+// run is cut at the exact rank of each splitter (multi-sequence selection),
+// which divides the output into balanced, independent partitions. Each
+// partition is then merged sequentially with a loser tree, which takes
+// log(k) comparisons per output element instead of log(k) passes over the
+// data that a tree of pairwise merges would make.
+//
+// Equal elements are output in the order of their runs, then their position
+// within a run, so the merge is stable.
+
+#ifndef PARLAY_MERGE_K_H_
+#define PARLAY_MERGE_K_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "merge.h"
+#include "sample_sort.h"
+#include "sequence_ops.h"
+
+#include "../monoid.h"
+#include "../parallel.h"
+#include "../sequence.h"
+#include "../slice.h"
+#include "../utilities.h"
+
+namespace parlay {
+namespace internal {
+
+// the following parameter can be tuned
+constexpr const size_t MERGE_K_OVERSAMPLE = 4;
+
+// Sequentially merges the given runs into Out using a loser tree. Each
+// internal node of the tree holds the source that lost the comparison
+// there, so replacing the winner only needs to replay one leaf-to-root path.
+template <typename assignment_tag, typename Iterator, typename OutIterator, typename BinaryOp>
+void loser_tree_merge(const std::vector<slice<Iterator, Iterator>>& Runs,
+                      OutIterator Out, const BinaryOp& f) {
+  size_t k = Runs.size();
+  if (k == 0) return;
+  if (k == 1) {
+    for (size_t i = 0; i < Runs[0].size(); i++) assign_dispatch(Out[i], Runs[0][i], assignment_tag{});
+    return;
+  }
+
+  size_t total = 0;
+  for (const auto& r : Runs) total += r.size();
+  size_t m = 1;
+  while (m < k) m *= 2;
+  std::vector<size_t> pos(k, 0);
+
+  // true if the head of run a should be output before the head of run b.
+  // Exhausted runs, and the padding leaves numbered k and up, lose to all.
+  auto beats = [&](size_t a, size_t b) {
+    if (a >= k || pos[a] == Runs[a].size()) return false;
+    if (b >= k || pos[b] == Runs[b].size()) return true;
+    const auto& x = Runs[a][pos[a]];
+    const auto& y = Runs[b][pos[b]];
+    return (a < b) ? !f(y, x) : f(x, y);
+  };
+
+  // build bottom up, keeping the winners of each subtree in w
+  std::vector<size_t> tree(m), w(2 * m);
+  for (size_t i = 0; i < m; i++) w[m + i] = i;
+  for (size_t node = m - 1; node >= 1; node--) {
+    size_t a = w[2 * node], b = w[2 * node + 1];
+    if (beats(a, b)) { w[node] = a; tree[node] = b; }
+    else { w[node] = b; tree[node] = a; }
+  }
+  size_t winner = w[1];
+
+  for (size_t o = 0; o < total; o++) {
+    assign_dispatch(Out[o], Runs[winner][pos[winner]], assignment_tag{});
+    pos[winner]++;
+    for (size_t node = (winner + m) / 2; node >= 1; node /= 2) {
+      if (beats(tree[node], winner)) std::swap(tree[node], winner);
+    }
+  }
+}
+
+// Merges the sorted runs in Runs into R, which must have room for
+// all of their elements.
+template <typename assignment_tag, typename Iterator, typename OutIterator, typename BinaryOp>
+void merge_k_into(const sequence<slice<Iterator, Iterator>>& Runs,
+                  slice<OutIterator, OutIterator> R,
+                  const BinaryOp& f) {
+  size_t k = Runs.size();
+  size_t n = R.size();
+  size_t num_parts = (std::min)(8 * static_cast<size_t>(num_workers()), n / _merge_base);
+
+  if (num_parts <= 1) {
+    std::vector<slice<Iterator, Iterator>> runs;
+    for (const auto& r : Runs) if (r.size() > 0) runs.push_back(r);
+    loser_tree_merge<assignment_tag>(runs, R.begin(), f);
+    return;
+  }
+
+  // Regularly sample every run, and sort the samples in the total order on
+  // (value, run, position) so that splitters are distinct even when the
+  // values are not. Each cut is then within k * stride of its target rank.
+  size_t stride = (std::max)(size_t{1}, n / (MERGE_K_OVERSAMPLE * num_parts * k));
+  auto sample_offsets = internal::tabulate(k, [&](size_t i) {
+    return (Runs[i].size() + stride - 1) / stride;
+  });
+  size_t num_samples = internal::scan_inplace(make_slice(sample_offsets), plus<size_t>());
+  auto samples = sequence<std::pair<size_t, size_t>>(num_samples);
+  parallel_for(0, k, [&](size_t i) {
+    size_t start = sample_offsets[i];
+    size_t end = (i + 1 < k) ? sample_offsets[i + 1] : num_samples;
+    for (size_t j = start; j < end; j++) samples[j] = std::make_pair(i, (j - start) * stride);
+  }, 1);
+
+  auto before = [&](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+    const auto& x = Runs[a.first][a.second];
+    const auto& y = Runs[b.first][b.second];
+    if (f(x, y)) return true;
+    if (f(y, x)) return false;
+    return a < b;
+  };
+  sample_sort_inplace(make_slice(samples), before);
+
+  // Cuts[j * k + i] is where run i is cut to start partition j, i.e., the
+  // number of elements of run i that come before the jth splitter
+  auto Cuts = internal::tabulate((num_parts + 1) * k, [&](size_t idx) -> size_t {
+    size_t j = idx / k, i = idx % k;
+    const auto& run = Runs[i];
+    if (j == 0) return 0;
+    if (j == num_parts) return run.size();
+    auto [q, p] = samples[j * num_samples / num_parts];
+    const auto& v = Runs[q][p];
+    if (i == q) return p;
+    if (i < q) return std::upper_bound(run.begin(), run.end(), v, f) - run.begin();
+    return std::lower_bound(run.begin(), run.end(), v, f) - run.begin();
+  });
+
+  parallel_for(0, num_parts, [&](size_t j) {
+    size_t offset = 0;
+    std::vector<slice<Iterator, Iterator>> runs;
+    for (size_t i = 0; i < k; i++) {
+      size_t start = Cuts[j * k + i], end = Cuts[(j + 1) * k + i];
+      offset += start;
+      if (end > start) runs.push_back(Runs[i].cut(start, end));
+    }
+    loser_tree_merge<assignment_tag>(runs, R.begin() + offset, f);
+  }, 1);
+}
+
+// Merges the sorted runs in Runs, copying their contents into the
+// resulting sequence
+template <typename Iterator, typename BinaryOp>
+auto merge_k(const sequence<slice<Iterator, Iterator>>& Runs, const BinaryOp& f) {
+  using T = typename slice<Iterator, Iterator>::value_type;
+  size_t n = 0;
+  for (const auto& r : Runs) n += r.size();
+  auto R = sequence<T>::uninitialized(n);
+  merge_k_into<uninitialized_copy_tag>(Runs, make_slice(R), f);
+  return R;
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_MERGE_K_H_
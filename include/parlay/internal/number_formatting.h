@@ -0,0 +1,109 @@
+#ifndef PARLAY_INTERNAL_NUMBER_FORMATTING_H_
+#define PARLAY_INTERNAL_NUMBER_FORMATTING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <type_traits>
+
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace parlay {
+namespace internal {
+
+// Writing numbers into a caller-supplied buffer without allocating.
+// Integers are written two digits at a time from a table of the pairs
+// "00" to "99", so one division by 100 produces two digits.  Floating
+// point numbers are written in the shortest form that reads back as the
+// same value, with std::to_chars where the standard library supports
+// it for floating point (libstdc++ and MSVC implement it with Ryu), and
+// otherwise by trying increasing precisions with snprintf.
+
+// An upper bound on the number of characters written for any number
+constexpr size_t max_number_chars = 32;
+
+inline constexpr char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+inline size_t count_digits(uint64_t v) {
+  size_t n = 1;
+  while (true) {
+    if (v < 10) return n;
+    if (v < 100) return n + 1;
+    if (v < 1000) return n + 2;
+    if (v < 10000) return n + 3;
+    v /= 10000;
+    n += 4;
+  }
+}
+
+// Writes the decimal digits of v at p, and returns the end
+inline char* format_unsigned(char* p, uint64_t v) {
+  char* end = p + count_digits(v);
+  char* q = end;
+  while (v >= 100) {
+    q -= 2;
+    std::memcpy(q, digit_pairs + 2 * (v % 100), 2);
+    v /= 100;
+  }
+  if (v >= 10) std::memcpy(q - 2, digit_pairs + 2 * v, 2);
+  else *(q - 1) = static_cast<char>('0' + v);
+  return end;
+}
+
+inline char* format_signed(char* p, int64_t v) {
+  auto u = static_cast<uint64_t>(v);
+  if (v < 0) {
+    *p++ = '-';
+    u = 0 - u;
+  }
+  return format_unsigned(p, u);
+}
+
+// The number of characters that format_signed or format_unsigned writes
+template<typename Integer_>
+size_t formatted_length(Integer_ v) {
+  if constexpr (std::is_signed_v<Integer_>) {
+    return (v < 0) ? 1 + count_digits(0 - static_cast<uint64_t>(v)) : count_digits(static_cast<uint64_t>(v));
+  }
+  else {
+    return count_digits(static_cast<uint64_t>(v));
+  }
+}
+
+// Writes the shortest representation of v that reads back as v at p,
+// and returns the end
+template<typename Float_>
+char* format_float(char* p, Float_ v) {
+  static_assert(std::is_same_v<Float_, float> || std::is_same_v<Float_, double>);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  return std::to_chars(p, p + max_number_chars, v).ptr;
+#else
+  constexpr int min_precision = std::is_same_v<Float_, float> ? 6 : 15;
+  constexpr int max_precision = std::is_same_v<Float_, float> ? 9 : 17;
+  int len = 0;
+  for (int precision = min_precision; precision <= max_precision; precision++) {
+    len = std::snprintf(p, max_number_chars, "%.*g", precision, static_cast<double>(v));
+    Float_ back;
+    if constexpr (std::is_same_v<Float_, float>) back = std::strtof(p, nullptr);
+    else back = std::strtod(p, nullptr);
+    if (back == v || v != v) break;
+  }
+  return p + len;
+#endif
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_INTERNAL_NUMBER_FORMATTING_H_
@@ -20,6 +20,20 @@ class file_map {
   private:
     char* begin_p;
     char* end_p;
+    bool writable = false;
+
+    // Passes the access hints of options to the kernel.  Hints that fail
+    // (e.g., huge pages on a file system that does not support them) are
+    // ignored, since they do not change the contents of the map.
+    static void advise(char* p, size_t n, const file_map_options& options) {
+      if (options.access == file_map_options::access_pattern::sequential) madvise(p, n, MADV_SEQUENTIAL);
+      else if (options.access == file_map_options::access_pattern::random) madvise(p, n, MADV_RANDOM);
+      if (options.will_need) madvise(p, n, MADV_WILLNEED);
+#if defined(MADV_HUGEPAGE)
+      if (options.huge_pages) madvise(p, n, MADV_HUGEPAGE);
+#endif
+    }
+
   public:
   
     using value_type = char;
@@ -36,24 +50,55 @@ class file_map {
     const char* begin() const { return begin_p; }
     const char* end() const {return end_p; }
 
+    // The contents of a writable map, for writing
+    char* data() {
+      assert(writable);
+      return begin_p;
+    }
+
     size_t size() const { return end() - begin(); }
 
-    explicit file_map(const std::string& filename) {
+    explicit file_map(const std::string& filename, const file_map_options& options = {})
+        : begin_p(nullptr), end_p(nullptr), writable(options.writable) {
       
       struct stat sb;
-      int fd = open(filename.c_str(), O_RDONLY);
+      int fd = open(filename.c_str(), options.writable ? O_RDWR : O_RDONLY);
       assert(fd != -1);
       [[maybe_unused]] auto fstat_res = fstat(fd, &sb);
       assert(fstat_res != -1);
       assert(S_ISREG(sb.st_mode));
-    
-      char *p = static_cast<char*>(mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
-      assert(p != MAP_FAILED);
+
+      // An empty file can not be mapped
+      if (sb.st_size > 0) {
+        int prot = options.writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        int flags = options.writable ? MAP_SHARED : MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        if (options.prefault == file_map_options::prefault_mode::populate) flags |= MAP_POPULATE;
+#endif
+        char *p = static_cast<char*>(mmap(0, sb.st_size, prot, flags, fd, 0));
+        assert(p != MAP_FAILED);
+        begin_p = p;
+        end_p = p + sb.st_size;
+        advise(p, sb.st_size, options);
+      }
       [[maybe_unused]] int close_p = ::close(fd);
       assert(close_p != -1);
-      
-      begin_p = p;
-      end_p = p + sb.st_size;
+
+      if (options.prefault == file_map_options::prefault_mode::parallel) {
+        internal::prefault_pages(begin_p, size());
+      }
+    }
+
+    // Creates (or truncates) a file of the given size, and maps it for writing
+    static file_map create(const std::string& filename, size_t size, file_map_options options = {}) {
+      int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      assert(fd != -1);
+      [[maybe_unused]] int truncate_res = ftruncate(fd, static_cast<off_t>(size));
+      assert(truncate_res != -1);
+      [[maybe_unused]] int close_p = ::close(fd);
+      assert(close_p != -1);
+      options.writable = true;
+      return file_map(filename, options);
     }
     
     ~file_map() {
@@ -64,9 +109,10 @@ class file_map {
     file_map(const file_map&) = delete;
     file_map& operator=(const file_map&) = delete;
     
-    file_map(file_map&& other) noexcept : begin_p(other.begin_p), end_p(other.end_p) {
+    file_map(file_map&& other) noexcept : begin_p(other.begin_p), end_p(other.end_p), writable(other.writable) {
       other.begin_p = nullptr;
       other.end_p = nullptr;
+      other.writable = false;
     }
     
     file_map& operator=(file_map&& other) noexcept {
@@ -74,6 +120,16 @@ class file_map {
       swap(other);
       return *this;
     }
+
+    bool is_writable() const { return writable; }
+
+    // Waits for the writes to a writable map to reach the file
+    void flush() {
+      if (writable && begin_p != nullptr) {
+        [[maybe_unused]] int sync_res = msync(begin_p, end_p - begin_p, MS_SYNC);
+        assert(sync_res != -1);
+      }
+    }
     
     void close() {
       if (begin_p != nullptr) {
@@ -81,11 +137,13 @@ class file_map {
       }
       begin_p = nullptr;
       end_p = nullptr;
+      writable = false;
     }
     
     void swap(file_map& other) {
       std::swap(other.begin_p, begin_p);
       std::swap(other.end_p, end_p);
+      std::swap(other.writable, writable);
     }
     
     bool empty() const {
@@ -17,15 +17,25 @@
 #include "sequence_ops.h"
 #include "transpose.h"
 
+#include "../hardware.h"
 #include "../utilities.h"
 
 namespace parlay {
 namespace internal {
 
 // the following parameters can be tuned
-constexpr const size_t QUICKSORT_THRESHOLD = 16384;
+constexpr const size_t QUICKSORT_MIN_THRESHOLD = 4096;
+constexpr const size_t QUICKSORT_MAX_THRESHOLD = 65536;
 constexpr const size_t OVER_SAMPLE = 8;
 
+// Inputs smaller than this are sorted sequentially. It is chosen so
+// that the input fits in half of the L2 cache.
+template <typename T>
+size_t quicksort_threshold() {
+  size_t n = get_hardware_profile().l2_size / (2 * sizeof(T));
+  return (std::min)((std::max)(n, QUICKSORT_MIN_THRESHOLD), QUICKSORT_MAX_THRESHOLD);
+}
+
 // generates counts in Sc for the number of keys in Sa between consecutive
 // values of Sb. Sa and Sb must be sorted
 template <typename InIterator, typename PivotIterator, typename CountIterator, typename Compare>
@@ -64,6 +74,35 @@ void get_bucket_counts(slice<InIterator, InIterator> sA,
   *itC = static_cast<s_size_t>(sA.end() - itA);
 }
 
+// Picks up to num_pivots pivots from the sorted samples, returning their
+// positions. Normally these are the samples at multiples of stride, but a
+// value that fills at least stride samples is likely to be a heavy hitter,
+// so it is picked exactly twice in a row instead. get_bucket_counts puts the
+// keys equal to a repeated pivot into a bucket of their own, which is then
+// known to need no sorting. Since only heavy runs repeat a pivot, a bucket
+// i is such an equality bucket iff pivots i-1 and i have the same position.
+template <typename Iterator, typename Compare>
+sequence<size_t> select_pivots(slice<Iterator, Iterator> samples, size_t num_pivots,
+                               size_t stride, const Compare& less) {
+  size_t n = samples.size();
+  sequence<size_t> pivots;
+  pivots.reserve(2 * num_pivots + 2);  // a heavy run adds its pivot twice
+  size_t next = 0;  // the next multiple of stride
+  for (size_t i = 0; i < n && next < num_pivots * stride; ) {
+    size_t j = i + 1;
+    while (j < n && !less(samples[i], samples[j])) j++;
+    if (j - i >= stride) {
+      pivots.push_back(i);
+      pivots.push_back(i);
+    } else if (next < j) {
+      pivots.push_back(next);
+    }
+    while (next < j) next += stride;
+    i = j;
+  }
+  return pivots;
+}
+
 template <typename Iterator, typename Compare>
 void seq_sort_inplace(slice<Iterator, Iterator> A, const Compare& less, bool stable) {
   using value_type = typename slice<Iterator, Iterator>::value_type;
@@ -96,7 +135,7 @@ void sample_sort_inplace_(slice<InIterator, InIterator> In,
   using value_type = typename slice<InIterator, InIterator>::value_type;
   size_t n = In.size();
 
-  if (n < QUICKSORT_THRESHOLD) {
+  if (n < quicksort_threshold<value_type>()) {
     seq_sort_inplace(In, less, false);
   } else {
     // The larger these are, the more comparisons are done but less
@@ -120,7 +159,6 @@ void sample_sort_inplace_(slice<InIterator, InIterator> In,
     size_t block_size = ((n - 1) / num_blocks) + 1;
     size_t num_buckets = (sqrt / bucket_quotient) + 1;
     size_t sample_set_size = sample_blocks * block_size;
-    size_t m = num_blocks * num_buckets;
 
     // We want to select evenly spaced pivots from the sorted samples
     // Since we sampled sample_set_size many elements, and we need
@@ -143,10 +181,15 @@ void sample_sort_inplace_(slice<InIterator, InIterator> In,
     auto sample_set = make_slice(In.begin(), In.begin() + sample_set_size);
     quicksort(sample_set.begin(), sample_set_size, less);
 
+    // select evenly spaced pivots, giving heavy hitters their own buckets
+    auto pivot_pos = select_pivots(sample_set, num_buckets - 1, stride, less);
+    num_buckets = pivot_pos.size() + 1;
+    size_t m = num_blocks * num_buckets;
+
     // Pivots returns by reference to avoid making copies
     auto pivots = delayed_seq<const value_type&>(num_buckets - 1, [&](size_t i) -> const value_type& {
-      assert(stride * i < sample_set_size);
-      return sample_set[stride * i];
+      assert(pivot_pos[i] < sample_set_size);
+      return sample_set[pivot_pos[i]];
     });
 
     // sort each block and merge with samples to get counts for each bucket
@@ -180,13 +223,13 @@ void sample_sort_inplace_(slice<InIterator, InIterator> In,
     parallel_for(0, num_buckets, [&](size_t i) {
       size_t start = bucket_offsets[i];
       size_t end = bucket_offsets[i + 1];
-      // This could be optimized by not sorting a bucket if its two adjacent
-      // pivots were equal, since this means that all of the contents of the
-      // bucket are equal. But we don't know where the pivots are anymore
-      // since we just merged them in. We could chose to precompute flags
-      // indicating which adjacent pivots are equal, but is it worth it?
-      seq_sort_inplace(Out.cut(start, end), less, false);
-     }, 1);
+      // buckets need not be sorted if two consecutive pivots are equal.
+      // The pivots themselves have been moved by now, but their positions
+      // among the samples tell us which ones were.
+      if (i == 0 || i == num_buckets - 1 || pivot_pos[i - 1] != pivot_pos[i]) {
+        seq_sort_inplace(Out.cut(start, end), less, false);
+      }
+    }, 1);
   }
 }
 
@@ -204,7 +247,7 @@ void sample_sort_(slice<InIterator, InIterator> In,
   using value_type = typename slice<InIterator, InIterator>::value_type;
   size_t n = In.size();
 
-  if (n < QUICKSORT_THRESHOLD) {
+  if (n < quicksort_threshold<value_type>()) {
     seq_sort_<uninitialized_copy_tag>(In, Out, less, stable);
   } else {
     // The larger these are, the more comparisons are done but less
@@ -223,7 +266,6 @@ void sample_sort_(slice<InIterator, InIterator> In,
     size_t block_size = ((n - 1) / num_blocks) + 1;
     size_t num_buckets = (sqrt / bucket_quotient) + 1;
     size_t sample_set_size = num_buckets * OVER_SAMPLE;
-    size_t m = num_blocks * num_buckets;
 
     // generate "random" samples with oversampling
     auto sample_set = sequence<value_type>::from_function(sample_set_size,
@@ -231,9 +273,12 @@ void sample_sort_(slice<InIterator, InIterator> In,
     // sort the samples
     quicksort(sample_set.begin(), sample_set_size, less);
 
-    // subselect samples at even stride
+    // subselect samples at even stride, giving heavy hitters their own buckets
+    auto pivot_pos = select_pivots(make_slice(sample_set), num_buckets - 1, OVER_SAMPLE, less);
+    num_buckets = pivot_pos.size() + 1;
+    size_t m = num_blocks * num_buckets;
     auto pivots = sequence<value_type>::from_function(num_buckets - 1,
-                                                      [&](size_t i) { return sample_set[OVER_SAMPLE * i]; });
+                                                      [&](size_t i) { return sample_set[pivot_pos[i]]; });
 
     auto Tmp = uninitialized_sequence<value_type>(n);
 
@@ -257,7 +302,7 @@ void sample_sort_(slice<InIterator, InIterator> In,
       size_t end = bucket_offsets[i + 1];
 
       // buckets need not be sorted if two consecutive pivots are equal
-      if (i == 0 || i == num_buckets - 1 || less(pivots[i - 1], pivots[i])) {
+      if (i == 0 || i == num_buckets - 1 || pivot_pos[i - 1] != pivot_pos[i]) {
         seq_sort_inplace(Out.cut(start, end), less, stable);
       }
     }, 1);
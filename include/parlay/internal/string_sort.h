@@ -0,0 +1,221 @@
+// Parallel multikey quicksort for sequences of strings. Based on
+//
+// Fast Algorithms for Sorting and Searching Strings.
+// Jon L. Bentley and Robert Sedgewick.
+// Proc. ACM-SIAM Symposium on Discrete Algorithms (SODA), 1997
+//
+// Strings are partitioned three ways on their character at the current
+// depth, so a shared prefix is only ever inspected once per string instead
+// of once per comparison. The longest common prefix (LCP) of each adjacent
+// pair of strings in the output falls out of the partitioning for free:
+// two strings separated at depth d share exactly d characters.
+
+#ifndef PARLAY_STRING_SORT_H_
+#define PARLAY_STRING_SORT_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "sequence_ops.h"
+#include "uninitialized_sequence.h"
+
+#include "../parallel.h"
+#include "../range.h"
+#include "../sequence.h"
+#include "../slice.h"
+#include "../utilities.h"
+
+namespace parlay {
+namespace internal {
+
+// the following parameters can be tuned
+constexpr const size_t STRING_SORT_SEQ_THRESHOLD = 16384;
+constexpr const size_t STRING_SORT_INSERTION_THRESHOLD = 16;
+
+// Gives access to the characters of the strings being sorted. Characters
+// are compared as unsigned chars (the same as std::string), and are shifted
+// up by one so that the end of a string compares less than any character.
+template <typename StringIterator>
+struct string_chars {
+  StringIterator strings;
+
+  int operator()(size_t i, size_t d) const {
+    const auto& s = strings[i];
+    if (d >= static_cast<size_t>(parlay::size(s))) return 0;
+    return static_cast<int>(static_cast<unsigned char>(std::begin(s)[d])) + 1;
+  }
+
+  // Length of the longest common prefix of strings i and j, given
+  // that they are already known to agree on the first d characters
+  size_t lcp(size_t i, size_t j, size_t d) const {
+    const auto& a = strings[i];
+    const auto& b = strings[j];
+    size_t m = (std::min)(static_cast<size_t>(parlay::size(a)), static_cast<size_t>(parlay::size(b)));
+    auto ia = std::begin(a);
+    auto ib = std::begin(b);
+    while (d < m && ia[d] == ib[d]) d++;
+    return d;
+  }
+
+  // True if string i is less than string j, given
+  // that they agree on the first d characters
+  bool less(size_t i, size_t j, size_t d) const {
+    d = lcp(i, j, d);
+    return (*this)(i, d) < (*this)(j, d);
+  }
+};
+
+// Sorts the indices A[0, n) by the strings they refer to, given that
+// all of them agree on the first d characters. On return, L[i] holds
+// the LCP of the strings at A[i-1] and A[i] for 0 < i < n.
+template <typename Chars, typename IdxIterator, typename LcpIterator>
+void string_insertion_sort(const Chars& C, IdxIterator A, LcpIterator L, size_t n, size_t d) {
+  for (size_t i = 1; i < n; i++) {
+    size_t j = i;
+    while (j > 0 && C.less(A[j], A[j - 1], d)) {
+      using std::swap;
+      swap(A[j], A[j - 1]);
+      j--;
+    }
+  }
+  for (size_t i = 1; i < n; i++) L[i] = C.lcp(A[i - 1], A[i], d);
+}
+
+template <typename Chars, typename IdxIterator, typename LcpIterator>
+void multikey_quicksort_serial(const Chars& C, IdxIterator A, LcpIterator L, size_t n, size_t d) {
+  while (n > STRING_SORT_INSERTION_THRESHOLD) {
+    // median of three pivot character
+    int a = C(A[0], d), b = C(A[n / 2], d), c = C(A[n - 1], d);
+    int v = (std::max)((std::min)(a, b), (std::min)((std::max)(a, b), c));
+
+    // three-way partition on the character at depth d:
+    //   [0, lt) < v,  [lt, gt) == v,  [gt, n) > v
+    size_t lt = 0, i = 0, gt = n;
+    while (i < gt) {
+      int x = C(A[i], d);
+      using std::swap;
+      if (x < v) swap(A[lt++], A[i++]);
+      else if (x > v) swap(A[i], A[--gt]);
+      else i++;
+    }
+
+    // adjacent strings in different parts differ at depth d
+    if (lt > 0) L[lt] = d;
+    if (gt < n) L[gt] = d;
+
+    multikey_quicksort_serial(C, A, L, lt, d);
+    multikey_quicksort_serial(C, A + gt, L + gt, n - gt, d);
+
+    // the middle part all ended at depth d, so they are equal
+    if (v == 0) {
+      for (size_t k = lt + 1; k < gt; k++) L[k] = d;
+      return;
+    }
+    A += lt;
+    L += lt;
+    n = gt - lt;
+    d++;
+  }
+  string_insertion_sort(C, A, L, n, d);
+}
+
+// Parallel multikey quicksort. Large parts are partitioned in parallel
+// using split_three, and the three resulting parts are sorted in parallel.
+// Tmp is used as scratch space and must be the same size as A.
+template <typename Chars, typename IdxIterator, typename LcpIterator>
+void multikey_quicksort(const Chars& C,
+                        slice<IdxIterator, IdxIterator> A,
+                        slice<IdxIterator, IdxIterator> Tmp,
+                        slice<LcpIterator, LcpIterator> L,
+                        size_t d) {
+  size_t n = A.size();
+  if (n < STRING_SORT_SEQ_THRESHOLD) {
+    multikey_quicksort_serial(C, A.begin(), L.begin(), n, d);
+  } else {
+    // pick the median character of a small sample as the pivot
+    constexpr size_t num_samples = 9;
+    int samples[num_samples];
+    for (size_t i = 0; i < num_samples; i++) samples[i] = C(A[hash64(i) % n], d);
+    std::nth_element(samples, samples + num_samples / 2, samples + num_samples);
+    int v = samples[num_samples / 2];
+
+    auto flags = internal::tabulate(n, [&](size_t i) -> unsigned char {
+      int x = C(A[i], d);
+      return (x < v) ? 0 : (x == v) ? 1 : 2;
+    });
+    auto [lt, m] = split_three<uninitialized_copy_tag>(A, Tmp, flags);
+    size_t gt = lt + m;
+    parallel_for(0, n, [&](size_t i) { A[i] = Tmp[i]; });
+
+    if (lt > 0) L[lt] = d;
+    if (gt < n) L[gt] = d;
+
+    auto left = [&, lt = lt]() {
+      multikey_quicksort(C, A.cut(0, lt), Tmp.cut(0, lt), L.cut(0, lt), d);
+    };
+    auto right = [&, gt = gt]() {
+      multikey_quicksort(C, A.cut(gt, n), Tmp.cut(gt, n), L.cut(gt, n), d);
+    };
+
+    // the middle part all ended at depth d, so they are equal
+    if (v == 0) {
+      par_do(left, right);
+      parallel_for(lt + 1, gt, [&](size_t k) { L[k] = d; });
+    }
+    // otherwise sort the middle part on the next character
+    // while the outer parts are sorted on the current one
+    else {
+      auto mid = [&, lt = lt, gt = gt]() {
+        multikey_quicksort(C, A.cut(lt, gt), Tmp.cut(lt, gt), L.cut(lt, gt), d + 1);
+      };
+      par_do3(left, mid, right);
+    }
+  }
+}
+
+// Returns a pair consisting of the permutation that sorts the given
+// strings, and the LCP array of the sorted strings, i.e., the length
+// of the longest common prefix of the (i-1)th and ith smallest strings.
+// The first entry of the LCP array is always zero.
+template <typename Iterator>
+auto string_sort_lcp(slice<Iterator, Iterator> Strings) {
+  size_t n = Strings.size();
+  auto C = string_chars<Iterator>{Strings.begin()};
+  auto idx = internal::tabulate(n, [](size_t i) { return i; });
+  auto lcp = sequence<size_t>(n, 0);
+  auto tmp = sequence<size_t>::uninitialized(n);
+  multikey_quicksort(C, make_slice(idx), make_slice(tmp), make_slice(lcp), 0);
+  if (n > 0) lcp[0] = 0;
+  return std::make_pair(std::move(idx), std::move(lcp));
+}
+
+template <typename Iterator>
+auto string_sort(slice<Iterator, Iterator> Strings) {
+  using value_type = typename slice<Iterator, Iterator>::value_type;
+  auto perm = string_sort_lcp(Strings).first;
+  return internal::tabulate(Strings.size(), [&](size_t i) -> value_type {
+    return Strings[perm[i]];
+  });
+}
+
+template <typename Iterator>
+void string_sort_inplace(slice<Iterator, Iterator> Strings) {
+  using value_type = typename slice<Iterator, Iterator>::value_type;
+  size_t n = Strings.size();
+  auto perm = string_sort_lcp(Strings).first;
+  auto sorted = uninitialized_sequence<value_type>(n);
+  parallel_for(0, n, [&](size_t i) {
+    uninitialized_relocate(&sorted[i], &Strings[perm[i]]);
+  });
+  parallel_for(0, n, [&](size_t i) {
+    uninitialized_relocate(&Strings[i], &sorted[i]);
+  });
+}
+
+}  // namespace internal
+}  // namespace parlay
+
+#endif  // PARLAY_STRING_SORT_H_
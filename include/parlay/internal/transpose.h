@@ -2,6 +2,7 @@
 #ifndef PARLAY_TRANSPOSE_H_
 #define PARLAY_TRANSPOSE_H_
 
+#include "../hardware.h"
 #include "../utilities.h"
 
 namespace parlay {
@@ -13,11 +14,15 @@ constexpr const size_t TRANS_THRESHHOLD = PAR_GRANULARITY / 4;
 constexpr const size_t TRANS_THRESHHOLD = 500;
 #endif
 
+// Inputs with fewer elements than this are transposed directly rather than
+// cache obliviously. It is the number of words that fit in the L3 cache.
+inline size_t non_cache_oblivious_threshold() {
 #ifdef DEBUG
-constexpr const size_t NON_CACHE_OBLIVIOUS_THRESHOLD = 10000;
+  return 10000;
 #else
-constexpr const size_t NON_CACHE_OBLIVIOUS_THRESHOLD = 1 << 22;
+  return get_hardware_profile().l3_size / 8;
 #endif
+}
 
 inline size_t split(size_t n) { return n / 2; }
 
@@ -134,7 +139,7 @@ sequence<size_t> transpose_buckets(InIterator From, OutIterator To,
   auto add = plus<s_size_t>();
 
   // for smaller input do non-cache oblivious version
-  if (n < NON_CACHE_OBLIVIOUS_THRESHOLD || num_buckets <= 512 || num_blocks <= 512) {
+  if (n < non_cache_oblivious_threshold() || num_buckets <= 512 || num_blocks <= 512) {
     size_t block_bits = log2_up(num_blocks);
     size_t block_mask = num_blocks - 1;
     assert(size_t{1} << block_bits == num_blocks);
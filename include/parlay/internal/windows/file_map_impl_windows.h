@@ -29,7 +29,8 @@ struct file_map {
     HANDLE hFile;         // the file handle
 
     char* first;
-    size_t size;
+    size_t length;
+    bool writable;
   public:
     using value_type = char;
     using reference = char&;
@@ -43,13 +44,24 @@ struct file_map {
 
     char operator[] (size_t i) const { return begin()[i]; }
     const char* begin() const { return first; }
-    const char* end() const { return first + size; }
+    const char* end() const { return first + length; }
 
-    explicit file_map(const std::string& filename) {
+    // The contents of a writable map, for writing
+    char* data() {
+      assert(writable);
+      return first;
+    }
+
+    size_t size() const { return length; }
+
+    // The access pattern, will_need and huge_pages options have no
+    // counterpart here and are ignored
+    explicit file_map(const std::string& filename, const file_map_options& options = {})
+        : hMapFile(NULL), hFile(NULL), first(nullptr), length(0), writable(options.writable) {
 
       // Open file handle
       hFile = CreateFile(filename.c_str(),
-        GENERIC_READ,
+        writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
         0,
         NULL,
         OPEN_EXISTING,
@@ -58,11 +70,22 @@ struct file_map {
 
       assert(hFile != INVALID_HANDLE_VALUE);
 
+      LARGE_INTEGER file_size;
+      GetFileSizeEx(hFile, &file_size);
+      length = static_cast<size_t>(file_size.QuadPart);
+
+      // An empty file can not be mapped
+      if (length == 0) {
+        [[maybe_unused]] auto closedFile = CloseHandle(hFile);
+        assert(closedFile);
+        hFile = NULL;
+        return;
+      }
+
       // Create a file mapping object for the file
-      // Note that it is a good idea to ensure the file size is not zero
       hMapFile = CreateFileMapping(hFile,          // current file handle
         NULL,            // default security
-        PAGE_READONLY,   // read/write permission
+        writable ? PAGE_READWRITE : PAGE_READONLY,
         0,               // size of mapping object, high
         0,               // size of mapping object, low
         NULL);           // name of mapping object
@@ -71,7 +94,7 @@ struct file_map {
 
       first = static_cast<char*>(
         MapViewOfFile(hMapFile,       // handle to mapping object
-        FILE_MAP_READ,                    // read/write
+        writable ? FILE_MAP_WRITE : FILE_MAP_READ,
         0,
         0,
         0)
@@ -79,9 +102,25 @@ struct file_map {
 
       assert(first != nullptr);
 
-      LARGE_INTEGER file_size;
-      GetFileSizeEx(hFile, &file_size);
-      size = static_cast<size_t>(file_size.QuadPart);
+      if (options.prefault != file_map_options::prefault_mode::none) {
+        internal::prefault_pages(first, length);
+      }
+    }
+
+    // Creates (or truncates) a file of the given size, and maps it for writing
+    static file_map create(const std::string& filename, size_t size, file_map_options options = {}) {
+      HANDLE h = CreateFile(filename.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+      assert(h != INVALID_HANDLE_VALUE);
+      LARGE_INTEGER new_size;
+      new_size.QuadPart = static_cast<LONGLONG>(size);
+      [[maybe_unused]] auto moved = SetFilePointerEx(h, new_size, NULL, FILE_BEGIN);
+      assert(moved);
+      [[maybe_unused]] auto extended = SetEndOfFile(h);
+      assert(extended);
+      [[maybe_unused]] auto closed = CloseHandle(h);
+      assert(closed);
+      options.writable = true;
+      return file_map(filename, options);
     }
     
     ~file_map() {
@@ -92,11 +131,13 @@ struct file_map {
     file_map(const file_map&) = delete;
     file_map& operator=(const file_map&) = delete;
     
-    file_map(file_map&& other) noexcept : hMapFile(other.hMapFile), hFile(other.hFile), first(other.first), size(other.size)  {
+    file_map(file_map&& other) noexcept : hMapFile(other.hMapFile), hFile(other.hFile), first(other.first),
+        length(other.length), writable(other.writable) {
       other.hMapFile = NULL;
       other.hFile = NULL;
       other.first = nullptr;
-      other.size = 0;
+      other.length = 0;
+      other.writable = false;
     }
     
     file_map& operator=(file_map&& other) noexcept {
@@ -104,6 +145,18 @@ struct file_map {
       swap(other);
       return *this;
     }
+
+    bool is_writable() const { return writable; }
+
+    // Waits for the writes to a writable map to reach the file
+    void flush() {
+      if (writable && first != nullptr) {
+        [[maybe_unused]] auto flushed = FlushViewOfFile(first, 0);
+        assert(flushed);
+        [[maybe_unused]] auto flushedFile = FlushFileBuffers(hFile);
+        assert(flushedFile);
+      }
+    }
     
     void close() {
       if (first != nullptr) {
@@ -113,19 +166,20 @@ struct file_map {
         assert(closedMapping);
         auto closedFile = CloseHandle(hFile);
         assert(closedFile);
-
-        first = nullptr;
-        size = 0;
-        hFile = NULL;
-        hMapFile = NULL;
       }
+      first = nullptr;
+      length = 0;
+      writable = false;
+      hFile = NULL;
+      hMapFile = NULL;
     }
 
     void swap(file_map& other) {
       std::swap(hFile, other.hFile);
       std::swap(hMapFile, other.hMapFile);
       std::swap(first, other.first);
-      std::swap(size, other.size);
+      std::swap(length, other.length);
+      std::swap(writable, other.writable);
     }
 
     bool empty() const {
@@ -3,6 +3,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cerrno>
 #include <cinttypes>
 #include <cstdint>
 #include <cstdio>
@@ -10,15 +11,25 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <iterator>
 #include <fstream>
+#include <future>
+#include <memory>
 #include <string>
+#include <system_error>
 #include <utility>
 
+#include "parallel.h"
 #include "primitives.h"
 #include "sequence.h"
 #include "slice.h"
 
+#include "internal/async_file.h"
+#include "internal/file_io.h"
+#include "internal/number_formatting.h"
+#include "internal/number_parsing.h"
+
 namespace parlay {
 
 // ----------------------------------------------------------------------------
@@ -49,6 +60,52 @@ inline chars chars_from_file(const std::string& filename,
   return chars;
 }
 
+// Options for chars_from_file_parallel
+struct file_read_options {
+  // bytes read by each positioned read
+  size_t block_size = size_t{1} << 22;
+  // touch the pages of the result in parallel before reading into them
+  bool first_touch = false;
+  // bypass the page cache (O_DIRECT) where supported
+  bool direct_io = false;
+};
+
+// As chars_from_file, but splits the range into blocks that parlay workers
+// read in parallel with positioned reads directly into the result.
+inline chars chars_from_file_parallel(const std::string& filename,
+           bool null_terminate=false, std::streamoff start=0, std::streamoff end=0,
+           const file_read_options& options = {}) {
+  internal::positioned_reader file(filename, options.direct_io);
+  assert(file.is_open());
+  auto length = static_cast<std::streamoff>(file.size());
+  start = (std::min)(start,length);
+  if (end == 0) end = length;
+  else end = (std::min)(end,length);
+  size_t n = static_cast<size_t>(end - start);
+  auto chars = chars::uninitialized(n + null_terminate);
+
+  if (options.first_touch) {
+    constexpr size_t page_size = 4096;
+    parallel_for(0, (n + page_size - 1) / page_size, [&](size_t i) {
+      chars[i * page_size] = 0; });
+  }
+
+  // blocks are aligned so that direct reads need no extra pages
+  size_t a = internal::direct_io_alignment;
+  size_t block_size = (std::max)(a, (options.block_size + a - 1) / a * a);
+  size_t num_blocks = (n + block_size - 1) / block_size;
+  parallel_for(0, num_blocks, [&](size_t i) {
+    size_t s = i * block_size;
+    size_t e = (std::min)(n, s + block_size);
+    [[maybe_unused]] size_t r = file.read(chars.data() + s, e - s, static_cast<size_t>(start) + s);
+    assert(r == e - s);
+  }, 1);
+  if (null_terminate) {
+    chars[n] = 0;
+  }
+  return chars;
+}
+
 // Writes a character sequence to a stream
 inline void chars_to_stream(const chars& S, std::ostream& os) {
   os.write(S.data(), static_cast<std::streamsize>(S.size()));
@@ -61,6 +118,163 @@ inline void chars_to_file(const chars& S, const std::string& filename) {
   chars_to_stream(S, file_stream);
 }
 
+// As chars_to_file, but splits the sequence into blocks that parlay workers
+// write in parallel with positioned writes
+inline void chars_to_file_parallel(const chars& S, const std::string& filename,
+           size_t block_size=size_t{1} << 22) {
+  internal::positioned_writer file(filename);
+  assert(file.is_open());
+  size_t n = S.size();
+  file.resize(n);
+  block_size = (std::max)(block_size, size_t{1});
+  parallel_for(0, (n + block_size - 1) / block_size, [&](size_t i) {
+    size_t s = i * block_size;
+    size_t e = (std::min)(n, s + block_size);
+    [[maybe_unused]] size_t w = file.write(S.data() + s, e - s, s);
+    assert(w == e - s);
+  }, 1);
+}
+
+// Starts reading the bytes [start, end) of a file (with the same meaning as
+// for chars_from_file) in blocks of block_size bytes using an async_file,
+// and returns a future for the result.  The reads are issued immediately,
+// so e.g. the next input can be fetched while the current one is processed;
+// calling get() on the future waits for them to finish.
+inline std::future<chars> chars_from_file_async(const std::string& filename,
+           bool null_terminate=false, size_t start=0, size_t end=0, size_t block_size=size_t{1} << 22) {
+  // The state is owned by the returned future so that the result is
+  // always released by the caller and never on the I/O completion thread.
+  // The result is declared before the file so that, if the future is
+  // dropped unfinished, destroying the file waits for the reads before the
+  // result is freed.
+  struct state {
+    chars result;
+    async_file file;
+    std::atomic<int> error{0};
+    explicit state(const std::string& filename) : file(filename) {}
+  };
+  auto s = std::make_shared<state>(filename);
+  assert(s->file.is_open());
+  size_t length = s->file.size();
+  start = (std::min)(start, length);
+  end = (end == 0) ? length : (std::min)(end, length);
+  size_t n = end - start;
+  s->result = chars::uninitialized(n + null_terminate);
+  if (null_terminate) s->result[n] = 0;
+  block_size = (std::max)(block_size, size_t{1});
+  char* data = s->result.data();
+  state* sp = s.get();
+  for (size_t i = 0; i * block_size < n; i++) {
+    size_t len = (std::min)(block_size, n - i * block_size);
+    s->file.read(data + i * block_size, len, start + i * block_size, [sp, len](std::ptrdiff_t r) {
+      if (r < 0) sp->error = static_cast<int>(-r);
+      else if (static_cast<size_t>(r) != len) sp->error = EIO;
+    });
+  }
+  return std::async(std::launch::deferred, [s = std::move(s)]() {
+    s->file.wait();
+    if (s->error != 0) throw std::system_error(s->error, std::generic_category());
+    return std::move(s->result);
+  });
+}
+
+// Starts writing a character sequence to a file in blocks of block_size
+// bytes using an async_file.  Calling get() on the returned future waits
+// until all of it has been written.
+inline std::future<void> chars_to_file_async(chars S, const std::string& filename,
+           size_t block_size=size_t{1} << 22) {
+  // As above, the data outlives the file and so any write still reading it
+  struct state {
+    chars data;
+    async_file file;
+    std::atomic<int> error{0};
+    state(const std::string& filename, chars&& S) : data(std::move(S)), file(filename, async_file::mode::write) {}
+  };
+  auto s = std::make_shared<state>(filename, std::move(S));
+  assert(s->file.is_open());
+  size_t n = s->data.size();
+  block_size = (std::max)(block_size, size_t{1});
+  const char* data = s->data.data();
+  state* sp = s.get();
+  for (size_t i = 0; i * block_size < n; i++) {
+    size_t len = (std::min)(block_size, n - i * block_size);
+    s->file.write(data + i * block_size, len, i * block_size, [sp, len](std::ptrdiff_t r) {
+      if (r < 0) sp->error = static_cast<int>(-r);
+      else if (static_cast<size_t>(r) != len) sp->error = EIO;
+    });
+  }
+  return std::async(std::launch::deferred, [s = std::move(s)]() {
+    s->file.wait();
+    if (s->error != 0) throw std::system_error(s->error, std::generic_category());
+  });
+}
+
+// Reads a file in chunks of at most chunk_size bytes that end at line
+// boundaries, and calls f on each chunk in order, as a slice of chars
+// holding whole lines (the last chunk ends at the end of the file, with or
+// without a newline).  A chunk is larger than chunk_size only if it holds a
+// line that is.  While f processes a chunk, which it may do in parallel, the
+// next one is read in the background using an async_file, so the file can
+// be much larger than main memory: only the two chunks are held at a time.
+template<typename F>
+void for_each_line_chunk(const std::string& filename, F&& f, size_t chunk_size=size_t{1} << 26) {
+  constexpr size_t block_size = size_t{1} << 22;
+
+  // buffers[k % 2] holds chunk k: the unfinished line carried over from
+  // chunk k - 1, followed by the bytes read for chunk k.  They are declared
+  // before the file, which waits for its outstanding reads when destroyed.
+  chars buffers[2];
+  std::atomic<int> error{0};
+  async_file file(filename);
+  assert(file.is_open());
+  size_t length = file.size();
+  chunk_size = (std::max)(chunk_size, size_t{1});
+
+  // Starts reading n bytes at offset into buf, after its first carry bytes
+  auto start_read = [&](chars& buf, size_t carry, size_t offset, size_t n) {
+    assert(buf.size() >= carry + n);
+    for (size_t s = 0; s < n; s += block_size) {
+      size_t len = (std::min)(block_size, n - s);
+      file.read(buf.data() + carry + s, len, offset + s, [&error, len](std::ptrdiff_t r) {
+        if (r < 0) error = static_cast<int>(-r);
+        else if (static_cast<size_t>(r) != len) error = EIO;
+      });
+    }
+  };
+
+  size_t carry = 0;
+  size_t n = (std::min)(chunk_size, length);
+  buffers[0] = chars::uninitialized(n);
+  start_read(buffers[0], 0, 0, n);
+  size_t offset = n;
+  for (size_t k = 0; ; k++) {
+    chars& current = buffers[k % 2];
+    chars& next = buffers[(k + 1) % 2];
+    file.wait();
+    if (error != 0) throw std::system_error(error, std::generic_category());
+
+    // The chunk ends after its last newline, unless it is the last one, and
+    // the rest is carried over to the front of the next buffer
+    size_t size = carry + n;
+    bool last = (offset == length);
+    size_t end = size;
+    if (!last) {
+      while (end > carry && current[end - 1] != '\n') end--;
+      if (end == carry) end = 0;
+      size_t next_carry = size - end;
+      size_t next_n = (std::min)(next_carry < chunk_size ? chunk_size - next_carry : chunk_size, length - offset);
+      if (next.size() < next_carry + next_n) next = chars::uninitialized(next_carry + next_n);
+      std::memcpy(next.data(), current.data() + end, next_carry);
+      start_read(next, next_carry, offset, next_n);
+      carry = next_carry;
+      n = next_n;
+      offset += next_n;
+    }
+    if (end > 0) f(make_slice(current.data(), current.data() + end));
+    if (last) break;
+  }
+}
+
 // Writes a character sequence to a stream
 inline std::ostream& operator<<(std::ostream& os, const chars& s) {
   chars_to_stream(s, os);
@@ -84,10 +298,25 @@ namespace internal {
 #pragma warning(disable: 4146) // unary minus operator applied to unsigned type, result still unsigned
 #endif
 
+// If str is contiguous and Integer_ can hold eight digits, calls f with
+// the value of each run of eight digits starting at str[i], advancing i
+template<typename Integer_, typename It_, typename F>
+void read_eight_digits(slice<It_, It_> str, size_t& i, F&& f) {
+  if constexpr (sizeof(Integer_) >= 4 && is_byte_pointer_v<It_, char>) {
+    while (str.size() - i >= 8) {
+      uint64_t x = load_eight_chars(str.begin() + i);
+      if (!is_eight_digits(x)) break;
+      f(static_cast<Integer_>(parse_eight_digits(x)));
+      i += 8;
+    }
+  }
+}
+
 // Interpret a character sequence as an integral type Integer_.
 //
 // Faster than using std::stoi(std::string(...)) by a factor of
 // approximately 3-4 since it doesn't have to allocate a new string.
+// Contiguous sequences are read eight digits at a time.
 template<typename Integer_, typename It_>
 Integer_ chars_to_int_t(slice<It_, It_> str) {
   static_assert(std::is_integral_v<Integer_>);
@@ -103,6 +332,7 @@ Integer_ chars_to_int_t(slice<It_, It_> str) {
     // INT_MIN, which is technically undefined behavior!
     auto read_digits = [&]() {
       Integer_ r = 0;
+      read_eight_digits<Integer_>(str, i, [&](Integer_ d) { r = r * 100000000 - d; });
       while (i < str.size() && std::isdigit(static_cast<unsigned char>(str[i])))
         r = r * 10 - (str[i++] - '0');
       return r;
@@ -118,6 +348,7 @@ Integer_ chars_to_int_t(slice<It_, It_> str) {
   else {
     auto read_digits = [&]() {
       Integer_ r = 0;
+      read_eight_digits<Integer_>(str, i, [&](Integer_ d) { r = r * 100000000 + d; });
       while (i < str.size() && std::isdigit(static_cast<unsigned char>(str[i])))
         r = r * 10 + (str[i++] - '0');
       return r;
@@ -144,98 +375,111 @@ Integer_ chars_to_int_t(slice<It_, It_> str) {
 // is not too big since we can just read the digits and
 // divide or multiple exactly.  Otherwise we fall back
 // to std::stod / std::stof / std::stold.
+//
+// Floats and doubles are instead converted by parse_float_fast
+// (see internal/number_parsing.h), which also handles most
+// numbers that can not be represented exactly, and falls back
+// only for infinities, NaNs, subnormals, out of range values,
+// and the rare cases whose rounding it can not determine.
 template<typename Float_, size_t max_len, int64_t max_exp, int64_t max_man, typename FallbackF>
 Float_ chars_to_float_t(const chars& s, FallbackF&& fallback) {
 
-  static const Float_ pow_ten[] = {
-    Float_{1e0},  Float_{1e1},  Float_{1e2},  Float_{1e3},  Float_{1e4},
-    Float_{1e5},  Float_{1e6},  Float_{1e7},  Float_{1e8},  Float_{1e9},
-    Float_{1e10}, Float_{1e11}, Float_{1e12}, Float_{1e13}, Float_{1e14},
-    Float_{1e15}, Float_{1e16}, Float_{1e17}, Float_{1e18}, Float_{1e19},
-    Float_{1e20}, Float_{1e21}, Float_{1e22}
-  };
+  if constexpr (std::is_same_v<Float_, float> || std::is_same_v<Float_, double>) {
+    Float_ result;
+    if (parse_float_fast(s.begin(), s.end(), result)) return result;
+    return fallback(s);
+  }
+  else {
+    static const Float_ pow_ten[] = {
+      Float_{1e0},  Float_{1e1},  Float_{1e2},  Float_{1e3},  Float_{1e4},
+      Float_{1e5},  Float_{1e6},  Float_{1e7},  Float_{1e8},  Float_{1e9},
+      Float_{1e10}, Float_{1e11}, Float_{1e12}, Float_{1e13}, Float_{1e14},
+      Float_{1e15}, Float_{1e16}, Float_{1e17}, Float_{1e18}, Float_{1e19},
+      Float_{1e20}, Float_{1e21}, Float_{1e22}
+    };
 
-  // Fast Path
-  auto str = make_slice(s);
-  auto sz = str.size();
-  if (sz <= max_len) {
-    size_t i = 0;
-    uint64_t r = 0;
-    int64_t exponent = 0;
-    bool is_negative = false;
-    
-    while (std::isspace(static_cast<unsigned char>(str[i]))) {
-      i++;
-    }
-    
-    // Detect sign
-    if (str[i] == '-') {
-      is_negative = true;
-      i++;
-    }
-    else if (str[i] == '+') {
-      i++;
-    }
-    
-    // Catches inf and nan
-    if (str[i] == 'i' || str[i] == 'n') {
-      return fallback(s);
-    }
-    
-    // Read digits
-    while (i < sz && std::isdigit(static_cast<unsigned char>(str[i]))) {
-      r = r * 10 + (str[i++] - '0');
-    }
-    
-    // Whole number. No decimal point and no exponent. Easy.
-    if (i == sz) {
-      if (r < (uint64_t{1} << max_man)) {
-        Float_ res = static_cast<Float_>(r);
-        if (is_negative) res = -res;
-        return res;
+    // Fast Path
+    auto str = make_slice(s);
+    auto sz = str.size();
+    if (sz <= max_len) {
+      size_t i = 0;
+      uint64_t r = 0;
+      int64_t exponent = 0;
+      bool is_negative = false;
+
+      while (std::isspace(static_cast<unsigned char>(str[i]))) {
+        i++;
       }
-      else {
+
+      // Detect sign
+      if (str[i] == '-') {
+        is_negative = true;
+        i++;
+      }
+      else if (str[i] == '+') {
+        i++;
+      }
+
+      // Catches inf and nan
+      if (str[i] == 'i' || str[i] == 'n') {
         return fallback(s);
       }
-    }
-    
-    // Found the exponent. No decimal point
-    if (str[i] == 'e' || str[i] == 'E') {
-      exponent = static_cast<int64_t>(internal::chars_to_int_t<uint64_t>(str.cut(i+1, sz)));
-      i = sz;
-    }
-    // Found the decimal point. Continue looking until we find an exponent or the end
-    else {
-      assert(str[i] == '.' || str[i] == ',');
-      int64_t period = static_cast<int64_t>(i++);
-      
+
+      // Read digits
       while (i < sz && std::isdigit(static_cast<unsigned char>(str[i]))) {
         r = r * 10 + (str[i++] - '0');
       }
-      
-      exponent = -(static_cast<int64_t>(i) - period - 1);
-      
-      if (i < sz && (str[i] == 'e' || str[i] == 'E')) {
-        exponent += static_cast<int64_t>(internal::chars_to_int_t<uint64_t>(str.cut(i+1, sz)));
+
+      // Whole number. No decimal point and no exponent. Easy.
+      if (i == sz) {
+        if (r < (uint64_t{1} << max_man)) {
+          Float_ res = static_cast<Float_>(r);
+          if (is_negative) res = -res;
+          return res;
+        }
+        else {
+          return fallback(s);
+        }
+      }
+
+      // Found the exponent. No decimal point
+      if (str[i] == 'e' || str[i] == 'E') {
+        exponent = static_cast<int64_t>(internal::chars_to_int_t<uint64_t>(str.cut(i+1, sz)));
         i = sz;
       }
-    }
+      // Found the decimal point. Continue looking until we find an exponent or the end
+      else {
+        assert(str[i] == '.' || str[i] == ',');
+        int64_t period = static_cast<int64_t>(i++);
+
+        while (i < sz && std::isdigit(static_cast<unsigned char>(str[i]))) {
+          r = r * 10 + (str[i++] - '0');
+        }
+
+        exponent = -(static_cast<int64_t>(i) - period - 1);
+
+        if (i < sz && (str[i] == 'e' || str[i] == 'E')) {
+          exponent += static_cast<int64_t>(internal::chars_to_int_t<uint64_t>(str.cut(i+1, sz)));
+          i = sz;
+        }
+      }
+
+      assert(i == sz);
 
-    assert(i == sz);
-    
-    // We can represent this exactly!
-    if (-max_exp <= exponent && exponent <= max_exp && r < (uint64_t{1} << max_man)) {
-      Float_ result = static_cast<Float_>(r);
-      Float_ tens = exponent > 0 ? pow_ten[exponent] : pow_ten[-exponent];
-      if (exponent < 0) result = result / tens;
-      else if (exponent > 0) result = result * tens;
-      if (is_negative) result = -result;
-      return result;
+      // We can represent this exactly!
+      if (-max_exp <= exponent && exponent <= max_exp && r < (uint64_t{1} << max_man)) {
+        Float_ result = static_cast<Float_>(r);
+        Float_ tens = exponent > 0 ? pow_ten[exponent] : pow_ten[-exponent];
+        if (exponent < 0) result = result / tens;
+        else if (exponent > 0) result = result * tens;
+        if (is_negative) result = -result;
+        return result;
+      }
     }
+
+    // Slow path: Just fall back to std::stof/std::stod/std::stold
+    return fallback(s);
   }
-  
-  // Slow path: Just fall back to std::stof/std::stod/std::stold
-  return fallback(s);
 }
 
 }
@@ -264,6 +508,47 @@ inline long double chars_to_long_double(const chars& s) {
     return std::stold(std::string(std::begin(str), std::end(str))); });
 }
 
+namespace internal {
+
+// Interpret a character sequence as a number of type Number_.  Contiguous
+// floats and doubles are parsed in place rather than copied to chars.
+template<typename Number_, typename It_>
+Number_ chars_to_number_t(slice<It_, It_> str) {
+  if constexpr (std::is_integral_v<Number_>) {
+    return chars_to_int_t<Number_>(str);
+  }
+  else {
+    static_assert(std::is_floating_point_v<Number_>);
+    if constexpr ((std::is_same_v<Number_, float> || std::is_same_v<Number_, double>) &&
+                  is_byte_pointer_v<It_, char>) {
+      Number_ result;
+      if (parse_float_fast(str.begin(), str.end(), result)) return result;
+    }
+    chars s(str.begin(), str.end());
+    if constexpr (std::is_same_v<Number_, float>) return chars_to_float(s);
+    else if constexpr (std::is_same_v<Number_, double>) return chars_to_double(s);
+    else return chars_to_long_double(s);
+  }
+}
+
+}  // namespace internal
+
+// Parses many numbers of type Number_ in parallel.  Given a range of
+// character sequences (e.g., a sequence<chars>), parses each of them.
+// Given a range of characters, parses each of its tokens, i.e., the
+// maximal runs of characters that do not satisfy is_space.
+template<typename Number_, typename R, typename UnaryPred = decltype(is_whitespace)>
+sequence<Number_> parse_numbers(const R& r, UnaryPred&& is_space = is_whitespace) {
+  static_assert(is_random_access_range_v<R>);
+  auto parse = [](auto&& str) { return internal::chars_to_number_t<Number_>(make_slice(str)); };
+  if constexpr (std::is_convertible_v<range_reference_type_t<R>, char>) {
+    return map_tokens(r, parse, std::forward<UnaryPred>(is_space));
+  }
+  else {
+    return map(r, parse);
+  }
+}
+
 
 // ----------------------------------------------------------------------------
 //                                Formatting
@@ -271,69 +556,60 @@ inline long double chars_to_long_double(const chars& s) {
 
 // Still a work in progress. TODO: Improve these?
 
-inline chars to_chars(char c) {
-  return chars(1, c);
-}
+// Writes a number to the buffer starting at p, without allocating, and
+// returns the end of what was written.  At most max_number_chars
+// characters are written.  Floating point numbers are written in the
+// shortest form that reads back as the same value.
 
-inline chars to_chars(bool v) {
-  return to_chars(v ? '1' : '0');
-}
+constexpr size_t max_number_chars = internal::max_number_chars;
 
-inline chars to_chars(long v) {
-  constexpr int max_len = 21;
-  char s[max_len + 1];
-  int l = std::snprintf(s, max_len, "%ld", v);
-  return chars(s, s + (std::min)(max_len - 1, l));
+inline char* to_chars(char* p, char c) {
+  *p = c;
+  return p + 1;
 }
 
-inline chars to_chars(int v) {
-  return to_chars((long) v);
-};
+inline char* to_chars(char* p, bool v) { return to_chars(p, v ? '1' : '0'); }
 
-inline chars to_chars(unsigned long v) {
-  constexpr int max_len = 21;
-  char s[max_len + 1];
-  int l = std::snprintf(s, max_len, "%lu", v);
-  return chars(s, s + (std::min)(max_len - 1, l));
-}
+inline char* to_chars(char* p, int v) { return internal::format_signed(p, v); }
+inline char* to_chars(char* p, long v) { return internal::format_signed(p, v); }
+inline char* to_chars(char* p, long long v) { return internal::format_signed(p, v); }
 
-inline chars to_chars(unsigned int v) {
-  return to_chars((unsigned long) v);
-};
+inline char* to_chars(char* p, unsigned int v) { return internal::format_unsigned(p, v); }
+inline char* to_chars(char* p, unsigned long v) { return internal::format_unsigned(p, v); }
+inline char* to_chars(char* p, unsigned long long v) { return internal::format_unsigned(p, v); }
 
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wformat"
-#endif
+inline char* to_chars(char* p, float v) { return internal::format_float(p, v); }
+inline char* to_chars(char* p, double v) { return internal::format_float(p, v); }
 
-inline chars to_chars(long long v) {
-  constexpr int max_len = 21;
-  char s[max_len + 1];
-  int l = std::snprintf(s, max_len, "%" PRId64, v);
-  return chars(s, s + (std::min)(max_len - 1, l));
-}
+namespace internal {
+
+// True for the types that have a to_chars(char*, T)
+template<typename T>
+inline constexpr bool is_formattable_number_v = std::is_arithmetic_v<T> && !std::is_same_v<T, long double> &&
+    !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> &&
+    !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
 
-inline chars to_chars(unsigned long long v) {
-  constexpr int max_len = 21;
-  char s[max_len + 1];
-  int l = std::snprintf(s, max_len, "%" PRIu64, v);
-  return chars(s, s + (std::min)(max_len - 1, l));
+template<typename T>
+chars number_to_chars(T v) {
+  char s[max_number_chars];
+  return chars(s, to_chars(s, v));
 }
 
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
+}  // namespace internal
 
-inline chars to_chars(double v) {
-  constexpr int max_len = 21;
-  char s[max_len + 1];
-  int l = std::snprintf(s, max_len, "%.11le", v);
-  return chars(s, s + (std::min)(max_len - 1, l));
-}
+inline chars to_chars(char c) { return internal::number_to_chars(c); }
+inline chars to_chars(bool v) { return internal::number_to_chars(v); }
 
-inline chars to_chars(float v) {
-  return to_chars((double) v);
-};
+inline chars to_chars(int v) { return internal::number_to_chars(v); }
+inline chars to_chars(long v) { return internal::number_to_chars(v); }
+inline chars to_chars(long long v) { return internal::number_to_chars(v); }
+
+inline chars to_chars(unsigned int v) { return internal::number_to_chars(v); }
+inline chars to_chars(unsigned long v) { return internal::number_to_chars(v); }
+inline chars to_chars(unsigned long long v) { return internal::number_to_chars(v); }
+
+inline chars to_chars(float v) { return internal::number_to_chars(v); }
+inline chars to_chars(double v) { return internal::number_to_chars(v); }
 
 inline chars to_chars(const std::string& s) {
   return chars::from_function(s.size(), [&](size_t i) -> char { return s[i]; });
@@ -365,10 +641,70 @@ chars to_chars(const std::array<A, N>& P) {
   }));
 }
 
+namespace internal {
+
+// The number of characters that to_chars(char*, v) writes
+template<typename T>
+size_t to_chars_length(T v) {
+  if constexpr (std::is_same_v<T, char> || std::is_same_v<T, bool>) {
+    return 1;
+  }
+  else if constexpr (std::is_integral_v<T>) {
+    return formatted_length(v);
+  }
+  else {
+    char s[max_number_chars];
+    return static_cast<size_t>(to_chars(s, v) - s);
+  }
+}
+
+// Writes the numbers in r separated by the characters [sep, sep + sep_len).
+// The output is sized by a scan over the lengths of blocks of elements, and
+// each block is then written directly into place.
+template<typename Range>
+chars format_numbers(const Range& r, const char* sep, size_t sep_len) {
+  using T = range_value_type_t<Range>;
+  static_assert(is_formattable_number_v<T>);
+  constexpr size_t block_size = 1024;
+  size_t n = parlay::size(r);
+  if (n == 0) return chars();
+  size_t num_blocks = (n + block_size - 1) / block_size;
+  auto it = std::begin(r);
+  auto offsets = tabulate(num_blocks, [&](size_t b) {
+    size_t len = 0;
+    for (size_t i = b * block_size; i < (std::min)(n, (b + 1) * block_size); i++)
+      len += to_chars_length(static_cast<T>(it[i]));
+    return len;
+  }, 1);
+  size_t total = scan_inplace(offsets) + (n - 1) * sep_len;
+  auto result = chars::uninitialized(total);
+  parallel_for(0, num_blocks, [&](size_t b) {
+    // each element but the first is preceded by a separator
+    size_t start = b * block_size;
+    char* p = result.data() + offsets[b] + (start == 0 ? 0 : (start - 1) * sep_len);
+    for (size_t i = start; i < (std::min)(n, start + block_size); i++) {
+      if (i != 0) {
+        std::memcpy(p, sep, sep_len);
+        p += sep_len;
+      }
+      p = to_chars(p, static_cast<T>(it[i]));
+    }
+  }, 1);
+  return result;
+}
+
+}  // namespace internal
+
 template<typename T>
 chars to_chars(const slice<T, T>& A) {
   auto n = A.size();
   if (n == 0) return to_chars(std::string("[]"));
+  if constexpr (internal::is_formattable_number_v<range_value_type_t<slice<T, T>>>) {
+    chars result(1, '[');
+    result.append(internal::format_numbers(A, ", ", 2));
+    result.push_back(']');
+    return result;
+  }
   auto separator = to_chars(std::string(", "));
   return flatten(tabulate(2 * n + 1, [&](size_t i) {
     if (i == 0) return to_chars('[');
@@ -391,6 +727,68 @@ inline chars to_chars(chars&& s) {
   return std::move(s);
 }
 
+// Writes to_chars(x) for each element x of R to a file, following each one
+// by the separator.  Rather than materializing the whole output, rounds of
+// blocks of block_size elements are formatted in parallel into a buffer per
+// block, and each buffer is written at the offset given by a scan of the
+// buffer sizes.  Only one round of buffers is held in memory at a time.
+template<typename Range>
+void format_to_file(const Range& R, const std::string& filename,
+                    char separator='\n', size_t block_size=size_t{1} << 14) {
+  static_assert(is_random_access_range_v<Range>);
+  internal::positioned_writer file(filename);
+  assert(file.is_open());
+  size_t n = parlay::size(R);
+  block_size = (std::max)(block_size, size_t{1});
+  size_t num_blocks = (n + block_size - 1) / block_size;
+  size_t blocks_per_round = 8 * num_workers();
+  size_t offset = 0;
+  for (size_t b = 0; b < num_blocks; b += blocks_per_round) {
+    size_t m = (std::min)(blocks_per_round, num_blocks - b);
+    auto buffers = tabulate(m, [&, it = std::begin(R)](size_t j) {
+      size_t s = (b + j) * block_size;
+      size_t e = (std::min)(n, s + block_size);
+      chars out;
+      if constexpr (internal::is_formattable_number_v<range_value_type_t<Range>>) {
+        out = internal::format_numbers(make_slice(it + s, it + e), &separator, 1);
+        out.push_back(separator);
+      }
+      else {
+        for (size_t i = s; i < e; i++) {
+          out.append(to_chars(it[i]));
+          out.push_back(separator);
+        }
+      }
+      return out;
+    }, 1);
+    auto [offsets, total] = scan(map(buffers, [](const chars& c) { return c.size(); }));
+    parallel_for(0, m, [&](size_t j) {
+      [[maybe_unused]] size_t w = file.write(buffers[j].data(), buffers[j].size(), offset + offsets[j]);
+      assert(w == buffers[j].size());
+    }, 1);
+    offset += total;
+  }
+}
+
+// Writes the elements of R to a character sequence, separated by the
+// separator.  Numbers are written in parallel directly into the output,
+// which is sized with a scan, and without allocating per element.  Other
+// elements are converted with to_chars(x) and flattened.
+template<typename Range>
+chars format_range(const Range& R, char separator = ' ') {
+  static_assert(is_random_access_range_v<Range>);
+  if constexpr (internal::is_formattable_number_v<range_value_type_t<Range>>) {
+    return internal::format_numbers(R, &separator, 1);
+  }
+  else {
+    size_t n = parlay::size(R);
+    if (n == 0) return chars();
+    return flatten(tabulate(2 * n - 1, [&, it = std::begin(R)](size_t i) {
+      return (i & 1) ? chars(1, separator) : to_chars(it[i / 2]);
+    }));
+  }
+}
+
 }  // namespace parlay
 
 #endif  // PARLAY_IO_H_
@@ -3,6 +3,7 @@
 #define PARLAY_PRIMITIVES_H_
 
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cctype>
 
@@ -11,17 +12,22 @@
 #include <functional>
 #include <optional>
 #include <random>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "internal/char_scan.h"
 #include "internal/counting_sort.h"
 #include "internal/integer_sort.h"
 #include "internal/group_by.h"            // IWYU pragma: export
+#include "internal/join.h"                // IWYU pragma: export
 #include "internal/heap_tree.h"           // IWYU pragma: keep
 #include "internal/merge.h"
+#include "internal/merge_k.h"
 #include "internal/merge_sort.h"
 #include "internal/sequence_ops.h"        // IWYU pragma: export
 #include "internal/sample_sort.h"
+#include "internal/string_sort.h"
 
 #include "delayed.h"
 #include "delayed_sequence.h"
@@ -284,10 +290,6 @@ auto filter_into_uninitialized(R_in&& in, R_out&& out, UnaryPred&& f) {
 
 // TODO: Partition
 
-// TODO: nth element
-
-// TODO: partial sort? maybe
-
 /* ----------------------- Merging --------------------- */
 
 template<typename R1, typename R2, typename BinaryPred>
@@ -309,6 +311,31 @@ auto merge(R1&& r1, R2&& r2) {
   return parlay::merge(r1, r2, std::less<>());
 }
 
+// Merge any number of sorted ranges into one sorted sequence, in a single
+// pass rather than the log(k) passes of repeated pairwise merges. The
+// merge is stable: equal elements come out in the order of their ranges.
+template<typename R, typename BinaryPred>
+auto merge_k(R&& runs, BinaryPred&& pred) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  using inner_reference = range_reference_type_t<range_reference_type_t<R>>;
+  static_assert(std::is_invocable_r_v<bool, BinaryPred, inner_reference, inner_reference>);
+  static_assert(std::is_constructible_v<range_value_type_t<range_reference_type_t<R>>, inner_reference>);
+  auto slices = internal::tabulate(parlay::size(runs), [it = std::begin(runs)](size_t i) {
+    return make_slice(it[i]);
+  });
+  return internal::merge_k(slices, pred);
+}
+
+template<typename R>
+auto merge_k(R&& runs) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  using inner_reference = range_reference_type_t<range_reference_type_t<R>>;
+  static_assert(is_less_than_comparable_v<inner_reference, inner_reference>);
+  return parlay::merge_k(runs, std::less<>());
+}
+
 /* -------------------- General Sorting -------------------- */
 
 // Sort the given sequence and return the sorted sequence
@@ -379,6 +406,57 @@ void stable_sort_inplace(R&& in) {
   stable_sort_inplace(std::forward<R>(in), std::less<>{});
 }
 
+/* -------------------- String Sorting -------------------- */
+
+// Sort a range of strings (random-access ranges of characters) into
+// lexicographical order and return the sorted sequence. Characters are
+// compared as unsigned chars, i.e., in the same order as std::string.
+//
+// Uses multikey quicksort, so common prefixes are not repeatedly compared.
+template<typename R>
+[[nodiscard]] auto string_sort(R&& in) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  static_assert(std::is_convertible_v<range_reference_type_t<range_reference_type_t<R>>, unsigned char>);
+  static_assert(std::is_constructible_v<range_value_type_t<R>, range_reference_type_t<R>>);
+  return internal::string_sort(make_slice(in));
+}
+
+template<typename R>
+void string_sort_inplace(R&& in) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  static_assert(std::is_convertible_v<range_reference_type_t<range_reference_type_t<R>>, unsigned char>);
+  internal::string_sort_inplace(make_slice(in));
+}
+
+// Sort a range of strings as string_sort, and also compute their LCP array.
+// Returns a pair consisting of the sorted sequence and the LCP array, where
+// lcp[i] is the length of the longest common prefix of sorted[i-1] and
+// sorted[i], and lcp[0] is zero.
+template<typename R>
+[[nodiscard]] auto string_sort_lcp(R&& in) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  static_assert(std::is_convertible_v<range_reference_type_t<range_reference_type_t<R>>, unsigned char>);
+  static_assert(std::is_constructible_v<range_value_type_t<R>, range_reference_type_t<R>>);
+  auto [perm, lcp] = internal::string_sort_lcp(make_slice(in));
+  auto sorted = internal::tabulate(parlay::size(in), [&, it = std::begin(in)](size_t i)
+      -> range_value_type_t<R> { return it[perm[i]]; });
+  return std::make_pair(std::move(sorted), std::move(lcp));
+}
+
+// Returns a pair consisting of the permutation that sorts the given strings,
+// i.e., the index in the input of the ith smallest string, and the LCP array
+// of the sorted strings. Does not copy or move any of the strings.
+template<typename R>
+[[nodiscard]] auto string_sort_index(R&& in) {
+  static_assert(is_random_access_range_v<R>);
+  static_assert(is_random_access_range_v<range_reference_type_t<R>>);
+  static_assert(std::is_convertible_v<range_reference_type_t<range_reference_type_t<R>>, unsigned char>);
+  return internal::string_sort_lcp(make_slice(in));
+}
+
 /* -------------------- Integer Sorting -------------------- */
 
 template<typename R>
@@ -1009,12 +1087,49 @@ auto flatten(sequence<sequence<T>>&& r) {
 /* -------------------- Tokens and split -------------------- */
 
 // Return true if the given character is considered whitespace.
-// Whitespace characters are ' ', '\f', '\n', '\r'. '\t'. '\v'.
+// Whitespace characters are ' ', '\f', '\n', '\r'. '\t'. '\v', i.e.,
+// std::isspace in the C locale, whatever the current locale is, so that
+// the vectorized and the scalar token scans agree.
 bool inline is_whitespace(unsigned char c) {
-  return std::isspace(c);
+  return c == ' ' || (c >= '\t' && c <= '\r');
 }
 
+// A predicate that is true only for the given character, e.g., for
+// splitting into tokens on a single delimiter.  Like is_whitespace, it
+// is recognized by map_tokens and tokens, which then find the token
+// boundaries of a contiguous range of chars with vector instructions.
+struct is_char {
+  char c;
+  constexpr explicit is_char(char c_) : c(c_) { }
+  constexpr bool operator()(char x) const { return x == c; }
+};
+
 namespace internal {
+
+// If is_space is one of the predicates that have a vectorized matcher,
+// calls g with that matcher and returns true.  Otherwise returns false.
+template<typename UnaryPred, typename G>
+bool with_char_matcher(const UnaryPred& is_space, G&& g) {
+  using pred_type = std::decay_t<UnaryPred>;
+  if constexpr (std::is_same_v<pred_type, is_char>) {
+    g(byte_matcher{is_space.c});
+    return true;
+  }
+  else if constexpr (std::is_same_v<pred_type, bool(*)(unsigned char)>) {
+    if (static_cast<pred_type>(is_space) != &is_whitespace) return false;
+    g(whitespace_matcher{});
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+// True if It is a pointer into an array of single bytes of type T
+template<typename It, typename... T>
+inline constexpr bool is_byte_pointer_v = std::is_pointer_v<It> &&
+    (std::is_same_v<std::remove_cv_t<std::remove_pointer_t<It>>, T> || ...);
+
 template<typename R, typename UnaryOp, typename UnaryPred = decltype(is_whitespace)>
 auto map_tokens_small(R&& r, UnaryOp&& f, UnaryPred&& is_space = is_whitespace) {
   static_assert(is_random_access_range_v<R>);
@@ -1062,7 +1177,7 @@ auto map_tokens_small(R&& r, UnaryOp&& f, UnaryPred&& is_space = is_whitespace)
 //
 // The tokens are the longest contiguous subsequences of non space characters.
 // where spaces are define by the unary predicate is_space. By default, is_space
-// correponds to std::isspace, which is true for ' ', '\f', '\n', '\r'. '\t'. '\v'
+// correponds to std::isspace in the C locale, which is true for ' ', '\f', '\n', '\r'. '\t'. '\v'
 //
 // If f has no return value (i.e. void), this function returns nothing. Otherwise,
 // this function returns a sequence consisting of the returned values of f for
@@ -1083,6 +1198,21 @@ auto map_tokens(R&& r, UnaryOp&& f, UnaryPred&& is_space = is_whitespace) {
     else return sequence<f_return_type>();
   }
 
+  // Fast path for contiguous chars split on whitespace or a single character
+  if constexpr (internal::is_byte_pointer_v<decltype(A.begin()), char>) {
+    sequence<size_t> starts, ends;
+    if (internal::with_char_matcher(is_space, [&](const auto& m) {
+          std::tie(starts, ends) = internal::token_bounds(A.begin(), n, m); })) {
+      if constexpr (std::is_same_v<f_return_type, void>) {
+        parallel_for(0, starts.size(), [&](size_t i) { f(A.cut(starts[i], ends[i])); });
+        return;
+      }
+      else {
+        return tabulate(starts.size(), [&](size_t i) { return f(A.cut(starts[i], ends[i])); });
+      }
+    }
+  }
+
   auto is_start = [&](size_t i) { return ((i == 0) || is_space(A[i - 1])) && (i != n) && !(is_space(A[i])); };
   auto is_end = [&](size_t i) { return ((i == n) || (is_space(A[i]))) && (i != 0) && !is_space(A[i - 1]); };
 
@@ -1116,7 +1246,7 @@ auto map_tokens(R&& r, UnaryOp&& f, UnaryPred&& is_space = is_whitespace) {
 // Returns a sequence of tokens, each represented as a sequence of chars.
 // The tokens are the longest contiguous subsequences of non space characters.
 // where spaces are define by the unary predicate is_space. By default, is_space
-// correponds to std::isspace, which is true for ' ', '\f', '\n', '\r'. '\t'. '\v'
+// correponds to std::isspace in the C locale, which is true for ' ', '\f', '\n', '\r'. '\t'. '\v'
 template <typename Range, typename UnaryPred = decltype(is_whitespace)>
 sequence<parlay::chars> tokens(Range&& R, UnaryPred&& is_space = is_whitespace) {
   static_assert(is_random_access_range_v<Range>);
@@ -1142,7 +1272,12 @@ auto map_split_at(Range&& R, BoolRange&& flags, UnaryOp&& f) {
   size_t n = S.size();
   assert(Flags.size() == n);
 
-  sequence<size_t> Locations = pack_index<size_t>(Flags);
+  // Flags stored one per byte are scanned with vector instructions
+  sequence<size_t> Locations;
+  if constexpr (internal::is_byte_pointer_v<decltype(Flags.begin()), bool, char, signed char, unsigned char>)
+    Locations = internal::match_positions(reinterpret_cast<const char*>(Flags.begin()), n, internal::nonzero_matcher{});
+  else
+    Locations = pack_index<size_t>(Flags);
   size_t m = Locations.size();
 
   return tabulate(m + 1, [&] (size_t i) {
@@ -1280,6 +1415,173 @@ auto kth_smallest(Range&& in, size_t k, Compare&& less = {}) {
   });
 }
 
+/* -------------------- Selection and partial sorting -------------------- */
+
+namespace internal {
+
+// Rearranges A so that A[k] is the element that would be at position k if A
+// were sorted, no element before it is greater, and no element after it is less.
+//
+// Two pivots that tightly bracket the kth smallest are picked from a random
+// sample (as in Floyd and Rivest's SELECT), and the elements are split three
+// ways around them in parallel. The recursion is then almost always on the
+// small middle part, so the expected work is O(n).
+template <typename Iterator, typename Compare>
+void nth_element_(slice<Iterator, Iterator> A, size_t k, const Compare& less, size_t round = 0) {
+  using value_type = typename slice<Iterator, Iterator>::value_type;
+  size_t n = A.size();
+  if (n <= 2048) {
+    std::nth_element(A.begin(), A.begin() + k, A.end(), less);
+    return;
+  }
+
+  // sort a random sample of indices by the elements they refer to
+  size_t num_samples = (std::max)(size_t{1024}, static_cast<size_t>(std::sqrt(n)));
+  random_generator gen(round);
+  std::uniform_int_distribution<size_t> dis(0, n - 1);
+  auto sample = internal::tabulate(num_samples, [&](size_t i) {
+    auto r = gen[i];
+    return dis(r);
+  });
+  parlay::sort_inplace(sample, [&](size_t i, size_t j) { return less(A[i], A[j]); });
+
+  // pick pivots about two standard deviations either side of k
+  size_t r = k * num_samples / n;
+  size_t delta = static_cast<size_t>(std::sqrt(num_samples));
+  size_t lo = sample[(r > delta) ? r - delta : 0];
+  size_t hi = sample[(std::min)(r + delta, num_samples - 1)];
+
+  // split into [x < A[lo]), [A[lo] <= x <= A[hi]], (A[hi] < x]
+  auto Tmp = uninitialized_sequence<value_type>(n);
+  auto split = [&](size_t p1, size_t p2) {
+    auto flags = internal::tabulate(n, [&](size_t i) -> unsigned char {
+      return less(A[i], A[p1]) ? 0 : less(A[p2], A[i]) ? 2 : 1;
+    });
+    auto res = split_three<uninitialized_relocate_tag>(A, make_slice(Tmp), flags);
+    parallel_for(0, n, [&](size_t i) { uninitialized_relocate(&A[i], &Tmp[i]); });
+    return res;
+  };
+
+  bool pivots_equal = !less(A[lo], A[hi]);
+  auto [l, m] = split(lo, hi);
+
+  // If nothing fell outside the pivots (e.g. the input has only a few
+  // distinct values), split around a single pivot instead, which is
+  // guaranteed to make progress since the middle is then all equal.
+  if (m == n && !pivots_equal) {
+    size_t mid = sample[(std::min)(r, num_samples - 1)];
+    pivots_equal = true;
+    std::tie(l, m) = split(mid, mid);
+  }
+
+  if (k < l)
+    nth_element_(A.cut(0, l), k, less, round + 1);
+  else if (k >= l + m)
+    nth_element_(A.cut(l + m, n), k - l - m, less, round + 1);
+  else if (!pivots_equal)
+    nth_element_(A.cut(l, l + m), k - l, less, round + 1);
+}
+
+// Returns the k smallest elements of In in sorted order. A pivot whose rank
+// is just above k is picked from a random sample, so that only O(k) elements
+// are smaller than it in expectation and those are all that need sorting.
+template <typename Range, typename Compare>
+auto top_k_(Range&& In, size_t k, const Compare& less) -> sequence<range_value_type_t<Range>> {
+  using value_type = range_value_type_t<Range>;
+  size_t n = parlay::size(In);
+  k = (std::min)(k, n);
+  if (k == 0) return {};
+  if (n <= 2048 || k > n / 16) {
+    auto sorted = parlay::sort(In, less);
+    return internal::tabulate(k, [&](size_t i) -> value_type { return std::move(sorted[i]); });
+  }
+
+  auto it = std::begin(In);
+  size_t num_samples = (std::max)(size_t{1024}, static_cast<size_t>(std::sqrt(n)));
+  random_generator gen(n);
+  std::uniform_int_distribution<size_t> dis(0, n - 1);
+  auto sample = parlay::sort(internal::tabulate(num_samples, [&](size_t i) -> value_type {
+    auto r = gen[i];
+    return it[dis(r)];
+  }), less);
+
+  // aim about three standard deviations above where the kth smallest should be
+  size_t r = k * num_samples / n;
+  size_t rank = (std::min)(r + 3 * static_cast<size_t>(std::sqrt(r + 1)) + 1, num_samples - 1);
+  const value_type& pivot = sample[rank];
+
+  // the common case: enough elements are smaller than the pivot
+  auto smaller = parlay::filter(In, [&](const auto& x) { return less(x, pivot); });
+  if (smaller.size() >= k) return top_k_(smaller, k, less);
+
+  // otherwise the pivot was too small, or it has many duplicates
+  auto sorted = parlay::sort(smaller, less);
+  auto equal = parlay::filter(In, [&](const auto& x) { return !less(x, pivot) && !less(pivot, x); });
+  size_t num_equal = (std::min)(equal.size(), k - sorted.size());
+  sequence<value_type> larger;
+  if (sorted.size() + num_equal < k) {
+    larger = top_k_(parlay::filter(In, [&](const auto& x) { return less(pivot, x); }),
+                    k - sorted.size() - num_equal, less);
+  }
+  return internal::tabulate(k, [&](size_t i) -> value_type {
+    if (i < sorted.size()) return std::move(sorted[i]);
+    if (i < sorted.size() + num_equal) return std::move(equal[i - sorted.size()]);
+    return std::move(larger[i - sorted.size() - num_equal]);
+  });
+}
+
+}  // namespace internal
+
+// Rearranges the elements of in so that the element at position k is the
+// one that would be there if in were sorted, no element before it is greater,
+// and no element after it is less. Does nothing if k >= size(in).
+template <typename Range, typename Compare = std::less<>>
+void nth_element_inplace(Range&& in, size_t k, Compare&& less = {}) {
+  static_assert(is_random_access_range_v<Range>);
+  static_assert(std::is_invocable_r_v<bool, Compare, range_reference_type_t<Range>, range_reference_type_t<Range>>);
+  static_assert(std::is_swappable_v<range_reference_type_t<Range>>);
+  if (k >= parlay::size(in)) return;
+  internal::nth_element_(make_slice(in), k, less);
+}
+
+// Rearranges the elements of in so that the first k positions hold the k
+// smallest elements in sorted order. The order of the rest is unspecified.
+// Expected work is O(n + k log k).
+template <typename Range, typename Compare = std::less<>>
+void partial_sort_inplace(Range&& in, size_t k, Compare&& less = {}) {
+  static_assert(is_random_access_range_v<Range>);
+  static_assert(std::is_invocable_r_v<bool, Compare, range_reference_type_t<Range>, range_reference_type_t<Range>>);
+  static_assert(std::is_swappable_v<range_reference_type_t<Range>>);
+  auto s = make_slice(in);
+  k = (std::min)(k, s.size());
+  if (k == 0) return;
+  if (k < s.size()) internal::nth_element_(s, k - 1, less);
+  parlay::sort_inplace(s.cut(0, k), less);
+}
+
+// Returns a copy of in whose first k elements are its k smallest in
+// sorted order, and whose remaining elements are in unspecified order.
+template <typename Range, typename Compare = std::less<>>
+[[nodiscard]] auto partial_sort(Range&& in, size_t k, Compare&& less = {}) {
+  static_assert(is_random_access_range_v<Range>);
+  static_assert(std::is_invocable_r_v<bool, Compare, range_reference_type_t<Range>, range_reference_type_t<Range>>);
+  static_assert(std::is_constructible_v<range_value_type_t<Range>, range_reference_type_t<Range>>);
+  auto result = parlay::to_sequence(in);
+  parlay::partial_sort_inplace(result, k, std::forward<Compare>(less));
+  return result;
+}
+
+// Returns a sorted sequence of the k smallest elements of in, or all of
+// them if k >= size(in). Unlike sorting and taking a prefix, the expected
+// work is O(n + k log k), since only O(k) elements ever get sorted.
+template <typename Range, typename Compare = std::less<>>
+[[nodiscard]] auto top_k(Range&& in, size_t k, Compare&& less = {}) {
+  static_assert(is_random_access_range_v<Range>);
+  static_assert(std::is_invocable_r_v<bool, Compare, range_reference_type_t<Range>, range_reference_type_t<Range>>);
+  static_assert(std::is_constructible_v<range_value_type_t<Range>, range_reference_type_t<Range>>);
+  return internal::top_k_(in, k, less);
+}
+
 }  // namespace parlay
 
 #endif  // PARLAY_PRIMITIVES_H_
@@ -0,0 +1,368 @@
+// Mergeable sketches that summarize a range in a small, fixed amount of
+// memory, as an alternative to remove_duplicates and histogram_by_key when
+// approximate answers are good enough:
+//
+//   hyperloglog       estimates the number of distinct keys
+//   count_min_sketch  estimates the number of occurrences of any key
+//   space_saving      finds the most frequent keys (heavy hitters)
+//
+// Each comes with a monoid whose identity is an empty sketch and whose
+// operation merges two sketches, so sketches of parts of a range can be
+// combined with parlay::reduce. The build_* functions do exactly that:
+// they sketch blocks of the input in parallel, and reduce the results.
+
+#ifndef PARLAY_SKETCHES_H_
+#define PARLAY_SKETCHES_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "primitives.h"
+#include "range.h"
+#include "sequence.h"
+#include "utilities.h"
+
+namespace parlay {
+namespace internal {
+
+inline size_t leading_zeros(uint64_t x) {
+#if defined(__GNUC__)
+  return x == 0 ? 64 : static_cast<size_t>(__builtin_clzll(x));
+#else
+  size_t n = 0;
+  for (uint64_t bit = uint64_t{1} << 63; bit != 0 && !(x & bit); bit >>= 1) n++;
+  return n;
+#endif
+}
+
+// The number of blocks to sketch a range of n elements in. Each block
+// allocates its own sketch, so there should not be many more blocks than
+// workers.
+inline size_t sketch_num_blocks(size_t n) {
+  return (std::max)(size_t{1}, (std::min)(n / 4096, 4 * num_workers()));
+}
+
+// Sketches each block of r with make_sketch(block), and merges the sketches
+template <typename R, typename Monoid, typename F>
+auto sketch_by_blocks(R&& r, const Monoid& monoid, F&& make_sketch) {
+  auto it = std::begin(r);
+  size_t n = parlay::size(r);
+  size_t num_blocks = sketch_num_blocks(n);
+  auto sketches = tabulate(num_blocks, [&](size_t i) {
+    return make_sketch(make_slice(it + (n * i) / num_blocks, it + (n * (i + 1)) / num_blocks));
+  }, 1);
+  return reduce(sketches, monoid);
+}
+
+}  // namespace internal
+
+// ------------------------------- HyperLogLog ----------------------------------
+
+// Estimates the number of distinct keys seen with 2^precision one-byte
+// registers, to within a relative standard error of about
+// 1.04 / sqrt(2^precision), e.g. 0.8% with the default precision of 14.
+class hyperloglog {
+ public:
+  explicit hyperloglog(size_t precision_ = 14) : precision(precision_), registers(size_t{1} << precision_, 0) {
+    assert(4 <= precision && precision <= 18);
+  }
+
+  // Adds a key given its 64-bit hash, whose bits should be uniformly random
+  void insert_hash(uint64_t h) {
+    size_t j = h >> (64 - precision);
+    uint64_t w = h << precision;
+    uint8_t rank = static_cast<uint8_t>((std::min)(internal::leading_zeros(w), 64 - precision) + 1);
+    registers[j] = (std::max)(registers[j], rank);
+  }
+
+  template <typename K, typename Hash = parlay::hash<K>>
+  void insert(const K& key, const Hash& hash = {}) { insert_hash(hash64(hash(key))); }
+
+  // Combines the keys of other into this one, which must have the same precision
+  void merge(const hyperloglog& other) {
+    assert(precision == other.precision);
+    for (size_t j = 0; j < registers.size(); j++) registers[j] = (std::max)(registers[j], other.registers[j]);
+  }
+
+  // The estimated number of distinct keys
+  double estimate() const {
+    double m = static_cast<double>(registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+      sum += std::ldexp(1.0, -static_cast<int>(r));
+      zeros += (r == 0);
+    }
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double e = alpha * m * m / sum;
+    // for small cardinalities, linear counting of the empty registers is more accurate
+    if (e <= 2.5 * m && zeros > 0) e = m * std::log(m / static_cast<double>(zeros));
+    return e;
+  }
+
+  size_t get_precision() const { return precision; }
+
+ private:
+  size_t precision;
+  sequence<uint8_t> registers;
+};
+
+struct hyperloglog_monoid {
+  hyperloglog identity;
+  explicit hyperloglog_monoid(size_t precision = 14) : identity(precision) { }
+  hyperloglog operator()(hyperloglog a, const hyperloglog& b) const {
+    a.merge(b);
+    return a;
+  }
+};
+
+// Returns a HyperLogLog sketch of the keys in r
+template <typename R, typename Hash = parlay::hash<range_value_type_t<R>>>
+hyperloglog build_hyperloglog(R&& r, size_t precision = 14, Hash hash = {}) {
+  static_assert(is_random_access_range_v<R>);
+  return internal::sketch_by_blocks(r, hyperloglog_monoid(precision), [&](auto block) {
+    hyperloglog s(precision);
+    for (const auto& k : block) s.insert(k, hash);
+    return s;
+  });
+}
+
+// ----------------------------- Count-min sketch --------------------------------
+
+// Estimates the number of occurrences of each key with a depth x width
+// table of counters. An estimate is never too small, and is too large
+// by at most e * total / width with probability 1 - exp(-depth), where
+// total is the number of occurrences of all keys.
+class count_min_sketch {
+ public:
+  explicit count_min_sketch(size_t width_ = 2048, size_t depth_ = 4) : width(width_), depth(depth_), counts(width_ * depth_, 0) {
+    assert(width > 0 && depth > 0);
+  }
+
+  // Adds count occurrences of a key given its 64-bit hash
+  void insert_hash(uint64_t h, size_t count = 1) {
+    for (size_t i = 0; i < depth; i++) counts[i * width + column(h, i)] += count;
+  }
+
+  template <typename K, typename Hash = parlay::hash<K>>
+  void insert(const K& key, size_t count = 1, const Hash& hash = {}) { insert_hash(hash64(hash(key)), count); }
+
+  // Returns an upper bound on the number of occurrences of a key
+  size_t estimate_hash(uint64_t h) const {
+    size_t e = counts[column(h, 0)];
+    for (size_t i = 1; i < depth; i++) e = (std::min)(e, counts[i * width + column(h, i)]);
+    return e;
+  }
+
+  template <typename K, typename Hash = parlay::hash<K>>
+  size_t estimate(const K& key, const Hash& hash = {}) const { return estimate_hash(hash64(hash(key))); }
+
+  // Combines the counts of other into this one, which must have the same dimensions
+  void merge(const count_min_sketch& other) {
+    assert(width == other.width && depth == other.depth);
+    for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+  }
+
+  size_t get_width() const { return width; }
+  size_t get_depth() const { return depth; }
+
+ private:
+  size_t width, depth;
+  sequence<size_t> counts;
+
+  // The rows use independent-enough hashes derived from two halves of h
+  size_t column(uint64_t h, size_t i) const {
+    uint64_t h1 = h & 0xFFFFFFFF, h2 = (h >> 32) | 1;
+    return static_cast<size_t>((h1 + i * h2) % width);
+  }
+};
+
+struct count_min_sketch_monoid {
+  count_min_sketch identity;
+  explicit count_min_sketch_monoid(size_t width = 2048, size_t depth = 4) : identity(width, depth) { }
+  count_min_sketch operator()(count_min_sketch a, const count_min_sketch& b) const {
+    a.merge(b);
+    return a;
+  }
+};
+
+// Returns a count-min sketch of the keys in r
+template <typename R, typename Hash = parlay::hash<range_value_type_t<R>>>
+count_min_sketch build_count_min_sketch(R&& r, size_t width = 2048, size_t depth = 4, Hash hash = {}) {
+  static_assert(is_random_access_range_v<R>);
+  return internal::sketch_by_blocks(r, count_min_sketch_monoid(width, depth), [&](auto block) {
+    count_min_sketch s(width, depth);
+    for (const auto& k : block) s.insert(k, 1, hash);
+    return s;
+  });
+}
+
+// ------------------------------- SpaceSaving -----------------------------------
+
+// Keeps at most capacity counters, each of which holds a key, an upper
+// bound on its number of occurrences, and the amount by which the bound
+// may be too large. Any key that occurs more than total / capacity times
+// is guaranteed to have a counter. When all counters are in use, keys
+// without one occur at most min_count() times.
+//
+// Merging follows Cafaro et al.: a key missing from one of the summaries
+// is assumed to occur min_count() times in it, and the largest counters
+// of the union are kept.
+template <typename K, typename Hash = parlay::hash<K>, typename Equal = std::equal_to<>>
+class space_saving {
+ public:
+  struct counter {
+    K key;
+    size_t count;
+    size_t error;
+  };
+
+  explicit space_saving(size_t capacity_ = 64, Hash hash_ = {}, Equal equal_ = {})
+      : capacity(capacity_), hash(std::move(hash_)), equal(std::move(equal_)) {
+    assert(capacity > 0);
+  }
+
+  // Adds count occurrences of key. This takes O(capacity) time, so
+  // sketches of many keys should be built with build_space_saving.
+  void insert(const K& key, size_t count = 1) {
+    for (auto& c : counters) {
+      if (equal(c.key, key)) {
+        c.count += count;
+        return;
+      }
+    }
+    if (counters.size() < capacity) {
+      counters.push_back(counter{key, count, 0});
+      return;
+    }
+    auto& m = *std::min_element(counters.begin(), counters.end(),
+                                [](const counter& a, const counter& b) { return a.count < b.count; });
+    m = counter{key, m.count + count, m.count};
+  }
+
+  // Returns an upper bound on the number of occurrences of a key
+  size_t estimate(const K& key) const {
+    for (const auto& c : counters)
+      if (equal(c.key, key)) return c.count;
+    return min_count();
+  }
+
+  // The bound on the occurrences of keys without a counter
+  size_t min_count() const {
+    if (counters.size() < capacity) return 0;
+    size_t m = counters[0].count;
+    for (const auto& c : counters) m = (std::min)(m, c.count);
+    return m;
+  }
+
+  // Returns the counters, most frequent first
+  sequence<counter> top() const {
+    auto result = counters;
+    std::sort(result.begin(), result.end(), [](const counter& a, const counter& b) { return a.count > b.count; });
+    return result;
+  }
+
+  // Combines the counts of other into this one
+  void merge(const space_saving& other) {
+    if (other.counters.empty()) return;
+    size_t m1 = min_count(), m2 = other.min_count();
+    std::unordered_map<K, size_t, Hash, Equal> position(2 * counters.size(), hash, equal);
+    for (size_t i = 0; i < counters.size(); i++) position.emplace(counters[i].key, i);
+    std::vector<bool> in_other(counters.size(), false);
+    for (const auto& c : other.counters) {
+      auto it = position.find(c.key);
+      if (it == position.end()) {
+        counters.push_back(counter{c.key, c.count + m1, c.error + m1});
+      } else {
+        counters[it->second].count += c.count;
+        counters[it->second].error += c.error;
+        in_other[it->second] = true;
+      }
+    }
+    for (size_t i = 0; i < in_other.size(); i++) {
+      if (!in_other[i]) {
+        counters[i].count += m2;
+        counters[i].error += m2;
+      }
+    }
+    keep_largest();
+  }
+
+  // Replaces the counters with exact counts, keeping the largest ones
+  void assign_counts(sequence<counter> exact) {
+    counters = std::move(exact);
+    keep_largest();
+  }
+
+  size_t get_capacity() const { return capacity; }
+
+ private:
+  size_t capacity;
+  Hash hash;
+  Equal equal;
+  sequence<counter> counters;
+
+  void keep_largest() {
+    if (counters.size() <= capacity) return;
+    std::nth_element(counters.begin(), counters.begin() + capacity, counters.end(),
+                     [](const counter& a, const counter& b) { return a.count > b.count; });
+    counters.resize(capacity);
+  }
+};
+
+template <typename K, typename Hash = parlay::hash<K>, typename Equal = std::equal_to<>>
+struct space_saving_monoid {
+  space_saving<K, Hash, Equal> identity;
+  explicit space_saving_monoid(size_t capacity = 64, Hash hash = {}, Equal equal = {})
+      : identity(capacity, std::move(hash), std::move(equal)) { }
+  space_saving<K, Hash, Equal> operator()(space_saving<K, Hash, Equal> a, const space_saving<K, Hash, Equal>& b) const {
+    a.merge(b);
+    return a;
+  }
+};
+
+// Returns a SpaceSaving summary of the keys in r. Each block is split
+// into pieces of a few thousand keys, which are counted exactly and
+// summarized by their largest counts, and the summaries of the pieces
+// are merged. This gives a valid (and more accurate) summary than
+// inserting the keys one at a time, and keeps the memory used by each
+// block proportional to the capacity rather than to its distinct keys.
+template <typename R,
+          typename Hash = parlay::hash<range_value_type_t<R>>,
+          typename Equal = std::equal_to<>>
+auto build_space_saving(R&& r, size_t capacity = 64, Hash hash = {}, Equal equal = {}) {
+  static_assert(is_random_access_range_v<R>);
+  using K = range_value_type_t<R>;
+  using summary = space_saving<K, Hash, Equal>;
+  size_t piece_size = (std::max)(size_t{4096}, 4 * capacity);
+  return internal::sketch_by_blocks(r, space_saving_monoid<K, Hash, Equal>(capacity, hash, equal), [&](auto block) {
+    summary s(capacity, hash, equal);
+    std::unordered_map<K, size_t, Hash, Equal> counts(16, hash, equal);
+    size_t n = block.size();
+    for (size_t start = 0; start < n; start += piece_size) {
+      size_t end = (std::min)(n, start + piece_size);
+      counts.clear();
+      for (size_t i = start; i < end; i++) counts[block[i]]++;
+      sequence<typename summary::counter> exact;
+      exact.reserve(counts.size());
+      for (const auto& [k, c] : counts) exact.push_back({k, c, 0});
+      summary piece(capacity, hash, equal);
+      piece.assign_counts(std::move(exact));
+      s.merge(piece);
+    }
+    return s;
+  });
+}
+
+}  // namespace parlay
+
+#endif  // PARLAY_SKETCHES_H_
@@ -0,0 +1,226 @@
+#ifndef PARLAY_SWISS_HASH_TABLE_H_
+#define PARLAY_SWISS_HASH_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "internal/uninitialized_sequence.h"
+
+#include "delayed_sequence.h"
+#include "parallel.h"
+#include "primitives.h"
+#include "sequence.h"
+#include "utilities.h"
+
+namespace parlay {
+namespace internal {
+
+// A slot's control byte is one of the following, or if the slot is
+// full, the low 7 bits of the hash of its key
+constexpr uint8_t swiss_ctrl_empty = 0x80;
+constexpr uint8_t swiss_ctrl_deleted = 0xFE;
+constexpr uint8_t swiss_ctrl_busy = 0xFF;    // being filled in by an insertion
+
+constexpr size_t swiss_group_size = 16;
+
+// The control bytes of a group of consecutive slots, which can be
+// compared with a given byte all at once
+struct swiss_group {
+#if defined(__SSE2__)
+  __m128i ctrl;
+
+  explicit swiss_group(const uint8_t* p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) { }
+
+  // Returns a bitmask of the slots whose control byte is b
+  uint32_t match(uint8_t b) const {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(b)))));
+  }
+#else
+  uint8_t ctrl[swiss_group_size];
+
+  explicit swiss_group(const uint8_t* p) {
+    for (size_t i = 0; i < swiss_group_size; i++) ctrl[i] = p[i];
+  }
+
+  uint32_t match(uint8_t b) const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < swiss_group_size; i++) mask |= static_cast<uint32_t>(ctrl[i] == b) << i;
+    return mask;
+  }
+#endif
+};
+
+inline size_t lowest_set_bit(uint32_t mask) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctz(mask));
+#else
+  size_t i = 0;
+  while (!(mask & 1)) { mask >>= 1; i++; }
+  return i;
+#endif
+}
+
+}  // namespace internal
+
+// A variant of hashtable that keeps a byte of metadata per slot in a
+// separate array, in the style of SwissTable. A full slot's control byte
+// holds 7 bits of its key's hash, and probes look at the control bytes of
+// 16 slots at once (with SSE2 if available), so the slots themselves are
+// only read when their hash bits match. This makes lookups much cheaper
+// when the keys are expensive to compare or the entries are large, and,
+// since entries are never moved once inserted, allows them to be of any
+// type, such as strings or structs.
+//
+// HASH is the same as for hashtable, except that only eType, kType,
+// empty(), getKey(), hash() and cmp() are used.
+//
+// Insertions can happen in parallel with each other and with searches.
+// Deletions can happen in parallel, but not with insertions or searches.
+// If there are several insertions of equal keys, the first one wins,
+// i.e., values are never replaced. Deleted slots are not reused, so they
+// still count towards the size of the table.
+template <class HASH>
+class swiss_hashtable {
+ private:
+  using eType = typename HASH::eType;
+  using kType = typename HASH::kType;
+  using index = size_t;
+
+  size_t num_groups;
+  eType empty;
+  HASH hashStruct;
+  sequence<uint8_t> ctrl;
+  internal::uninitialized_sequence<eType> slots;
+
+  static size_t groups_for(size_t n) {
+    return size_t{1} << log2_up((std::max)(size_t{1}, (n + internal::swiss_group_size - 1) / internal::swiss_group_size));
+  }
+
+  static uint8_t fingerprint(size_t h) { return static_cast<uint8_t>(h & 0x7F); }
+  index firstGroup(size_t h) { return (h >> 7) & (num_groups - 1); }
+  index nextGroup(index g) { return (g + 1) & (num_groups - 1); }
+  static bool isFull(uint8_t c) { return c < internal::swiss_ctrl_empty; }
+
+  std::atomic<uint8_t>& ctrlAt(index i) { return reinterpret_cast<std::atomic<uint8_t>&>(ctrl[i]); }
+
+  // Returns the index of the slot holding key k, or the number of slots if there is none
+  index findSlot(const kType& k) {
+    size_t h = static_cast<size_t>(hashStruct.hash(k));
+    uint8_t fp = fingerprint(h);
+    index g = firstGroup(h);
+    for (size_t probes = 0; probes < num_groups; probes++, g = nextGroup(g)) {
+      index base = g * internal::swiss_group_size;
+      internal::swiss_group group(ctrl.data() + base);
+      for (uint32_t match = group.match(fp); match != 0; match &= match - 1) {
+        index i = base + internal::lowest_set_bit(match);
+        // synchronizes with the insertion that filled in the slot
+        if (ctrlAt(i).load(std::memory_order_acquire) == fp && hashStruct.cmp(k, hashStruct.getKey(slots[i])) == 0)
+          return i;
+      }
+      if (group.match(internal::swiss_ctrl_empty) != 0) break;
+    }
+    return ctrl.size();
+  }
+
+ public:
+  // Size is the maximum number of values the hash table will hold,
+  // including deleted ones. Overfilling the table is an error, which is
+  // reported by insert throwing std::length_error once no slot is left.
+  swiss_hashtable(size_t size, HASH hashF, double load = 1.5)
+    : num_groups(groups_for(static_cast<size_t>(load * static_cast<double>(size)))),
+      empty(hashF.empty()),
+      hashStruct(hashF),
+      ctrl(num_groups * internal::swiss_group_size, internal::swiss_ctrl_empty),
+      slots(num_groups * internal::swiss_group_size) {
+  }
+
+  swiss_hashtable(const swiss_hashtable&) = delete;
+  swiss_hashtable& operator=(const swiss_hashtable&) = delete;
+
+  ~swiss_hashtable() {
+    parallel_for(0, ctrl.size(), [&](size_t i) {
+      if (isFull(ctrl[i])) slots[i].~eType();
+    });
+  }
+
+  // Inserts v into the first slot of the first group on its probe
+  // sequence that has an empty slot. To make sure that equal keys are
+  // never inserted twice, an insertion waits for any other insertions
+  // into the same group to finish before it checks the group for an equal
+  // key, and always tries to claim the first empty slot.
+  // returns 0 if not inserted (i.e. an equal key is present) and 1 otherwise,
+  // and throws std::length_error, leaving the table unchanged, if v is new
+  // but every slot is taken
+  bool insert(eType v) {
+    const auto& k = hashStruct.getKey(v);
+    size_t h = static_cast<size_t>(hashStruct.hash(k));
+    uint8_t fp = fingerprint(h);
+    index g = firstGroup(h);
+    for (size_t probes = 0; probes < num_groups; probes++, g = nextGroup(g)) {
+      index base = g * internal::swiss_group_size;
+      while (true) {
+        internal::swiss_group group(ctrl.data() + base);
+        if (group.match(internal::swiss_ctrl_busy) != 0) continue;
+        for (uint32_t match = group.match(fp); match != 0; match &= match - 1) {
+          index i = base + internal::lowest_set_bit(match);
+          if (ctrlAt(i).load(std::memory_order_acquire) == fp && hashStruct.cmp(k, hashStruct.getKey(slots[i])) == 0)
+            return false;
+        }
+        uint32_t empties = group.match(internal::swiss_ctrl_empty);
+        if (empties == 0) break;
+        index i = base + internal::lowest_set_bit(empties);
+        uint8_t expected = internal::swiss_ctrl_empty;
+        if (ctrlAt(i).compare_exchange_strong(expected, internal::swiss_ctrl_busy)) {
+          new (&slots[i]) eType(std::move(v));
+          ctrlAt(i).store(fp, std::memory_order_release);
+          return true;
+        }
+      }
+    }
+    throw std::length_error("swiss_hashtable is full");
+  }
+
+  // Returns the value if an equal value is found in the table
+  // otherwise returns the "empty" element.
+  eType find(const kType& v) {
+    index i = findSlot(v);
+    return (i == ctrl.size()) ? empty : slots[i];
+  }
+
+  // Returns true if an equal key is in the table, without copying its value
+  bool contains(const kType& v) { return findSlot(v) != ctrl.size(); }
+
+  bool deleteVal(const kType& v) {
+    index i = findSlot(v);
+    if (i == ctrl.size()) return true;
+    uint8_t c = ctrl[i];
+    if (isFull(c) && ctrlAt(i).compare_exchange_strong(c, internal::swiss_ctrl_deleted))
+      slots[i].~eType();
+    return true;
+  }
+
+  // returns the number of entries
+  size_t count() {
+    auto is_full = [&](size_t i) -> size_t { return isFull(ctrl[i]) ? 1 : 0; };
+    return internal::reduce(delayed_seq<size_t>(ctrl.size(), is_full), plus<size_t>());
+  }
+
+  // returns all the current entries compacted into a sequence
+  sequence<eType> entries() {
+    auto full = pack_index<index>(delayed_seq<bool>(ctrl.size(), [&](size_t i) { return isFull(ctrl[i]); }));
+    return map(full, [&](index i) { return slots[i]; });
+  }
+};
+
+}  // namespace parlay
+
+#endif  // PARLAY_SWISS_HASH_TABLE_H_
@@ -0,0 +1,20 @@
+// Useful reusable stuff for testing file I/O
+
+#ifndef PARLAY_TEST_FILE_UTILS
+#define PARLAY_TEST_FILE_UTILS
+
+#include <fstream>
+#include <string>
+
+#include <parlay/utilities.h>
+
+// Writes n pseudo-random letters to a file, and returns them
+inline std::string write_test_file(const std::string& filename, size_t n) {
+  std::string contents(n, ' ');
+  for (size_t i = 0; i < n; i++) contents[i] = static_cast<char>('a' + parlay::hash64(i) % 26);
+  std::ofstream out(filename, std::ios::binary);
+  out.write(contents.data(), static_cast<std::streamsize>(n));
+  return contents;
+}
+
+#endif  // PARLAY_TEST_FILE_UTILS
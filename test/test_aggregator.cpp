@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <parlay/aggregator.h>
+#include <parlay/primitives.h>
+#include <parlay/random.h>
+#include <parlay/sequence.h>
+
+TEST(TestAggregator, TestReduceByKeyEmpty) {
+  parlay::reduce_by_key_aggregator<int, long> agg;
+  ASSERT_EQ(agg.size(), 0);
+  ASSERT_FALSE(agg.find(5).has_value());
+  agg.add_batch(parlay::sequence<std::pair<int, long>>{});
+  ASSERT_EQ(agg.size(), 0);
+  ASSERT_EQ(agg.entries().size(), 0);
+}
+
+TEST(TestAggregator, TestReduceByKeyBatches) {
+  parlay::reduce_by_key_aggregator<int, long> agg;
+  std::map<int, long> expected;
+  parlay::random_generator gen(0);
+  std::uniform_int_distribution<int> dis(0, 9999);
+  for (size_t b = 0; b < 10; b++) {
+    auto batch = parlay::tabulate(50000, [&](size_t i) {
+      auto r = gen[b * 50000 + i];
+      return std::make_pair(dis(r), static_cast<long>(i % 7));
+    });
+    for (const auto& [k, v] : batch) expected[k] += v;
+    agg.add_batch(batch);
+    ASSERT_EQ(agg.size(), expected.size());
+  }
+  for (const auto& [k, v] : expected) {
+    auto found = agg.find(k);
+    ASSERT_TRUE(found.has_value());
+    ASSERT_EQ(*found, v);
+  }
+  auto entries = agg.entries();
+  ASSERT_EQ(entries.size(), expected.size());
+  for (const auto& [k, v] : entries) ASSERT_EQ(expected[k], v);
+}
+
+TEST(TestAggregator, TestReduceByKeyCustomMonoid) {
+  auto monoid = parlay::maximum<int>();
+  parlay::reduce_by_key_aggregator<int, int, decltype(monoid)> agg(monoid);
+  agg.add_batch(parlay::sequence<std::pair<int, int>>{{1, 5}, {2, 3}, {1, 7}});
+  agg.add_batch(parlay::sequence<std::pair<int, int>>{{1, 6}, {2, 9}, {3, 1}});
+  ASSERT_EQ(agg.size(), 3);
+  ASSERT_EQ(*agg.find(1), 7);
+  ASSERT_EQ(*agg.find(2), 9);
+  ASSERT_EQ(*agg.find(3), 1);
+}
+
+TEST(TestAggregator, TestHistogramStrings) {
+  parlay::histogram_by_key_aggregator<std::string> agg;
+  agg.add_batch(parlay::sequence<std::string>{"a", "b", "a", "c"});
+  agg.add_batch(parlay::sequence<std::string>{"b", "a", "d"});
+  ASSERT_EQ(agg.size(), 4);
+  ASSERT_EQ(*agg.find("a"), 3);
+  ASSERT_EQ(*agg.find("b"), 2);
+  ASSERT_EQ(*agg.find("c"), 1);
+  ASSERT_EQ(*agg.find("d"), 1);
+  ASSERT_FALSE(agg.find("e").has_value());
+}
+
+TEST(TestAggregator, TestHistogramMatchesHistogramByKey) {
+  parlay::histogram_by_key_aggregator<unsigned int> agg(parlay::hash<unsigned int>{}, std::equal_to<>{}, 4);
+  auto all = parlay::tabulate(200000, [](size_t i) { return static_cast<unsigned int>(parlay::hash64(i) % 1000); });
+  for (size_t i = 0; i < all.size(); i += 30000) {
+    agg.add_batch(all.cut(i, (std::min)(all.size(), i + 30000)));
+  }
+  auto expected = parlay::histogram_by_key(all);
+  ASSERT_EQ(agg.size(), expected.size());
+  for (const auto& [k, c] : expected) ASSERT_EQ(*agg.find(k), c);
+}
+
+TEST(TestAggregator, TestShardBits) {
+  auto all = parlay::tabulate(50000, [](size_t i) { return static_cast<int>(parlay::hash64(i) % 500); });
+  auto expected = parlay::histogram_by_key(all);
+  for (size_t bits : {0, 1, 12}) {
+    parlay::histogram_by_key_aggregator<int> agg(parlay::hash<int>{}, std::equal_to<>{}, bits);
+    agg.add_batch(all.cut(0, 20000));
+    auto snap = agg.snapshot();
+    agg.add_batch(all.cut(20000, all.size()));
+    ASSERT_EQ(agg.size(), expected.size());
+    for (const auto& [k, c] : expected) ASSERT_EQ(*agg.find(k), c);
+    ASSERT_EQ(agg.entries().size(), expected.size());
+    ASSERT_EQ(snap.size(), parlay::histogram_by_key(all.cut(0, 20000)).size());
+  }
+  ASSERT_THROW((parlay::histogram_by_key_aggregator<int>(parlay::hash<int>{}, std::equal_to<>{}, 32)), std::invalid_argument);
+  ASSERT_THROW((parlay::histogram_by_key_aggregator<int>(parlay::hash<int>{}, std::equal_to<>{}, 64)), std::invalid_argument);
+}
+
+TEST(TestAggregator, TestSnapshotIsUnaffectedByLaterBatches) {
+  parlay::histogram_by_key_aggregator<int> agg;
+  agg.add_batch(parlay::tabulate(1000, [](size_t i) { return static_cast<int>(i % 100); }));
+  auto snap = agg.snapshot();
+  agg.add_batch(parlay::tabulate(1000, [](size_t i) { return static_cast<int>(i % 200); }));
+  ASSERT_EQ(snap.size(), 100);
+  ASSERT_EQ(agg.size(), 200);
+  for (int k = 0; k < 100; k++) {
+    ASSERT_EQ(*snap.find(k), 10);
+    ASSERT_EQ(*agg.find(k), 15);
+  }
+  for (int k = 100; k < 200; k++) {
+    ASSERT_FALSE(snap.find(k).has_value());
+    ASSERT_EQ(*agg.find(k), 5);
+  }
+  ASSERT_EQ(snap.entries().size(), 100);
+}
+
+TEST(TestAggregator, TestManySnapshots) {
+  parlay::reduce_by_key_aggregator<long, long> agg;
+  parlay::sequence<parlay::aggregate_snapshot<long, long>> snaps;
+  for (long b = 0; b < 20; b++) {
+    agg.add_batch(parlay::tabulate(5000, [&](size_t i) { return std::make_pair(static_cast<long>(i), b); }));
+    snaps.push_back(agg.snapshot());
+  }
+  for (long b = 0; b < 20; b++) {
+    ASSERT_EQ(snaps[b].size(), 5000);
+    ASSERT_EQ(*snaps[b].find(1234), b * (b + 1) / 2);
+  }
+}
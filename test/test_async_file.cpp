@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <parlay/io.h>
+#include <parlay/primitives.h>
+
+#include "file_utils.h"
+
+namespace {
+
+std::string read_test_file(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(TestAsyncFile, TestReadFuture) {
+  std::string filename = "test_async_read.txt";
+  auto contents = write_test_file(filename, 100000);
+  parlay::async_file f(filename);
+  ASSERT_TRUE(f.is_open());
+  ASSERT_EQ(f.size(), 100000);
+  std::string buf(5000, ' ');
+  auto r = f.read(buf.data(), 5000, 1234);
+  ASSERT_EQ(r.get(), 5000);
+  ASSERT_EQ(buf, contents.substr(1234, 5000));
+  // reads past the end are short
+  auto s = f.read(buf.data(), 5000, 99000);
+  ASSERT_EQ(s.get(), 1000);
+  ASSERT_EQ(buf.substr(0, 1000), contents.substr(99000));
+}
+
+TEST(TestAsyncFile, TestManyReadsCallback) {
+  std::string filename = "test_async_many.txt";
+  size_t n = 1000003, block = 1000;
+  auto contents = write_test_file(filename, n);
+  std::string buf(n, ' ');
+  std::atomic<size_t> total{0};
+  {
+    parlay::async_file f(filename);
+    for (size_t i = 0; i < n; i += block) {
+      f.read(buf.data() + i, block, i, [&](std::ptrdiff_t r) {
+        EXPECT_GE(r, 0);
+        total += static_cast<size_t>(r);
+      });
+    }
+    f.wait();
+    ASSERT_EQ(total, n);
+  }
+  ASSERT_EQ(buf, contents);
+}
+
+TEST(TestAsyncFile, TestReadsFromCallbacks) {
+  std::string filename = "test_async_chained.txt";
+  size_t first = 300, fanout = 3, block = 1000, n = first * (1 + fanout) * block;
+  auto contents = write_test_file(filename, n);
+  std::string buf(n, ' ');
+  std::atomic<size_t> total{0};
+  {
+    parlay::async_file f(filename);
+    // Each of the first reads issues more from its callback, which fills
+    // the queue, so some are issued while it is full
+    for (size_t i = 0; i < first; i++) {
+      f.read(buf.data() + i * block, block, i * block, [&, i](std::ptrdiff_t r) {
+        EXPECT_EQ(r, static_cast<std::ptrdiff_t>(block));
+        total += static_cast<size_t>(r);
+        for (size_t k = 1; k <= fanout; k++) {
+          size_t j = (k * first + i) * block;
+          f.read(buf.data() + j, block, j, [&](std::ptrdiff_t r2) { total += static_cast<size_t>(r2); });
+        }
+      });
+    }
+    f.wait();
+    ASSERT_EQ(total, n);
+  }
+  ASSERT_EQ(buf, contents);
+}
+
+TEST(TestAsyncFile, TestWrite) {
+  std::string filename = "test_async_write.txt";
+  std::string contents(300000, ' ');
+  for (size_t i = 0; i < contents.size(); i++) contents[i] = static_cast<char>('A' + i % 26);
+  {
+    parlay::async_file f(filename, parlay::async_file::mode::write);
+    ASSERT_TRUE(f.is_open());
+    std::vector<std::future<size_t>> writes;
+    for (size_t i = 0; i < contents.size(); i += 70000) {
+      size_t len = (std::min)(size_t{70000}, contents.size() - i);
+      writes.push_back(f.write(contents.data() + i, len, i));
+    }
+    for (auto& w : writes) w.get();
+  }
+  ASSERT_EQ(read_test_file(filename), contents);
+}
+
+TEST(TestAsyncFile, TestReadWrite) {
+  std::string filename = "test_async_rw.txt";
+  write_test_file(filename, 1000);
+  parlay::async_file f(filename, parlay::async_file::mode::read_write);
+  f.write("hello", 5, 500).get();
+  std::string buf(5, ' ');
+  ASSERT_EQ(f.read(buf.data(), 5, 500).get(), 5);
+  ASSERT_EQ(buf, "hello");
+  ASSERT_EQ(f.size(), 1000);
+}
+
+TEST(TestAsyncFile, TestCharsFromFileAsync) {
+  std::string filename = "test_async_chars.txt";
+  auto contents = write_test_file(filename, 500001);
+  auto a = parlay::chars_from_file_async(filename, false, 0, 0, 4096);
+  auto b = parlay::chars_from_file_async(filename, true, 777, 400000, 10000);
+  auto s = a.get();
+  ASSERT_EQ(std::string(s.begin(), s.end()), contents);
+  auto t = b.get();
+  ASSERT_EQ(t.size(), 400000 - 777 + 1);
+  ASSERT_EQ(t.back(), 0);
+  ASSERT_EQ(std::string(t.begin(), t.end() - 1), contents.substr(777, 400000 - 777));
+  ASSERT_EQ(parlay::chars_from_file_async(filename, false, 600000).get().size(), 0);
+}
+
+TEST(TestAsyncFile, TestCharsToFileAsync) {
+  std::string filename = "test_async_chars_out.txt";
+  auto s = parlay::tabulate(250000, [](size_t i) -> char { return 'a' + i % 26; });
+  auto done = parlay::chars_to_file_async(s, filename, 8192);
+  done.get();
+  auto t = parlay::chars_from_file(filename);
+  ASSERT_EQ(t, s);
+  parlay::chars_to_file_async(parlay::chars{}, filename).get();
+  ASSERT_EQ(parlay::chars_from_file(filename).size(), 0);
+}
+
+TEST(TestAsyncFile, TestDropUnfinishedFutures) {
+  // Dropping a future without calling get() must wait for the requests
+  // still in flight before their buffers are freed
+  std::string filename = "test_async_dropped.txt";
+  auto contents = write_test_file(filename, 4000037);
+  for (int i = 0; i < 10; i++) {
+    parlay::chars_from_file_async(filename, false, 0, 0, 4096);
+  }
+  std::string out_filename = "test_async_dropped_out.txt";
+  auto s = parlay::chars(contents.begin(), contents.end());
+  for (int i = 0; i < 10; i++) {
+    parlay::chars_to_file_async(s, out_filename, 4096);
+    ASSERT_EQ(parlay::chars_from_file(out_filename), s);
+  }
+  auto t = parlay::chars_from_file_async(filename).get();
+  ASSERT_EQ(std::string(t.begin(), t.end()), contents);
+}
+
+TEST(TestAsyncFile, TestForEachLineChunk) {
+  std::string filename = "test_async_lines.txt";
+  // Lines of varying length, one much longer than a chunk, and no final newline
+  std::string contents;
+  for (size_t i = 0; i < 20000; i++) {
+    contents += std::string(parlay::hash64(i) % 50, 'a' + i % 26);
+    if (i == 777) contents += std::string(10000, 'x');
+    if (i + 1 < 20000) contents += '\n';
+  }
+  std::ofstream(filename, std::ios::binary) << contents;
+
+  for (size_t chunk_size : {size_t{64}, size_t{1000}, size_t{4099}, size_t{1} << 26}) {
+    std::string all;
+    size_t lines = 0, num_chunks = 0;
+    parlay::for_each_line_chunk(filename, [&](auto chunk) {
+      std::string s(chunk.begin(), chunk.end());
+      all += s;
+      num_chunks++;
+      lines += parlay::count(chunk, '\n');
+      if (all.size() < contents.size()) {
+        ASSERT_EQ(s.back(), '\n');
+        // only a chunk holding a long line exceeds the chunk size
+        size_t longest = parlay::reduce(parlay::map(parlay::tokens(s, [](char c) { return c == '\n'; }), parlay::size_of()),
+                                        parlay::maximum<size_t>());
+        ASSERT_TRUE(s.size() <= chunk_size || longest >= chunk_size);
+      }
+    }, chunk_size);
+    ASSERT_EQ(all, contents);
+    ASSERT_EQ(lines, 19999);
+    ASSERT_EQ(num_chunks == 1, chunk_size > contents.size());
+  }
+}
+
+TEST(TestAsyncFile, TestForEachLineChunkEdgeCases) {
+  std::string filename = "test_async_lines_edge.txt";
+  auto chunks = [&](const std::string& contents, size_t chunk_size) {
+    std::ofstream(filename, std::ios::binary) << contents;
+    std::vector<std::string> result;
+    parlay::for_each_line_chunk(filename, [&](auto chunk) { result.emplace_back(chunk.begin(), chunk.end()); }, chunk_size);
+    return result;
+  };
+  ASSERT_TRUE(chunks("", 10).empty());
+  ASSERT_EQ(chunks("\n", 10), std::vector<std::string>({"\n"}));
+  ASSERT_EQ(chunks("ab\ncd\n", 3), std::vector<std::string>({"ab\n", "cd\n"}));
+  ASSERT_EQ(chunks("ab\ncd\nef", 4), std::vector<std::string>({"ab\n", "cd\n", "ef"}));
+  ASSERT_EQ(chunks("abcdefgh\nij", 2), std::vector<std::string>({"abcdefgh\n", "ij"}));
+  ASSERT_EQ(chunks("\n\n\n", 1), std::vector<std::string>({"\n", "\n", "\n"}));
+}
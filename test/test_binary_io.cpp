@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include <parlay/binary_io.h>
+#include <parlay/delayed.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+TEST(TestBinaryIO, TestFlat) {
+  std::string filename = "test_binary_flat.bin";
+  auto s = parlay::tabulate(100000, [](size_t i) { return static_cast<int>(parlay::hash64(i)); });
+  parlay::write_binary(s, filename);
+  ASSERT_EQ(parlay::read_binary<int>(filename), s);
+
+  auto v = parlay::map_binary<int>(filename);
+  ASSERT_EQ(v.size(), s.size());
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % alignof(int), 0);
+  ASSERT_TRUE(std::equal(v.begin(), v.end(), s.begin()));
+  ASSERT_EQ(parlay::reduce(v), parlay::reduce(s));
+}
+
+TEST(TestBinaryIO, TestPairsFromDelayed) {
+  std::string filename = "test_binary_pairs.bin";
+  auto d = parlay::delayed::tabulate(5000, [](size_t i) { return std::make_pair(static_cast<int>(i), i * 0.5); });
+  parlay::write_binary(d, filename);
+  auto s = parlay::read_binary<std::pair<int, double>>(filename);
+  ASSERT_EQ(s.size(), 5000);
+  for (size_t i = 0; i < s.size(); i++) {
+    ASSERT_EQ(s[i].first, static_cast<int>(i));
+    ASSERT_EQ(s[i].second, i * 0.5);
+  }
+}
+
+TEST(TestBinaryIO, TestEmpty) {
+  std::string filename = "test_binary_empty.bin";
+  parlay::write_binary(parlay::sequence<long>(), filename);
+  ASSERT_TRUE(parlay::read_binary<long>(filename).empty());
+  ASSERT_TRUE(parlay::map_binary<long>(filename).empty());
+
+  parlay::write_binary(parlay::sequence<parlay::sequence<long>>(), filename);
+  ASSERT_TRUE(parlay::read_binary<parlay::sequence<long>>(filename).empty());
+}
+
+TEST(TestBinaryIO, TestNested) {
+  std::string filename = "test_binary_nested.bin";
+  // A graph in adjacency list form, with some vertices of degree zero
+  auto G = parlay::tabulate(20000, [](int i) {
+    return parlay::tabulate(parlay::hash64(i) % 7, [&](size_t j) { return static_cast<int>(parlay::hash64(i + j) % 20000); });
+  });
+  parlay::write_binary(G, filename);
+  ASSERT_EQ(parlay::read_binary<parlay::sequence<int>>(filename), G);
+
+  auto v = parlay::map_binary<parlay::sequence<int>>(filename);
+  ASSERT_EQ(v.size(), G.size());
+  ASSERT_EQ(v.num_elements(), parlay::reduce(parlay::map(G, parlay::size_of())));
+  for (size_t i = 0; i < G.size(); i++) {
+    ASSERT_EQ(v[i].size(), G[i].size());
+    ASSERT_TRUE(std::equal(v[i].begin(), v[i].end(), G[i].begin()));
+  }
+  auto degrees = parlay::map(v, [](auto&& ngh) { return ngh.size(); });
+  ASSERT_EQ(degrees, parlay::map(G, parlay::size_of()));
+  ASSERT_EQ(parlay::to_sequence(v.elements()), parlay::flatten(G));
+}
+
+TEST(TestBinaryIO, TestNestedFromDelayed) {
+  std::string filename = "test_binary_nested_delayed.bin";
+  auto d = parlay::delayed::tabulate(100, [](size_t i) { return parlay::iota<short>(i); });
+  parlay::write_binary(d, filename);
+  auto s = parlay::read_binary<parlay::sequence<short>>(filename);
+  ASSERT_EQ(s.size(), 100);
+  for (size_t i = 0; i < s.size(); i++) ASSERT_EQ(s[i], parlay::to_sequence(parlay::iota<short>(i)));
+}
+
+TEST(TestBinaryIO, TestErrors) {
+  std::string filename = "test_binary_errors.bin";
+  parlay::write_binary(parlay::sequence<int>(10, 1), filename);
+  ASSERT_THROW(parlay::read_binary<long>(filename), parlay::binary_format_error);
+  ASSERT_THROW(parlay::read_binary<parlay::sequence<int>>(filename), parlay::binary_format_error);
+
+  parlay::write_binary(parlay::sequence<parlay::sequence<int>>(3, parlay::sequence<int>(2, 1)), filename);
+  ASSERT_THROW(parlay::map_binary<int>(filename), parlay::binary_format_error);
+
+  std::ofstream(filename, std::ios::binary) << "not a binary file at all, but long enough to hold a header......";
+  ASSERT_THROW(parlay::read_binary<int>(filename), parlay::binary_format_error);
+
+  std::ofstream(filename, std::ios::binary) << "short";
+  ASSERT_THROW(parlay::read_binary<int>(filename), parlay::binary_format_error);
+
+  // Offsets that are out of order, so that some rows would lie outside of
+  // the elements
+  parlay::write_binary(parlay::sequence<parlay::sequence<int>>(100, parlay::sequence<int>(2, 1)), filename);
+  auto nested = parlay::chars_from_file(filename);
+  uint64_t bad = 1000;
+  std::memcpy(nested.data() + 64 + 50 * sizeof(uint64_t), &bad, sizeof(bad));
+  parlay::chars_to_file(nested, filename);
+  ASSERT_THROW(parlay::map_binary<parlay::sequence<int>>(filename), parlay::binary_format_error);
+
+  // A truncated file
+  parlay::write_binary(parlay::sequence<int>(1000, 1), filename);
+  auto contents = parlay::chars_from_file(filename);
+  parlay::chars_to_file(parlay::to_sequence(contents.cut(0, contents.size() - 4)), filename);
+  ASSERT_THROW(parlay::read_binary<int>(filename), parlay::binary_format_error);
+}
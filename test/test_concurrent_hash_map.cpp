@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <parlay/concurrent_hash_map.h>
+#include <parlay/parallel.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+TEST(TestConcurrentHashMap, TestInsertFind) {
+  parlay::concurrent_hash_map<int, int> map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_TRUE(map.insert(1, 10));
+  ASSERT_FALSE(map.insert(1, 20));
+  ASSERT_EQ(map.find(1), 10);
+  ASSERT_FALSE(map.find(2).has_value());
+  ASSERT_TRUE(map.contains(1));
+  ASSERT_FALSE(map.contains(2));
+  ASSERT_EQ(map.size(), 1);
+}
+
+TEST(TestConcurrentHashMap, TestParallelInsertGrows) {
+  size_t n = 200000;
+  parlay::concurrent_hash_map<long, long> map;
+  size_t initial_buckets = map.bucket_count();
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_TRUE(map.insert(static_cast<long>(i), static_cast<long>(2 * i)));
+  });
+  ASSERT_GT(map.bucket_count(), initial_buckets);
+  ASSERT_EQ(map.size(), n);
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_EQ(map.find(static_cast<long>(i)), static_cast<long>(2 * i));
+  });
+  ASSERT_FALSE(map.contains(static_cast<long>(n)));
+}
+
+TEST(TestConcurrentHashMap, TestDuplicateInserts) {
+  size_t n = 100000;
+  parlay::concurrent_hash_map<long, long> map;
+  std::atomic<size_t> inserted{0};
+  parlay::parallel_for(0, n, [&](size_t i) {
+    if (map.insert(static_cast<long>(i % 1000), 1)) inserted++;
+  });
+  ASSERT_EQ(inserted.load(), 1000);
+  ASSERT_EQ(map.size(), 1000);
+}
+
+TEST(TestConcurrentHashMap, TestErase) {
+  size_t n = 100000;
+  parlay::concurrent_hash_map<long, long> map(n);
+  parlay::parallel_for(0, n, [&](size_t i) { map.insert(static_cast<long>(i), 0); });
+  parlay::parallel_for(0, n, [&](size_t i) {
+    if (i % 2 == 0) { ASSERT_TRUE(map.erase(static_cast<long>(i))); }
+  });
+  ASSERT_EQ(map.size(), n / 2);
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_EQ(map.contains(static_cast<long>(i)), i % 2 == 1);
+  });
+  ASSERT_FALSE(map.erase(0));
+  // erased keys can be inserted again
+  ASSERT_TRUE(map.insert(0, 5));
+  ASSERT_EQ(map.find(0), 5);
+}
+
+TEST(TestConcurrentHashMap, TestUpsertCounts) {
+  size_t n = 200000;
+  parlay::concurrent_hash_map<long, long> map;
+  parlay::parallel_for(0, n, [&](size_t i) {
+    map.upsert(static_cast<long>(i % 100), 1, [](long c) { return c + 1; });
+  });
+  ASSERT_EQ(map.size(), 100);
+  for (long k = 0; k < 100; k++) ASSERT_EQ(map.find(k), static_cast<long>(n / 100));
+}
+
+TEST(TestConcurrentHashMap, TestUpdateAndAssign) {
+  parlay::concurrent_hash_map<int, int> map;
+  ASSERT_FALSE(map.update(1, [](int x) { return x + 1; }));
+  ASSERT_TRUE(map.insert_or_assign(1, 5));
+  ASSERT_FALSE(map.insert_or_assign(1, 7));
+  ASSERT_EQ(map.find(1), 7);
+  ASSERT_TRUE(map.update(1, [](int x) { return x * 2; }));
+  ASSERT_EQ(map.find(1), 14);
+  ASSERT_EQ(map.size(), 1);
+}
+
+TEST(TestConcurrentHashMap, TestThrowingUpdate) {
+  parlay::concurrent_hash_map<int, int> map;
+  map.insert(1, 5);
+  auto fail = [](int) -> int { throw std::runtime_error("fail"); };
+  ASSERT_THROW(map.update(1, fail), std::runtime_error);
+  ASSERT_THROW(map.upsert(1, 0, fail), std::runtime_error);
+  // The bucket must have been unlocked
+  ASSERT_EQ(map.find(1), 5);
+  ASSERT_TRUE(map.update(1, [](int x) { return x + 1; }));
+  ASSERT_FALSE(map.upsert(1, 0, [](int x) { return x + 1; }));
+  ASSERT_EQ(map.find(1), 7);
+  ASSERT_TRUE(map.erase(1));
+}
+
+TEST(TestConcurrentHashMap, TestStrings) {
+  size_t n = 50000;
+  parlay::concurrent_hash_map<std::string, std::string> map;
+  parlay::parallel_for(0, n, [&](size_t i) {
+    map.insert("key" + std::to_string(i), std::string(i % 50, 'x') + std::to_string(i));
+  });
+  ASSERT_EQ(map.size(), n);
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_EQ(map.find("key" + std::to_string(i)), std::string(i % 50, 'x') + std::to_string(i));
+  });
+}
+
+TEST(TestConcurrentHashMap, TestReserve) {
+  parlay::concurrent_hash_map<long, long> map;
+  for (long i = 0; i < 1000; i++) map.insert(i, i);
+  map.reserve(1000000);
+  ASSERT_GE(map.bucket_count(), 1000000);
+  ASSERT_EQ(map.size(), 1000);
+  for (long i = 0; i < 1000; i++) ASSERT_EQ(map.find(i), i);
+}
+
+TEST(TestConcurrentHashMap, TestEntries) {
+  size_t n = 100000;
+  parlay::concurrent_hash_map<long, long> map;
+  parlay::parallel_for(0, n, [&](size_t i) { map.insert(static_cast<long>(i), static_cast<long>(i) + 1); });
+  auto entries = parlay::sort(map.entries());
+  ASSERT_EQ(entries.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(entries[i].first, static_cast<long>(i));
+    ASSERT_EQ(entries[i].second, static_cast<long>(i) + 1);
+  }
+}
+
+TEST(TestConcurrentHashMap, TestMixedOperations) {
+  // Readers run concurrently with writers that insert, update and erase,
+  // and with the resizes that their inserts cause. Even keys are never
+  // erased or modified, so they must always be found once inserted.
+  size_t n = 100000;
+  parlay::concurrent_hash_map<long, std::string> map;
+  for (long i = 0; i < 1000; i += 2) map.insert(i, std::to_string(i));
+  std::atomic<bool> done{false};
+  std::atomic<size_t> errors{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back([&]() {
+      while (!done.load()) {
+        for (long i = 0; i < 1000; i += 2) {
+          auto v = map.find(i);
+          if (!v.has_value() || *v != std::to_string(i)) errors++;
+        }
+      }
+    });
+  }
+  parlay::parallel_for(0, n, [&](size_t i) {
+    long k = 1000 + 2 * static_cast<long>(i) + 1;
+    map.insert(k, std::to_string(k));
+    map.update(k, [](const std::string& s) { return s + "!"; });
+    if (i % 3 == 0) map.erase(k);
+    map.insert(1000 + 2 * static_cast<long>(i), std::to_string(1000 + 2 * i));
+  });
+  done = true;
+  for (auto& t : readers) t.join();
+  ASSERT_EQ(errors.load(), 0);
+  size_t odd = n - (n + 2) / 3;
+  ASSERT_EQ(map.size(), 500 + n + odd);
+  for (size_t i = 0; i < n; i++) {
+    long k = 1000 + 2 * static_cast<long>(i) + 1;
+    if (i % 3 == 0) ASSERT_FALSE(map.contains(k));
+    else ASSERT_EQ(map.find(k), std::to_string(k) + "!");
+  }
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <string>
+
+#include <parlay/csv.h>
+#include <parlay/io.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+namespace {
+
+parlay::chars to_chars(const std::string& s) {
+  return parlay::chars(s.begin(), s.end());
+}
+
+std::string to_string(const parlay::chars& s) {
+  return std::string(s.begin(), s.end());
+}
+
+}  // namespace
+
+TEST(TestCSV, TestBasic) {
+  auto text = to_chars("id,name,score\n1,alice,3.5\n2,bob,-1e3\n-3,carol,0\n");
+  auto t = parlay::parse_csv<int, std::string, double>(text);
+  ASSERT_EQ(t.size(), 3);
+  ASSERT_EQ(t.header.size(), 3);
+  ASSERT_EQ(to_string(t.header[1]), "name");
+  ASSERT_EQ(t.column<0>(), parlay::sequence<int>({1, 2, -3}));
+  ASSERT_EQ(t.column<1>()[2], "carol");
+  ASSERT_EQ(t.column<2>(), parlay::sequence<double>({3.5, -1000.0, 0.0}));
+}
+
+TEST(TestCSV, TestQuoting) {
+  auto text = to_chars("a,b\r\n\"x,y\",1\r\n\"multi\nline \"\"quoted\"\"\",2\r\n\"\",\"3\"\r\n");
+  auto t = parlay::parse_csv<parlay::chars, long>(text);
+  ASSERT_EQ(t.size(), 3);
+  ASSERT_EQ(to_string(t.column<0>()[0]), "x,y");
+  ASSERT_EQ(to_string(t.column<0>()[1]), "multi\nline \"quoted\"");
+  ASSERT_EQ(to_string(t.column<0>()[2]), "");
+  ASSERT_EQ(t.column<1>(), parlay::sequence<long>({1, 2, 3}));
+}
+
+TEST(TestCSV, TestNonContiguous) {
+  std::string text = "a,b\n\"p,\nq\",7\nr,8\n";
+  auto t = parlay::parse_csv<std::string, int>(text);
+  ASSERT_EQ(t.size(), 2);
+  ASSERT_EQ(t.column<0>()[0], "p,\nq");
+  ASSERT_EQ(t.column<1>(), parlay::sequence<int>({7, 8}));
+}
+
+TEST(TestCSV, TestTSVNoHeader) {
+  auto options = parlay::tsv_options();
+  options.header = false;
+  auto text = to_chars("1\t2\n\n3\t4");
+  auto t = parlay::parse_csv<unsigned, float>(text, options);
+  ASSERT_TRUE(t.header.empty());
+  ASSERT_EQ(t.column<0>(), parlay::sequence<unsigned>({1, 3}));
+  ASSERT_EQ(t.column<1>(), parlay::sequence<float>({2, 4}));
+}
+
+TEST(TestCSV, TestEmpty) {
+  auto t = parlay::parse_csv<int>(parlay::chars());
+  ASSERT_EQ(t.size(), 0);
+  auto u = parlay::parse_csv<int, int>(to_chars("x,y\n"));
+  ASSERT_EQ(u.size(), 0);
+  ASSERT_EQ(u.header.size(), 2);
+}
+
+TEST(TestCSV, TestLarge) {
+  // Many chunks, with quoted newlines that straddle chunk boundaries
+  size_t n = 200000;
+  std::string text = "k,s,v\n";
+  for (size_t i = 0; i < n; i++) {
+    text += std::to_string(i) + ",";
+    if (i % 3 == 0) text += "\"line " + std::to_string(i) + "\nand \"\"more\"\", too\"";
+    else text += "plain" + std::to_string(i);
+    text += "," + std::to_string(i * 0.25) + "\n";
+  }
+  std::string filename = "test_csv_large.csv";
+  std::ofstream(filename, std::ios::binary) << text;
+  auto t = parlay::read_csv<size_t, std::string, double>(filename);
+  ASSERT_EQ(t.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(t.column<0>()[i], i);
+    if (i % 3 == 0) ASSERT_EQ(t.column<1>()[i], "line " + std::to_string(i) + "\nand \"more\", too");
+    else ASSERT_EQ(t.column<1>()[i], "plain" + std::to_string(i));
+    ASSERT_EQ(t.column<2>()[i], i * 0.25);
+  }
+}
+
+TEST(TestCSV, TestErrors) {
+  auto line_of_error = [](const std::string& s) -> size_t {
+    try {
+      parlay::parse_csv<std::string, double>(to_chars(s));
+    } catch (const parlay::csv_error& e) {
+      return e.line();
+    }
+    return 0;
+  };
+  ASSERT_EQ(line_of_error("a,b\n1,2\n3,4\n"), 0);
+  ASSERT_EQ(line_of_error("a,b\n1,2\n3\n"), 3);
+  ASSERT_EQ(line_of_error("a,b\n1,2\n3,4,5\n"), 3);
+  ASSERT_EQ(line_of_error("a,b\n\"1\n\",2\n\nx,y\n"), 5);
+  ASSERT_EQ(line_of_error("a,b\n1,2\n3,abc\n4,5\nq,r\n"), 3);
+  ASSERT_EQ(line_of_error("a,b\n1,2\n\"3\"x,4\n"), 3);
+  ASSERT_EQ(line_of_error("a,b\n1,2\n3,\"4\n"), 3);
+  ASSERT_EQ(line_of_error("a,b\n1,1e999\n"), 2);
+  ASSERT_EQ(line_of_error("a,b\n1,1e-310\n"), 0);
+  ASSERT_EQ(line_of_error("a,b\n1,-1e999\n"), 2);
+
+  // Integers that do not fit in the column type
+  auto int_error = [](const std::string& s) -> size_t {
+    try {
+      parlay::parse_csv<int, unsigned char>(to_chars(s));
+    } catch (const parlay::csv_error& e) {
+      return e.line();
+    }
+    return 0;
+  };
+  ASSERT_EQ(int_error("a,b\n2147483647,255\n-2147483648,0\n-000000000000012,\"+0255\"\n"), 0);
+  ASSERT_EQ(int_error("a,b\n1,2\n99999999999,3\n"), 3);
+  ASSERT_EQ(int_error("a,b\n2147483648,1\n"), 2);
+  ASSERT_EQ(int_error("a,b\n-2147483649,1\n"), 2);
+  ASSERT_EQ(int_error("a,b\n1,300\n"), 2);
+  ASSERT_EQ(int_error("a,b\n1,\"256\"\n"), 2);
+  ASSERT_EQ(parlay::parse_csv<double>(to_chars("a\n1e-310\n")).column<0>()[0], 1e-310);
+
+  try {
+    parlay::parse_csv<int, double>(to_chars("a,b\n1,2\n3,abc\n"));
+    FAIL();
+  } catch (const parlay::csv_error& e) {
+    ASSERT_EQ(std::string(e.what()), "line 3: field 2: invalid number \"abc\"");
+  }
+  try {
+    parlay::parse_csv<int>(to_chars("a\n99999999999\n"));
+    FAIL();
+  } catch (const parlay::csv_error& e) {
+    ASSERT_EQ(std::string(e.what()), "line 2: field 1: number out of range \"99999999999\"");
+  }
+}
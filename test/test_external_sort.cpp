@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include <parlay/external_sort.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+struct Record {
+  uint64_t key;
+  uint32_t payload[3];
+};
+
+bool operator<(const Record& a, const Record& b) { return a.key < b.key; }
+
+template <typename T>
+void write_file(const std::string& filename, const parlay::sequence<T>& s) {
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  out.write(reinterpret_cast<const char*>(s.data()), static_cast<std::streamsize>(s.size() * sizeof(T)));
+}
+
+template <typename T>
+parlay::sequence<T> read_file(const std::string& filename) {
+  std::ifstream in(filename, std::ios::in | std::ios::binary | std::ios::ate);
+  size_t n = static_cast<size_t>(in.tellg()) / sizeof(T);
+  in.seekg(0);
+  auto s = parlay::sequence<T>::uninitialized(n);
+  in.read(reinterpret_cast<char*>(s.data()), static_cast<std::streamsize>(n * sizeof(T)));
+  return s;
+}
+
+parlay::sequence<uint64_t> random_keys(size_t n, uint64_t range) {
+  return parlay::tabulate(n, [&](size_t i) -> uint64_t { return parlay::hash64(i) % range; });
+}
+
+TEST(TestExternalSort, TestSortInMemory) {
+  auto s = random_keys(100000, 1 << 30);
+  write_file("external_sort_in1.bin", s);
+  parlay::external_sort<uint64_t>("external_sort_in1.bin", "external_sort_out1.bin", size_t{1} << 30);
+  std::sort(s.begin(), s.end());
+  ASSERT_EQ(read_file<uint64_t>("external_sort_out1.bin"), s);
+  std::remove("external_sort_in1.bin");
+  std::remove("external_sort_out1.bin");
+}
+
+TEST(TestExternalSort, TestSortManyRuns) {
+  // 100 sorted runs of 10000 records each
+  auto s = random_keys(1000000, 1 << 30);
+  write_file("external_sort_in2.bin", s);
+  parlay::external_sort<uint64_t>("external_sort_in2.bin", "external_sort_out2.bin", 320000);
+  std::sort(s.begin(), s.end());
+  ASSERT_EQ(read_file<uint64_t>("external_sort_out2.bin"), s);
+  std::remove("external_sort_in2.bin");
+  std::remove("external_sort_out2.bin");
+}
+
+TEST(TestExternalSort, TestSortMultiplePasses) {
+  // With a tiny memory budget, the fan in is 2, so there are many passes
+  auto s = random_keys(50000, 1000);
+  write_file("external_sort_in3.bin", s);
+  parlay::external_sort<uint64_t>("external_sort_in3.bin", "external_sort_out3.bin", 16000,
+                                  std::less<>(), "external_sort_tmp3");
+  std::sort(s.begin(), s.end());
+  ASSERT_EQ(read_file<uint64_t>("external_sort_out3.bin"), s);
+  // the temporary runs should all have been removed
+  ASSERT_FALSE(std::ifstream("external_sort_tmp3.run0.0").good());
+  ASSERT_FALSE(std::ifstream("external_sort_tmp3.run1.0").good());
+  std::remove("external_sort_in3.bin");
+  std::remove("external_sort_out3.bin");
+}
+
+TEST(TestExternalSort, TestRunsRemovedOnFailure) {
+  // The comparison throws part way through forming the runs, after some
+  // have been written out. It may be called from several workers.
+  auto s = random_keys(50000, 1000);
+  write_file("external_sort_in7.bin", s);
+  std::atomic<size_t> comparisons{0};
+  auto less = [&](uint64_t a, uint64_t b) {
+    if (++comparisons > 20000) throw std::runtime_error("comparison failed");
+    return a < b;
+  };
+  ASSERT_THROW(parlay::external_sort<uint64_t>("external_sort_in7.bin", "external_sort_out7.bin", 16000,
+                                               less, "external_sort_tmp7"), std::runtime_error);
+  ASSERT_FALSE(std::ifstream("external_sort_tmp7.run0.0").good());
+  ASSERT_FALSE(std::ifstream("external_sort_tmp7.run0.1").good());
+  std::remove("external_sort_in7.bin");
+  std::remove("external_sort_out7.bin");
+}
+
+TEST(TestExternalSort, TestSortRecords) {
+  auto s = parlay::tabulate(200000, [](size_t i) {
+    Record r;
+    r.key = parlay::hash64(i) % 5000;
+    r.payload[0] = static_cast<uint32_t>(i);
+    r.payload[1] = static_cast<uint32_t>(r.key);
+    r.payload[2] = 42;
+    return r;
+  });
+  write_file("external_sort_in4.bin", s);
+  parlay::external_sort<Record>("external_sort_in4.bin", "external_sort_out4.bin", 1000000);
+  auto sorted = read_file<Record>("external_sort_out4.bin");
+  ASSERT_EQ(sorted.size(), s.size());
+  ASSERT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+  // every record should appear exactly once, intact
+  auto ids = parlay::sort(parlay::map(sorted, [](const Record& r) {
+    EXPECT_EQ(r.payload[1], r.key);
+    EXPECT_EQ(r.payload[2], 42u);
+    return r.payload[0];
+  }));
+  ASSERT_EQ(ids, parlay::tabulate(s.size(), [](size_t i) { return static_cast<uint32_t>(i); }));
+  std::remove("external_sort_in4.bin");
+  std::remove("external_sort_out4.bin");
+}
+
+TEST(TestExternalSort, TestSortCustomCompare) {
+  auto s = random_keys(300000, 100);
+  write_file("external_sort_in5.bin", s);
+  parlay::external_sort<uint64_t>("external_sort_in5.bin", "external_sort_out5.bin", 200000,
+                                  std::greater<uint64_t>());
+  std::sort(s.begin(), s.end(), std::greater<uint64_t>());
+  ASSERT_EQ(read_file<uint64_t>("external_sort_out5.bin"), s);
+  std::remove("external_sort_in5.bin");
+  std::remove("external_sort_out5.bin");
+}
+
+TEST(TestExternalSort, TestSortEmpty) {
+  write_file("external_sort_in6.bin", parlay::sequence<uint64_t>());
+  parlay::external_sort<uint64_t>("external_sort_in6.bin", "external_sort_out6.bin", 1000);
+  ASSERT_TRUE(read_file<uint64_t>("external_sort_out6.bin").empty());
+  std::remove("external_sort_in6.bin");
+  std::remove("external_sort_out6.bin");
+}
@@ -1,10 +1,16 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <parlay/io.h>
+#include <parlay/parallel.h>
 
 TEST(TestFileMap, TestConstruction) {
   std::string filename = "test.txt";
@@ -125,3 +131,80 @@ TEST(TestFileMap, TestSwap) {
   ASSERT_TRUE(std::equal(std::begin(contents), std::end(contents), std::begin(f2)));
   ASSERT_TRUE(std::equal(std::begin(contents2), std::end(contents2), std::begin(f)));
 }
+
+TEST(TestFileMap, TestOptions) {
+  std::string filename = "test.txt";
+  std::string contents(100000, ' ');
+  for (size_t i = 0; i < contents.size(); i++) contents[i] = 'a' + i % 26;
+
+  std::ofstream out(filename, std::ios::binary);
+  out << contents;
+  out.close();
+
+  using options = parlay::file_map_options;
+  for (auto access : {options::access_pattern::normal, options::access_pattern::sequential, options::access_pattern::random}) {
+    for (auto prefault : {options::prefault_mode::none, options::prefault_mode::populate, options::prefault_mode::parallel}) {
+      options opts;
+      opts.access = access;
+      opts.prefault = prefault;
+      opts.will_need = true;
+      opts.huge_pages = true;
+      parlay::file_map f(filename, opts);
+      ASSERT_FALSE(f.is_writable());
+      ASSERT_EQ(f.size(), contents.size());
+      ASSERT_TRUE(std::equal(std::begin(contents), std::end(contents), std::begin(f)));
+    }
+  }
+}
+
+TEST(TestFileMap, TestCreate) {
+  std::string filename = "test_create.txt";
+  size_t n = 50000;
+  {
+    auto f = parlay::file_map::create(filename, n);
+    ASSERT_TRUE(f.is_writable());
+    ASSERT_EQ(f.size(), n);
+    char* data = f.data();
+    parlay::parallel_for(0, n, [&](size_t i) { data[i] = 'a' + i % 26; });
+    f.flush();
+  }
+  parlay::file_map g(filename);
+  ASSERT_EQ(g.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(g[i], static_cast<char>('a' + i % 26));
+  }
+}
+
+TEST(TestFileMap, TestModifyInPlace) {
+  std::string filename = "test.txt";
+  std::string contents = "Words, words, words";
+
+  std::ofstream out(filename, std::ios::binary);
+  out << contents;
+  out.close();
+
+  {
+    parlay::file_map_options opts;
+    opts.writable = true;
+    parlay::file_map f(filename, opts);
+    std::transform(f.begin(), f.end(), f.data(), [](char c) { return static_cast<char>(std::toupper(c)); });
+  }
+  parlay::file_map g(filename);
+  ASSERT_EQ(std::string(g.begin(), g.end()), "WORDS, WORDS, WORDS");
+}
+
+// Only a writable map gives mutable access to its contents
+template <typename F, typename = void>
+constexpr bool has_mutable_index_v = false;
+template <typename F>
+constexpr bool has_mutable_index_v<F, std::void_t<decltype(std::declval<F&>()[0] = 'a')>> = true;
+static_assert(!has_mutable_index_v<parlay::file_map>);
+static_assert(std::is_const_v<std::remove_reference_t<decltype(*std::declval<parlay::file_map&>().begin())>>);
+
+TEST(TestFileMap, TestEmptyFile) {
+  std::string filename = "test_empty.txt";
+  std::ofstream(filename).close();
+  parlay::file_map f(filename);
+  ASSERT_EQ(f.size(), 0);
+  ASSERT_TRUE(f.begin() == f.end());
+}
@@ -1,7 +1,12 @@
 #include "gtest/gtest.h"
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
 #include <limits>
 #include <numeric>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -274,3 +279,59 @@ TEST(TestFormatting, TestRecursive) {
     last_pos = pos;
   }
 }
+
+TEST(TestFormatting, TestToCharsBuffer) {
+  char buf[parlay::max_number_chars];
+  auto str = [&](char* end) { return std::string(buf, end); };
+  ASSERT_EQ(str(parlay::to_chars(buf, 0)), "0");
+  ASSERT_EQ(str(parlay::to_chars(buf, -7)), "-7");
+  ASSERT_EQ(str(parlay::to_chars(buf, 'x')), "x");
+  ASSERT_EQ(str(parlay::to_chars(buf, true)), "1");
+  ASSERT_EQ(str(parlay::to_chars(buf, (std::numeric_limits<long long>::min)())), "-9223372036854775808");
+  ASSERT_EQ(str(parlay::to_chars(buf, (std::numeric_limits<unsigned long long>::max)())), "18446744073709551615");
+  for (long x = 1; x < (std::numeric_limits<long>::max)() / 3; x = 3 * x + 1) {
+    ASSERT_EQ(str(parlay::to_chars(buf, x)), std::to_string(x));
+    ASSERT_EQ(str(parlay::to_chars(buf, -x)), std::to_string(-x));
+    ASSERT_EQ(str(parlay::to_chars(buf, x - 1)), std::to_string(x - 1));
+  }
+
+  // doubles are written in the shortest form that reads back exactly
+  ASSERT_EQ(str(parlay::to_chars(buf, 0.1)), "0.1");
+  ASSERT_EQ(str(parlay::to_chars(buf, 0.1f)), "0.1");
+  ASSERT_EQ(str(parlay::to_chars(buf, -2.5)), "-2.5");
+  for (size_t i = 0; i < 100000; i++) {
+    uint64_t h = parlay::hash64(i);
+    double x;
+    std::memcpy(&x, &h, sizeof(double));
+    if (!std::isfinite(x)) continue;
+    std::string s = str(parlay::to_chars(buf, x));
+    ASSERT_EQ(std::strtod(s.c_str(), nullptr), x) << s;
+    ASSERT_LE(s.size(), parlay::max_number_chars);
+    float f = static_cast<float>(static_cast<double>(h >> 11) / (1 << (h % 50)));
+    std::string t = str(parlay::to_chars(buf, f));
+    ASSERT_EQ(std::strtof(t.c_str(), nullptr), f) << t;
+  }
+}
+
+TEST(TestFormatting, TestFormatRange) {
+  auto a = parlay::tabulate(100000, [](long i) { return (i % 3 == 0) ? -i * 1001 : i; });
+  auto out = parlay::format_range(a, '\n');
+  std::string expected;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (i > 0) expected += '\n';
+    expected += std::to_string(a[i]);
+  }
+  ASSERT_TRUE(std::string(out.begin(), out.end()) == expected);
+
+  auto d = parlay::tabulate(10000, [](size_t i) { return static_cast<double>(i) / 4; });
+  auto back = parlay::parse_numbers<double>(parlay::format_range(d, ','), parlay::is_char(','));
+  ASSERT_EQ(back, d);
+
+  ASSERT_TRUE(parlay::format_range(parlay::sequence<int>()).empty());
+  auto single = parlay::format_range(parlay::sequence<int>(1, 42));
+  ASSERT_EQ(std::string(single.begin(), single.end()), "42");
+  auto strings = parlay::format_range(parlay::sequence<std::string>({"ab", "c"}), ';');
+  ASSERT_EQ(std::string(strings.begin(), strings.end()), "ab;c");
+  auto bracketed = parlay::to_chars(parlay::sequence<int>({1, -2, 3}));
+  ASSERT_EQ(std::string(bracketed.begin(), bracketed.end()), "[1, -2, 3]");
+}
@@ -608,6 +608,113 @@ TEST_P(TestGroupByP, TestHistogramByKeyNonRelocatable) {
   ASSERT_EQ(keyset, ret_keys);
 }
 
+// -----------------------------------------------------------------------
+//                              bucket_plan
+// -----------------------------------------------------------------------
+
+namespace {
+
+// batch b of a stream in which key `heavy` makes up `percent` of the keys
+parlay::sequence<unsigned long> skewed_batch(size_t n, size_t b, unsigned long heavy, size_t percent) {
+  return parlay::tabulate(n, [&](size_t i) -> unsigned long {
+    auto h = parlay::hash64(b * n + i);
+    return (h % 100 < percent) ? heavy : 1000 + (h >> 8) % 50000;
+  });
+}
+
+template <typename Result>
+std::map<unsigned long, size_t> as_map(const Result& result) {
+  std::map<unsigned long, size_t> m;
+  for (const auto& [k, c] : result) m[k] = c;
+  return m;
+}
+
+}  // namespace
+
+TEST(TestGroupBy, TestBucketPlanReusedAcrossBatches) {
+  parlay::bucket_plan<unsigned long> plan;
+  ASSERT_TRUE(plan.stale());
+  for (size_t b = 0; b < 5; b++) {
+    auto batch = skewed_batch(100000, b, 7, 60);
+    auto result = parlay::histogram_by_key(batch, plan);
+    ASSERT_EQ(as_map(result), as_map(parlay::histogram_by_key(batch)));
+    ASSERT_FALSE(plan.stale());
+  }
+  ASSERT_EQ(plan.num_samplings(), 1);
+  ASSERT_GE(plan.num_heavy_keys(), 1);
+}
+
+TEST(TestGroupBy, TestBucketPlanRefreshesWhenDistributionChanges) {
+  parlay::bucket_plan<unsigned long> plan;
+  auto first = skewed_batch(100000, 0, 7, 60);
+  parlay::histogram_by_key(first, plan);
+  ASSERT_EQ(plan.num_samplings(), 1);
+
+  // a different key becomes heavy, so the plan is stale after this batch,
+  // and the heavy key of the plan does not appear in it at all
+  auto second = skewed_batch(100000, 1, 42, 60);
+  auto result = parlay::histogram_by_key(second, plan);
+  auto expected = parlay::histogram_by_key(second);
+  ASSERT_EQ(result.size(), expected.size());
+  ASSERT_TRUE(parlay::none_of(result, [](const auto& kc) { return kc.second == 0; }));
+  ASSERT_EQ(as_map(result), as_map(expected));
+  ASSERT_TRUE(plan.stale());
+
+  parlay::bucket_plan<unsigned long> pair_plan;
+  auto ones = [](unsigned long k) { return std::make_pair(k, size_t{1}); };
+  parlay::reduce_by_key(parlay::map(first, ones), pair_plan);
+  auto sums = parlay::reduce_by_key(parlay::map(second, ones), pair_plan);
+  ASSERT_EQ(sums.size(), expected.size());
+  ASSERT_EQ(as_map(sums), as_map(expected));
+
+  auto third = skewed_batch(100000, 2, 42, 60);
+  result = parlay::histogram_by_key(third, plan);
+  ASSERT_EQ(as_map(result), as_map(parlay::histogram_by_key(third)));
+  ASSERT_EQ(plan.num_samplings(), 2);
+  ASSERT_FALSE(plan.stale());
+
+  plan.invalidate();
+  parlay::histogram_by_key(third, plan);
+  ASSERT_EQ(plan.num_samplings(), 3);
+}
+
+TEST(TestGroupBy, TestBucketPlanSmallInputsDoNotSample) {
+  parlay::bucket_plan<unsigned long> plan;
+  auto result = parlay::histogram_by_key(skewed_batch(1000, 0, 7, 60), plan);
+  ASSERT_EQ(plan.num_samplings(), 0);
+  ASSERT_EQ(as_map(result)[7], parlay::count(skewed_batch(1000, 0, 7, 60), 7ul));
+}
+
+TEST(TestGroupBy, TestBucketPlanReduceAndGroupByKey) {
+  parlay::bucket_plan<unsigned long> plan;
+  for (size_t b = 0; b < 3; b++) {
+    auto keys = skewed_batch(50000, b, 3, 50);
+    auto pairs = parlay::map(keys, [](unsigned long k) { return std::make_pair(k, 2 * k + 1); });
+    auto sums = parlay::reduce_by_key(pairs, plan);
+    auto expected = parlay::reduce_by_key(pairs);
+    ASSERT_EQ(as_map(sums), as_map(expected));
+
+    auto groups = parlay::group_by_key(std::move(pairs), plan);
+    ASSERT_EQ(groups.size(), expected.size());
+    for (const auto& [k, vals] : groups) {
+      ASSERT_TRUE(parlay::all_of(vals, [k = k](unsigned long v) { return v == 2 * k + 1; }));
+    }
+  }
+  ASSERT_EQ(plan.num_samplings(), 1);
+}
+
+TEST(TestGroupBy, TestBucketPlanStrings) {
+  parlay::bucket_plan<std::string> plan;
+  auto words = parlay::tabulate(40000, [](size_t i) {
+    return (i % 2 == 0) ? std::string("the") : "w" + std::to_string(parlay::hash64(i) % 3000);
+  });
+  auto counts = parlay::histogram_by_key(words, plan);
+  std::map<std::string, size_t> m;
+  for (const auto& [w, c] : counts) m[w] = c;
+  ASSERT_EQ(m["the"], 20000);
+  ASSERT_EQ(m.size(), parlay::remove_duplicates(words).size());
+}
+
 // -----------------------------------------------------------------------
 //                             remove_duplicates
 // -----------------------------------------------------------------------
@@ -986,6 +1093,94 @@ TEST_P(TestGroupByP, TestGroupByIndexNonRelocatable) {
   ASSERT_EQ(values, std::multiset<SelfReferentialThing>(std::begin(s), std::end(s)));
 }
 
+// -----------------------------------------------------------------------
+//                      group_by_key_flat / group_by_index_flat
+// -----------------------------------------------------------------------
+
+namespace {
+
+template <typename K, typename V>
+std::map<K, std::vector<V>> flat_as_map(const parlay::flat_key_groups<K, V>& groups) {
+  std::map<K, std::vector<V>> m;
+  EXPECT_EQ(groups.keys.size(), groups.size());
+  EXPECT_EQ(groups.offsets[groups.size()], groups.values.size());
+  for (size_t i = 0; i < groups.size(); i++) {
+    EXPECT_LT(groups.offsets[i], groups.offsets[i + 1]);
+    EXPECT_TRUE(m.emplace(groups.keys[i], std::vector<V>(groups[i].begin(), groups[i].end())).second);
+  }
+  return m;
+}
+
+template <typename R>
+auto grouped_in_order(const R& kvs) {
+  using K = std::tuple_element_t<0, parlay::range_value_type_t<R>>;
+  using V = std::tuple_element_t<1, parlay::range_value_type_t<R>>;
+  std::map<K, std::vector<V>> m;
+  for (const auto& [k, v] : kvs) m[k].push_back(v);
+  return m;
+}
+
+}  // namespace
+
+TEST(TestGroupBy, TestGroupByKeyFlat) {
+  std::vector<std::pair<int, int>> a = {{3, 0}, {1, 1}, {3, 2}, {2, 3}, {2, 4}, {3, 5}, {1, 6}};
+  auto groups = parlay::group_by_key_flat(a);
+  ASSERT_EQ(groups.size(), 3);
+  ASSERT_EQ(flat_as_map(groups), grouped_in_order(a));
+}
+
+TEST(TestGroupBy, TestGroupByKeyFlatEmpty) {
+  parlay::sequence<std::pair<int, int>> a;
+  auto groups = parlay::group_by_key_flat(a);
+  ASSERT_EQ(groups.size(), 0);
+  ASSERT_EQ(groups.values.size(), 0);
+}
+
+TEST_P(TestGroupByP, TestGroupByKeyFlatLarge) {
+  auto num_buckets = GetParam();
+  auto a = parlay::tabulate(100000, [&](size_t i) {
+    return std::make_pair(parlay::hash64(i) % num_buckets, i);
+  });
+  ASSERT_EQ(flat_as_map(parlay::group_by_key_flat(a)), grouped_in_order(a));
+}
+
+TEST_P(TestGroupByP, TestGroupByKeyFlatNonContiguous) {
+  auto num_buckets = GetParam();
+  std::deque<std::pair<unsigned long long, int>> a;
+  for (int i = 0; i < 50000; i++) a.emplace_back((50021 * i + 61) % num_buckets, i);
+  ASSERT_EQ(flat_as_map(parlay::group_by_key_flat(a)), grouped_in_order(a));
+}
+
+TEST(TestGroupBy, TestGroupByKeyFlatHeavyKeys) {
+  // keys 0 and 1 each make up a quarter of the input, so get their own buckets
+  auto a = parlay::tabulate(200000, [](size_t i) {
+    auto h = parlay::hash64(i);
+    return std::make_pair((h % 4 < 2) ? h % 2 : 2 + (h >> 8) % 20000, i);
+  });
+  ASSERT_EQ(flat_as_map(parlay::group_by_key_flat(a)), grouped_in_order(a));
+}
+
+TEST(TestGroupBy, TestGroupByKeyFlatNonTrivial) {
+  auto a = parlay::tabulate(30000, [](size_t i) {
+    return std::make_pair(std::to_string(parlay::hash64(i) % 500), std::to_string(i));
+  });
+  ASSERT_EQ(flat_as_map(parlay::group_by_key_flat(a)), grouped_in_order(a));
+}
+
+TEST_P(TestGroupByP, TestGroupByIndexFlat) {
+  auto num_buckets = GetParam();
+  auto a = parlay::tabulate(100000, [&](size_t i) {
+    return std::make_pair(static_cast<unsigned int>(parlay::hash64(i) % num_buckets), static_cast<int>(i));
+  });
+  auto groups = parlay::group_by_index_flat(a, num_buckets);
+  auto expected = parlay::group_by_index(a, num_buckets);
+  ASSERT_EQ(groups.size(), num_buckets);
+  ASSERT_EQ(groups.offsets.size(), num_buckets + 1);
+  for (size_t i = 0; i < num_buckets; i++) {
+    ASSERT_EQ(parlay::to_sequence(groups[i]), expected[i]);
+  }
+}
+
 // For the value-parametrized tests, we want to vary the number of groups from small to large,
 // so that the buckets vary from dense to sparse
 INSTANTIATE_TEST_SUITE_P(NumBuckets, TestGroupByP, testing::Values(2, 10, 100, 1000));
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include <parlay/hardware.h>
+#include <parlay/primitives.h>
+#include <parlay/random.h>
+#include <parlay/sequence.h>
+
+TEST(TestHardware, TestParseCacheSize) {
+  ASSERT_EQ(parlay::internal::parse_cache_size("48K"), 48 * 1024);
+  ASSERT_EQ(parlay::internal::parse_cache_size("32M"), 32 * 1024 * 1024);
+  ASSERT_EQ(parlay::internal::parse_cache_size("512"), 512);
+}
+
+TEST(TestHardware, TestCountCpuList) {
+  ASSERT_EQ(parlay::internal::count_cpu_list("0"), 1);
+  ASSERT_EQ(parlay::internal::count_cpu_list("0-7"), 8);
+  ASSERT_EQ(parlay::internal::count_cpu_list("0-7,16-23"), 16);
+  ASSERT_EQ(parlay::internal::count_cpu_list("0,2,4"), 3);
+}
+
+TEST(TestHardware, TestDetect) {
+  auto p = parlay::get_hardware_profile();
+  ASSERT_GT(p.l1d_size, 0);
+  ASSERT_GT(p.l2_size, 0);
+  ASSERT_GT(p.l3_size, 0);
+  ASSERT_GE(p.cpus_per_l2, 1);
+  ASSERT_GE(p.cpus_per_l3, 1);
+  ASSERT_GT(p.cache_per_thread(), 0);
+  ASSERT_LE(p.cache_per_thread(), 4 << 20);
+}
+
+TEST(TestHardware, TestOverride) {
+  auto saved = parlay::get_hardware_profile();
+  parlay::hardware_profile p;
+  p.l1d_size = 32 << 10;
+  p.l2_size = 256 << 10;
+  p.l3_size = 8 << 20;
+  p.cpus_per_l3 = 8;
+  parlay::set_hardware_profile(p);
+  ASSERT_EQ(parlay::get_hardware_profile().l2_size, 256 << 10);
+  ASSERT_EQ(parlay::get_hardware_profile().cache_per_thread(), (256 << 10) + (1 << 20));
+  parlay::set_hardware_profile(saved);
+  ASSERT_EQ(parlay::get_hardware_profile().l2_size, saved.l2_size);
+}
+
+TEST(TestHardware, TestAlgorithmsWithTinyCaches) {
+  // The algorithms tuned by the profile must be correct whatever it says
+  auto saved = parlay::get_hardware_profile();
+  parlay::hardware_profile p;
+  p.l1d_size = 1 << 10;
+  p.l2_size = 4 << 10;
+  p.l3_size = 16 << 10;
+  p.cpus_per_l3 = 4;
+  parlay::set_hardware_profile(p);
+
+  size_t n = 200000;
+  parlay::random r(0);
+  auto s = parlay::tabulate(n, [&](size_t i) -> unsigned long { return r.ith_rand(i) % 1000; });
+  auto sorted = parlay::sort(s);
+  ASSERT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+  auto isorted = parlay::integer_sort(s);
+  ASSERT_EQ(sorted, isorted);
+  auto counts = parlay::histogram_by_index(s, 1000ul);
+  ASSERT_EQ(parlay::reduce(counts), n);
+  auto by_key = parlay::histogram_by_key(s);
+  ASSERT_EQ(by_key.size(), 1000);
+
+  parlay::set_hardware_profile(saved);
+}
@@ -60,4 +60,49 @@ TEST(TestHashtable, TestDelete) {
       ASSERT_EQ(val, -1);
     }
   });
-}
\ No newline at end of file
+}
+
+TEST(TestHashtable, TestInsertBatch) {
+  parlay::hashtable<parlay::hash_numeric<int>>
+    table(400000, parlay::hash_numeric<int>{});
+
+  auto keys = parlay::tabulate(100000, [](int i) { return i % 50000; });
+  ASSERT_EQ(table.insert_batch(keys), 50000);
+  ASSERT_EQ(table.count(), 50000);
+
+  parlay::parallel_for(0, 50000, [&](int i) {
+    ASSERT_EQ(table.find(i), i);
+  });
+}
+
+TEST(TestHashtable, TestFindBatch) {
+  parlay::hashtable<parlay::hash_numeric<int>>
+    table(400000, parlay::hash_numeric<int>{});
+
+  parlay::parallel_for(0, 100000, [&](int i) {
+    if (i % 3 == 0) table.insert(i);
+  });
+
+  auto keys = parlay::iota<int>(100000);
+  auto found = table.find_batch(keys);
+  ASSERT_EQ(found.size(), 100000);
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(found[i], (i % 3 == 0) ? i : -1);
+  }
+
+  ASSERT_TRUE(table.find_batch(parlay::sequence<int>()).empty());
+}
+
+TEST(TestHashtable, TestEraseBatch) {
+  parlay::hashtable<parlay::hash_numeric<int>>
+    table(400000, parlay::hash_numeric<int>{});
+
+  table.insert_batch(parlay::iota<int>(100000));
+  table.erase_batch(parlay::filter(parlay::iota<int>(100000), [](int i) { return i % 2 == 0; }));
+  ASSERT_EQ(table.count(), 50000);
+
+  auto found = table.find_batch(parlay::iota<int>(100000));
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(found[i], (i % 2 == 1) ? i : -1);
+  }
+}
@@ -1,11 +1,20 @@
 #include "gtest/gtest.h"
 
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <parlay/io.h>
 #include <parlay/primitives.h>
 
+#include "file_utils.h"
+
 
 TEST(TestIO, TestCharsFromFile) {
   std::string filename = "test.txt";
@@ -64,3 +73,96 @@ TEST(TestIO, TestCharsToStreamOperator) {
   getline(ss, result);
   ASSERT_EQ(result, contents);
 }
+
+TEST(TestIO, TestCharsFromFileParallel) {
+  std::string filename = "test_parallel.txt";
+  auto contents = write_test_file(filename, 1000003);
+  parlay::file_read_options options;
+  options.block_size = 10000;
+  auto s = parlay::chars_from_file_parallel(filename, false, 0, 0, options);
+  ASSERT_EQ(std::string(s.begin(), s.end()), contents);
+}
+
+TEST(TestIO, TestCharsFromFileParallelRange) {
+  std::string filename = "test_parallel.txt";
+  auto contents = write_test_file(filename, 100000);
+  parlay::file_read_options options;
+  options.block_size = 4096;
+  auto s = parlay::chars_from_file_parallel(filename, true, 1234, 56789, options);
+  ASSERT_EQ(s.size(), 56789 - 1234 + 1);
+  ASSERT_EQ(s.back(), 0);
+  ASSERT_EQ(std::string(s.begin(), s.end() - 1), contents.substr(1234, 56789 - 1234));
+  ASSERT_EQ(parlay::chars_from_file_parallel(filename, false, 99990, 200000).size(), 10);
+  ASSERT_EQ(parlay::chars_from_file_parallel(filename, false, 200000).size(), 0);
+}
+
+TEST(TestIO, TestCharsFromFileParallelOptions) {
+  std::string filename = "test_parallel.txt";
+  auto contents = write_test_file(filename, 300001);
+  parlay::file_read_options options;
+  options.block_size = 8192;
+  options.first_touch = true;
+  options.direct_io = true;
+  auto s = parlay::chars_from_file_parallel(filename, false, 0, 0, options);
+  ASSERT_EQ(std::string(s.begin(), s.end()), contents);
+  auto t = parlay::chars_from_file_parallel(filename, false, 5000, 250007, options);
+  ASSERT_EQ(std::string(t.begin(), t.end()), contents.substr(5000, 245007));
+}
+
+TEST(TestIO, TestDirectReads) {
+  std::string filename = "test_direct.txt";
+  size_t n = 100017, a = 4096;
+  auto contents = write_test_file(filename, n);
+  parlay::internal::positioned_reader file(filename, true);
+  ASSERT_TRUE(file.is_open());
+  char* buf = static_cast<char*>(std::aligned_alloc(a, 32 * a));
+  // Whole blocks, partial blocks at either end, a buffer that is aligned
+  // differently from the offset, and reads running past the end
+  std::pair<size_t, size_t> reads[] = {{0, 8 * a}, {a, 3 * a}, {100, 5 * a}, {a + 7, 2 * a - 7},
+                                        {3 * a, 5 * a + 123}, {5, 10}, {n - 2 * a - 3, 4 * a}, {n - 10, 100}, {n, 10}};
+  for (auto [offset, m] : reads) {
+    for (size_t shift : {size_t{0}, offset % a, size_t{1}}) {
+      std::memset(buf, 0, 32 * a);
+      size_t r = file.read(buf + shift, m, offset);
+      size_t expected = offset < n ? (std::min)(m, n - offset) : 0;
+      ASSERT_EQ(r, expected);
+      ASSERT_EQ(std::string(buf + shift, r), contents.substr((std::min)(offset, n), expected));
+    }
+  }
+  std::free(buf);
+}
+
+TEST(TestIO, TestCharsToFileParallel) {
+  std::string filename = "test_parallel_out.txt";
+  auto s = parlay::tabulate(1000003, [](size_t i) -> char { return 'a' + parlay::hash64(i) % 26; });
+  parlay::chars_to_file_parallel(s, filename, 10000);
+  ASSERT_EQ(parlay::chars_from_file(filename), s);
+  // Overwriting with something shorter truncates the file
+  auto t = s.substr(0, 123);
+  parlay::chars_to_file_parallel(t, filename);
+  ASSERT_EQ(parlay::chars_from_file(filename), t);
+}
+
+TEST(TestIO, TestFormatToFile) {
+  std::string filename = "test_format.txt";
+  auto a = parlay::tabulate(100000, [](long i) { return (i % 3 == 0) ? -i * i : i * 1000003; });
+  parlay::format_to_file(a, filename, '\n', 100);
+  auto expected = parlay::flatten(parlay::map(a, [](long x) {
+    auto c = parlay::to_chars(x);
+    c.push_back('\n');
+    return c;
+  }));
+  ASSERT_EQ(parlay::chars_from_file(filename), expected);
+  auto lines = parlay::tokens(parlay::chars_from_file(filename), [](char c) { return c == '\n'; });
+  ASSERT_EQ(lines.size(), a.size());
+  ASSERT_EQ(parlay::chars_to_long(lines[3]), a[3]);
+}
+
+TEST(TestIO, TestFormatToFileEmpty) {
+  std::string filename = "test_format_empty.txt";
+  parlay::format_to_file(parlay::sequence<int>{}, filename);
+  ASSERT_EQ(parlay::chars_from_file(filename).size(), 0);
+  parlay::format_to_file(std::vector<std::string>{"ab", "cd"}, filename, ' ');
+  auto s = parlay::chars_from_file(filename);
+  ASSERT_EQ(std::string(s.begin(), s.end()), "ab cd ");
+}
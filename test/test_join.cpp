@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include <parlay/hardware.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+namespace {
+
+struct row {
+  bool operator<(const row& other) const { return key < other.key; }
+  int key;
+  int payload;
+};
+
+auto first = [](const auto& p) { return p.first; };
+auto key_of = [](const row& r) { return r.key; };
+
+template <typename R1, typename R2>
+parlay::sequence<std::pair<size_t, size_t>> nested_loop_join(const R1& a, const R2& b) {
+  parlay::sequence<std::pair<size_t, size_t>> out;
+  for (size_t i = 0; i < a.size(); i++)
+    for (size_t j = 0; j < b.size(); j++)
+      if (a[i].first == b[j].key) out.emplace_back(i, j);
+  return out;
+}
+
+}  // namespace
+
+TEST(TestJoin, TestHashJoinEmpty) {
+  parlay::sequence<std::pair<int, int>> a;
+  parlay::sequence<row> b = {{1, 2}};
+  ASSERT_EQ(parlay::hash_join_indices(a, b, first, key_of).size(), 0);
+  ASSERT_EQ(parlay::hash_join_indices(b, a, key_of, first).size(), 0);
+}
+
+TEST(TestJoin, TestHashJoinSmall) {
+  parlay::sequence<std::pair<int, std::string>> a = {{1, "a"}, {2, "b"}, {2, "c"}, {4, "d"}};
+  parlay::sequence<row> b = {{2, 20}, {3, 30}, {1, 10}, {2, 21}};
+  auto result = parlay::hash_join(a, b, first, key_of);
+  ASSERT_EQ(result.size(), 5);
+  auto summary = parlay::map(result, [](const auto& p) { return p.first.second + std::to_string(p.second.payload); });
+  std::sort(summary.begin(), summary.end());
+  ASSERT_EQ(summary, (parlay::sequence<std::string>{"a10", "b20", "b21", "c20", "c21"}));
+}
+
+TEST(TestJoin, TestHashJoinMatchesNestedLoops) {
+  auto a = parlay::tabulate(2000, [](size_t i) { return std::make_pair(static_cast<int>(parlay::hash64(i) % 500), static_cast<int>(i)); });
+  auto b = parlay::tabulate(3000, [](size_t i) { return row{static_cast<int>(parlay::hash64(i + 7) % 700), static_cast<int>(i)}; });
+  auto result = parlay::hash_join_indices(a, b, first, key_of);
+  auto expected = nested_loop_join(a, b);
+  parlay::sort_inplace(result);
+  ASSERT_EQ(result, expected);
+}
+
+TEST(TestJoin, TestHashJoinManyPartitions) {
+  auto saved = parlay::get_hardware_profile();
+  parlay::hardware_profile tiny = saved;
+  tiny.l2_size = 4096;
+  tiny.l3_size = 0;
+  parlay::set_hardware_profile(tiny);
+  auto a = parlay::tabulate(5000, [](size_t i) { return std::make_pair(static_cast<int>(i % 2500), static_cast<int>(i)); });
+  auto b = parlay::tabulate(4000, [](size_t i) { return row{static_cast<int>(i), static_cast<int>(i)}; });
+  auto result = parlay::hash_join_indices(a, b, first, key_of);
+  parlay::set_hardware_profile(saved);
+  auto expected = nested_loop_join(a, b);
+  parlay::sort_inplace(result);
+  ASSERT_EQ(result, expected);
+}
+
+TEST(TestJoin, TestHashJoinLarge) {
+  size_t n = 1000000;
+  auto a = parlay::tabulate(n, [](size_t i) { return std::make_pair(static_cast<long>(i), static_cast<long>(i)); });
+  auto b = parlay::tabulate(2 * n, [&](size_t i) { return static_cast<long>(parlay::hash64(i) % (2 * n)); });
+  auto result = parlay::hash_join_indices(a, b, first, [](long x) { return x; });
+  size_t expected = parlay::count_if(b, [&](long x) { return x < static_cast<long>(n); });
+  ASSERT_EQ(result.size(), expected);
+  ASSERT_TRUE(parlay::all_of(result, [&](const auto& ij) { return a[ij.first].first == b[ij.second]; }));
+}
+
+TEST(TestJoin, TestSemiAndAntiJoin) {
+  auto a = parlay::tabulate(100000, [](size_t i) { return std::make_pair(static_cast<int>(i), static_cast<int>(i)); });
+  auto b = parlay::tabulate(50000, [](size_t i) { return row{static_cast<int>(3 * i), 0}; });
+  auto semi = parlay::semi_join(a, b, first, key_of);
+  auto anti = parlay::anti_join(a, b, first, key_of);
+  ASSERT_EQ(semi.size(), 33334);
+  ASSERT_EQ(anti.size(), 100000 - 33334);
+  ASSERT_TRUE(parlay::all_of(semi, [](const auto& p) { return p.first % 3 == 0; }));
+  ASSERT_TRUE(parlay::all_of(anti, [](const auto& p) { return p.first % 3 != 0; }));
+  ASSERT_TRUE(std::is_sorted(semi.begin(), semi.end()));
+  ASSERT_TRUE(std::is_sorted(anti.begin(), anti.end()));
+}
+
+TEST(TestJoin, TestJoinStringKeys) {
+  parlay::sequence<std::string> a = {"apple", "banana", "cherry", "apple"};
+  parlay::sequence<std::string> b = {"banana", "apple", "durian"};
+  auto id = [](const std::string& s) -> const std::string& { return s; };
+  ASSERT_EQ(parlay::hash_join_indices(a, b, id, id).size(), 3);
+  ASSERT_EQ(parlay::semi_join(a, b, id, id), (parlay::sequence<std::string>{"apple", "banana", "apple"}));
+  ASSERT_EQ(parlay::anti_join(a, b, id, id), (parlay::sequence<std::string>{"cherry"}));
+}
+
+namespace {
+
+template <typename F>
+parlay::sequence<std::pair<size_t, size_t>> nested_loop_join_if(size_t n, size_t m, F match) {
+  parlay::sequence<std::pair<size_t, size_t>> out;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < m; j++)
+      if (match(i, j)) out.emplace_back(i, j);
+  return out;
+}
+
+}  // namespace
+
+TEST(TestJoin, TestMergeJoinEmpty) {
+  parlay::sequence<int> a, b = {1, 2};
+  auto id = [](int x) { return x; };
+  ASSERT_EQ(parlay::merge_join_indices(a, b, id, id).size(), 0);
+  ASSERT_EQ(parlay::merge_join_indices(b, a, id, id).size(), 0);
+}
+
+TEST(TestJoin, TestMergeJoinSmall) {
+  parlay::sequence<std::pair<int, char>> a = {{1, 'a'}, {2, 'b'}, {2, 'c'}, {4, 'd'}};
+  parlay::sequence<row> b = {{1, 10}, {2, 20}, {2, 21}, {3, 30}};
+  auto result = parlay::merge_join(a, b, first, key_of);
+  ASSERT_EQ(result.size(), 5);
+  ASSERT_EQ(result[0].first.second, 'a');
+  ASSERT_EQ(result[1].second.payload, 20);
+  ASSERT_EQ(result[4].first.second, 'c');
+  ASSERT_EQ(result[4].second.payload, 21);
+}
+
+TEST(TestJoin, TestMergeJoinMatchesNestedLoops) {
+  auto a = parlay::sort(parlay::tabulate(3000, [](size_t i) { return static_cast<int>(parlay::hash64(i) % 1000); }));
+  auto b = parlay::sort(parlay::tabulate(5000, [](size_t i) { return static_cast<int>(parlay::hash64(i + 1) % 1500); }));
+  auto id = [](int x) { return x; };
+  auto result = parlay::merge_join_indices(a, b, id, id);
+  ASSERT_EQ(result, nested_loop_join_if(a.size(), b.size(), [&](size_t i, size_t j) { return a[i] == b[j]; }));
+}
+
+TEST(TestJoin, TestMergeJoinHeavyKeys) {
+  // a single key with many matches on both sides, among unique keys
+  auto a = parlay::tabulate(8000, [](size_t i) { return (i >= 2000 && i < 5000) ? 2500L : static_cast<long>(i); });
+  auto b = parlay::tabulate(12000, [](size_t i) { return (i >= 1000 && i < 4000) ? 2500L : static_cast<long>(i + 1000); });
+  a = parlay::sort(a);
+  b = parlay::sort(b);
+  auto id = [](long x) { return x; };
+  auto result = parlay::merge_join_indices(a, b, id, id);
+  ASSERT_EQ(result.size(), nested_loop_join_if(a.size(), b.size(), [&](size_t i, size_t j) { return a[i] == b[j]; }).size());
+  ASSERT_TRUE(std::is_sorted(result.begin(), result.end()));
+  ASSERT_TRUE(parlay::all_of(result, [&](const auto& ij) { return a[ij.first] == b[ij.second]; }));
+}
+
+TEST(TestJoin, TestMergeJoinDescending) {
+  parlay::sequence<int> a = {9, 7, 7, 3}, b = {8, 7, 3, 3, 1};
+  auto id = [](int x) { return x; };
+  auto result = parlay::merge_join_indices(a, b, id, id, std::greater<>());
+  ASSERT_EQ(result, (parlay::sequence<std::pair<size_t, size_t>>{{1, 1}, {2, 1}, {3, 2}, {3, 3}}));
+}
+
+TEST(TestJoin, TestBandJoinSmall) {
+  parlay::sequence<int> a = {10, 20, 30}, b = {8, 11, 19, 25, 40};
+  auto result = parlay::band_join_indices(a, b, -2, 2);
+  ASSERT_EQ(result, (parlay::sequence<std::pair<size_t, size_t>>{{0, 0}, {0, 1}, {1, 2}}));
+  auto asymmetric = parlay::band_join(a, b, 0, 5);
+  ASSERT_EQ(asymmetric.size(), 2);
+  ASSERT_EQ(asymmetric[0], std::make_pair(10, 11));
+  ASSERT_EQ(asymmetric[1], std::make_pair(20, 25));
+}
+
+TEST(TestJoin, TestBandJoinNoOverflow) {
+  // key + lo wraps around for small unsigned keys
+  parlay::sequence<unsigned int> a = {0, 1, 10}, b = {0, 2, 3, 9};
+  ASSERT_EQ(parlay::band_join_indices(a, b, -2, 2),
+            (parlay::sequence<std::pair<size_t, size_t>>{{0, 0}, {0, 1}, {1, 0}, {1, 1}, {1, 2}, {2, 3}}));
+
+  // key + hi overflows for keys near the maximum
+  long max = std::numeric_limits<long>::max(), min = std::numeric_limits<long>::min();
+  parlay::sequence<long> c = {min, min + 1, -1, max - 1, max}, d = {min, 0, max};
+  ASSERT_EQ(parlay::band_join_indices(c, d, -1L, 1L),
+            (parlay::sequence<std::pair<size_t, size_t>>{{0, 0}, {1, 0}, {2, 1}, {3, 2}, {4, 2}}));
+  ASSERT_EQ(parlay::band_join_indices(c, d, min, max).size(), 9);
+  ASSERT_EQ(parlay::band_join_indices(c, d, max, max), (parlay::sequence<std::pair<size_t, size_t>>{{1, 1}}));
+
+  parlay::sequence<unsigned long> e = {0, std::numeric_limits<unsigned long>::max()};
+  ASSERT_EQ(parlay::band_join_indices(e, e, 0L, 1L), (parlay::sequence<std::pair<size_t, size_t>>{{0, 0}, {1, 1}}));
+}
+
+TEST(TestJoin, TestBandJoinMatchesNestedLoops) {
+  auto a = parlay::sort(parlay::tabulate(2000, [](size_t i) { return static_cast<double>(parlay::hash64(i) % 100000) / 10; }));
+  auto b = parlay::sort(parlay::tabulate(3000, [](size_t i) { return row{static_cast<int>(parlay::hash64(i + 5) % 10000), static_cast<int>(i)}; }));
+  auto key_b = [](const row& r) { return static_cast<double>(r.key); };
+  auto id = [](double x) { return x; };
+  auto result = parlay::band_join_indices(a, b, -7.5, 3.0, id, key_b);
+  ASSERT_EQ(result, nested_loop_join_if(a.size(), b.size(), [&](size_t i, size_t j) {
+    return a[i] - 7.5 <= key_b(b[j]) && key_b(b[j]) <= a[i] + 3.0;
+  }));
+}
+
+TEST(TestJoin, TestBandJoinLarge) {
+  size_t n = 2000000;
+  auto a = parlay::tabulate(n, [](size_t i) { return static_cast<long>(3 * i); });
+  auto b = parlay::tabulate(n, [](size_t i) { return static_cast<long>(2 * i); });
+  auto result = parlay::band_join_indices(a, b, -1L, 1L);
+  ASSERT_TRUE(parlay::all_of(result, [&](const auto& ij) { return std::abs(a[ij.first] - b[ij.second]) <= 1; }));
+  // 3i is within 1 of an even number 2j < 2n once if it is even, and twice if it is odd
+  size_t expected = 0;
+  for (size_t i = 0; i < n; i++) {
+    long x = a[i];
+    for (long y = x - 1; y <= x + 1; y++) expected += (y >= 0 && y % 2 == 0 && y < static_cast<long>(2 * n));
+  }
+  ASSERT_EQ(result.size(), expected);
+}
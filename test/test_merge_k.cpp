@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+#include <parlay/slice.h>
+
+#include <parlay/internal/merge_k.h>
+
+// k sorted runs of pseudorandom lengths up to max_len, with values below max_val
+parlay::sequence<parlay::sequence<long long>> make_runs(size_t k, size_t max_len, long long max_val) {
+  return parlay::tabulate(k, [&](size_t i) {
+    size_t len = parlay::hash64(i) % (max_len + 1);
+    auto run = parlay::tabulate(len, [&](size_t j) -> long long {
+      return parlay::hash64(i * max_len + j) % max_val;
+    });
+    std::sort(run.begin(), run.end());
+    return run;
+  });
+}
+
+TEST(TestMergeK, TestMergeK) {
+  auto runs = make_runs(100, 2000, 1 << 20);
+  auto merged = parlay::merge_k(runs);
+  auto expected = parlay::flatten(runs);
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKManyRuns) {
+  auto runs = make_runs(5000, 50, 1 << 20);
+  auto merged = parlay::merge_k(runs);
+  auto expected = parlay::flatten(runs);
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKTwoRuns) {
+  auto runs = make_runs(2, 100000, 1 << 20);
+  auto merged = parlay::merge_k(runs);
+  ASSERT_EQ(merged, parlay::merge(runs[0], runs[1]));
+}
+
+TEST(TestMergeK, TestMergeKSmall) {
+  auto runs = make_runs(7, 20, 100);
+  auto merged = parlay::merge_k(runs);
+  auto expected = parlay::flatten(runs);
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKEmpty) {
+  parlay::sequence<parlay::sequence<long long>> runs;
+  ASSERT_TRUE(parlay::merge_k(runs).empty());
+  runs = parlay::sequence<parlay::sequence<long long>>(10);
+  ASSERT_TRUE(parlay::merge_k(runs).empty());
+}
+
+TEST(TestMergeK, TestMergeKUnbalanced) {
+  // One large run and many tiny or empty ones
+  auto runs = make_runs(300, 10, 1 << 20);
+  runs[17] = parlay::sort(parlay::tabulate(200000, [](size_t i) -> long long {
+    return parlay::hash64(i) % (1 << 20);
+  }));
+  auto merged = parlay::merge_k(runs);
+  auto expected = parlay::flatten(runs);
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKStable) {
+  // Few distinct keys, tagged with the run and position they came from
+  using P = std::pair<int, std::pair<size_t, size_t>>;
+  auto runs = parlay::tabulate(50, [](size_t i) {
+    auto keys = parlay::sort(parlay::tabulate(parlay::hash64(i) % 5000, [&](size_t j) {
+      return static_cast<int>(parlay::hash64(i * 5000 + j) % 10);
+    }));
+    return parlay::tabulate(keys.size(), [&](size_t j) { return P{keys[j], {i, j}}; });
+  });
+  auto by_key = [](const P& a, const P& b) { return a.first < b.first; };
+  auto merged = parlay::merge_k(runs, by_key);
+  auto expected = parlay::flatten(runs);
+  std::stable_sort(expected.begin(), expected.end(), by_key);
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKAllEqual) {
+  auto runs = parlay::tabulate(20, [](size_t i) {
+    return parlay::sequence<long long>(1000 * (i % 3), 42);
+  });
+  auto merged = parlay::merge_k(runs);
+  ASSERT_EQ(merged, parlay::flatten(runs));
+}
+
+TEST(TestMergeK, TestMergeKCustomCompare) {
+  auto runs = make_runs(64, 3000, 1000);
+  for (auto& run : runs) std::reverse(run.begin(), run.end());
+  auto merged = parlay::merge_k(runs, std::greater<long long>());
+  auto expected = parlay::flatten(runs);
+  std::sort(expected.begin(), expected.end(), std::greater<long long>());
+  ASSERT_EQ(merged, expected);
+}
+
+TEST(TestMergeK, TestMergeKSlices) {
+  auto s = parlay::sort(parlay::tabulate(100000, [](size_t i) -> long long {
+    return parlay::hash64(i) % 1000000;
+  }));
+  // interleave the sorted input into runs by taking every tenth element
+  auto runs = parlay::tabulate(10, [&](size_t i) {
+    return parlay::tabulate(s.size() / 10, [&](size_t j) { return s[10 * j + i]; });
+  });
+  auto slices = parlay::map(runs, [](auto& run) { return parlay::make_slice(run); });
+  auto merged = parlay::internal::merge_k(slices, std::less<long long>());
+  ASSERT_EQ(merged, s);
+}
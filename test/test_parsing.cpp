@@ -1,10 +1,14 @@
 #include "gtest/gtest.h"
 
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <sstream>
+#include <string>
 
 #include <parlay/io.h>
 
@@ -357,3 +361,75 @@ TEST(TestParsing, TestCharsToLongDoubleSmall) {
     ASSERT_EQ(convert_std(y), convert_parlay(y));
   }
 }
+
+TEST(TestParsing, TestCharsToIntLong) {
+  // runs of eight digits are read at once from contiguous input
+  ASSERT_EQ(parlay::chars_to_long(parlay::to_chars("1234567812345678")), 1234567812345678L);
+  ASSERT_EQ(parlay::chars_to_long(parlay::to_chars("-00000000000000123456789")), -123456789L);
+  ASSERT_EQ(parlay::chars_to_ulong_long(parlay::to_chars("+18446744073709551615")), 18446744073709551615ULL);
+  ASSERT_EQ(parlay::chars_to_int(parlay::to_chars("12345678 9")), 12345678);
+  ASSERT_EQ(parlay::chars_to_int(parlay::to_chars("1234567x90")), 1234567);
+  std::string s = "-9223372036854775808";
+  ASSERT_EQ(parlay::internal::chars_to_int_t<long long>(parlay::make_slice(s)), (std::numeric_limits<long long>::min)());
+  for (long x = 1; x < (std::numeric_limits<long>::max)() / 7; x = x * 7 + 3) {
+    ASSERT_EQ(x, parlay::chars_to_long(parlay::to_chars(std::to_string(x))));
+    ASSERT_EQ(-x, parlay::chars_to_long(parlay::to_chars(std::to_string(-x))));
+  }
+}
+
+TEST(TestParsing, TestCharsToFloatExact) {
+  // Compares the bits of the result against strtod for random doubles
+  // printed with random numbers of significant digits
+  std::string buf(64, ' ');
+  for (size_t i = 0; i < 200000; i++) {
+    uint64_t h = parlay::hash64(i);
+    double x;
+    std::memcpy(&x, &h, sizeof(double));
+    if (!std::isfinite(x)) continue;
+    int digits = static_cast<int>(parlay::hash64(h) % 20) + 1;
+    int len = std::snprintf(buf.data(), buf.size(), "%.*g", digits, x);
+    auto s = parlay::chars(buf.begin(), buf.begin() + len);
+    std::string str(buf.begin(), buf.begin() + len);
+    double expected = std::strtod(str.c_str(), nullptr);
+    float expected_float = std::strtof(str.c_str(), nullptr);
+    // out of range values throw, as std::stod does
+    if (std::isinf(expected) || std::fpclassify(expected) == FP_SUBNORMAL || (expected == 0 && x != 0)) continue;
+    ASSERT_EQ(expected, parlay::chars_to_double(s)) << str;
+    if (std::fpclassify(expected_float) == FP_NORMAL) {
+      ASSERT_EQ(expected_float, parlay::chars_to_float(s)) << str;
+    }
+  }
+  // long significands whose dropped digits matter, and halfway cases
+  for (std::string str : {"2.2250738585072014e-308", "1.7976931348623157e308", "4.9406564584124654e-300"}) {
+    ASSERT_EQ(std::strtod(str.c_str(), nullptr), parlay::chars_to_double(parlay::to_chars(str))) << str;
+  }
+  for (std::string str : {"9007199254740993", "9007199254740993.0000000000000000001", "0.1e1", "123456789012345678901234567890e-10",
+                          "0.00000000000000000000000000000000001234567890123456789012345678",
+                          "7.450580596923828125e-9", "1.00000005960464477550", "3.4028235e38", "3,25", "  -12.5e-1"}) {
+    auto s = parlay::to_chars(str);
+    std::replace(str.begin(), str.end(), ',', '.');
+    ASSERT_EQ(std::strtod(str.c_str(), nullptr), parlay::chars_to_double(s)) << str;
+    ASSERT_EQ(std::strtof(str.c_str(), nullptr), parlay::chars_to_float(s)) << str;
+  }
+  ASSERT_THROW(parlay::chars_to_double(parlay::to_chars("1e400")), std::out_of_range);
+  ASSERT_TRUE(std::signbit(parlay::chars_to_double(parlay::to_chars("-0.0"))));
+}
+
+TEST(TestParsing, TestParseNumbers) {
+  auto strings = parlay::tabulate(100000, [](long i) { return parlay::to_chars(i * 37 - 1000000); });
+  auto ints = parlay::parse_numbers<long>(strings);
+  ASSERT_EQ(ints, parlay::tabulate(100000, [](long i) { return i * 37 - 1000000; }));
+
+  auto text = parlay::flatten(parlay::tabulate(100000, [](size_t i) {
+    auto s = parlay::to_chars(static_cast<double>(i) / 8);
+    s.push_back(i % 10 == 0 ? '\n' : ' ');
+    return s;
+  }));
+  auto doubles = parlay::parse_numbers<double>(text);
+  ASSERT_EQ(doubles, parlay::tabulate(100000, [](size_t i) { return static_cast<double>(i) / 8; }));
+
+  auto floats = parlay::parse_numbers<float>(parlay::to_chars("1.5,-2,,3e2"), parlay::is_char(','));
+  ASSERT_EQ(floats, parlay::sequence<float>({1.5f, -2.0f, 300.0f}));
+  auto long_doubles = parlay::parse_numbers<long double>(std::string("0.25 4"));
+  ASSERT_EQ(long_doubles, parlay::sequence<long double>({0.25L, 4.0L}));
+}
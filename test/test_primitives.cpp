@@ -696,6 +696,42 @@ TEST(TestPrimitives, TestMapSplitAt) {
   ASSERT_EQ(map_reduces, answer);
 }
 
+TEST(TestPrimitives, TestTokensLarge) {
+  // Compares the vectorized paths for is_whitespace and is_char against
+  // equivalent predicates that take the general path
+  const char alphabet[] = "ab \t\n\v\f\r,x\x80\xff";
+  for (size_t n : {0, 1, 63, 64, 65, 4095, 4096, 4097, 100003}) {
+    auto chars = parlay::tabulate(n, [&](size_t i) -> char {
+      return alphabet[parlay::hash64(i) % (sizeof(alphabet) - 1)]; });
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r'; };
+    auto size = [](auto&& t) { return t.size(); };
+    auto pos = [&](auto&& t) { return t.begin() - chars.begin(); };
+    ASSERT_EQ(parlay::map_tokens(chars, pos), parlay::map_tokens(chars, pos, is_space));
+    ASSERT_EQ(parlay::map_tokens(chars, size), parlay::map_tokens(chars, size, is_space));
+    auto is_comma = [](char c) { return c == ','; };
+    ASSERT_EQ(parlay::map_tokens(chars, pos, parlay::is_char(',')), parlay::map_tokens(chars, pos, is_comma));
+    ASSERT_EQ(parlay::tokens(chars, parlay::is_char(',')), parlay::tokens(chars, is_comma));
+  }
+}
+
+TEST(TestPrimitives, TestIsWhitespaceIsCLocale) {
+  for (int c = 0; c < 256; c++) {
+    bool expected = c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    ASSERT_EQ(parlay::is_whitespace(static_cast<unsigned char>(c)), expected);
+  }
+}
+
+TEST(TestPrimitives, TestSplitAtBoolFlags) {
+  for (size_t n : {0, 1, 64, 999999}) {
+    auto seq = parlay::tabulate(n, [](size_t i) { return static_cast<int>(i); });
+    auto flags = parlay::tabulate(n, [](size_t i) -> bool { return parlay::hash64(i) % 7 == 0; });
+    auto seqs = parlay::split_at(seq, flags);
+    auto ans = parlay::split_at(seq, parlay::delayed_tabulate(n, [&](size_t i) -> bool { return flags[i]; }));
+    ASSERT_EQ(seqs, ans);
+    ASSERT_EQ(seqs.size(), parlay::count(flags, true) + 1);
+  }
+}
+
 TEST(TestPrimitives, TestRemoveDuplicatesOrdered) {
   auto s = parlay::tabulate(100000,  [](int i) { return i % 1000; });
   auto r = parlay::remove_duplicates_ordered(s);
@@ -803,3 +839,81 @@ TEST(TestPrimitives, TestKthSmallest) {
     ASSERT_EQ(*parlay::kth_smallest(s, i), i);
   }
 }
+
+TEST(TestPrimitives, TestNthElementInplace) {
+  std::default_random_engine eng{2022};
+  auto s = parlay::to_sequence(parlay::iota<size_t>(100000));
+  std::shuffle(s.begin(), s.end(), eng);
+
+  for (size_t k : {size_t{0}, size_t{1}, size_t{50000}, size_t{99998}, size_t{99999}}) {
+    auto s2 = s;
+    parlay::nth_element_inplace(s2, k);
+    ASSERT_EQ(s2[k], k);
+    for (size_t i = 0; i < k; i++) ASSERT_LT(s2[i], k);
+    for (size_t i = k + 1; i < s2.size(); i++) ASSERT_GT(s2[i], k);
+  }
+}
+
+TEST(TestPrimitives, TestNthElementDuplicates) {
+  // Only a few distinct values, so the pivots are often equal
+  auto s = parlay::tabulate(100000, [](size_t i) { return parlay::hash64(i) % 3; });
+  auto sorted = parlay::sort(s);
+  for (size_t k = 0; k < 100000; k += 9973) {
+    auto s2 = s;
+    parlay::nth_element_inplace(s2, k);
+    ASSERT_EQ(s2[k], sorted[k]);
+    for (size_t i = 0; i < k; i++) ASSERT_LE(s2[i], s2[k]);
+    for (size_t i = k + 1; i < s2.size(); i++) ASSERT_GE(s2[i], s2[k]);
+  }
+}
+
+TEST(TestPrimitives, TestPartialSort) {
+  std::default_random_engine eng{2022};
+  auto s = parlay::to_sequence(parlay::iota<size_t>(100000));
+  std::shuffle(s.begin(), s.end(), eng);
+
+  for (size_t k : {size_t{0}, size_t{1}, size_t{1000}, size_t{60000}, size_t{100000}, size_t{200000}}) {
+    auto result = parlay::partial_sort(s, k);
+    ASSERT_EQ(result.size(), s.size());
+    for (size_t i = 0; i < std::min(k, s.size()); i++) ASSERT_EQ(result[i], i);
+    auto rest = parlay::sort(result.cut(std::min(k, s.size()), s.size()));
+    for (size_t i = 0; i < rest.size(); i++) ASSERT_EQ(rest[i], k + i);
+  }
+}
+
+TEST(TestPrimitives, TestPartialSortInplaceCustomComp) {
+  auto s = parlay::tabulate(100000, [](size_t i) { return parlay::hash64(i) % 1000; });
+  auto sorted = parlay::sort(s, std::greater<>());
+  parlay::partial_sort_inplace(s, 5000, std::greater<>());
+  for (size_t i = 0; i < 5000; i++) ASSERT_EQ(s[i], sorted[i]);
+}
+
+TEST(TestPrimitives, TestTopK) {
+  std::default_random_engine eng{2022};
+  auto s = parlay::to_sequence(parlay::iota<size_t>(100000));
+  std::shuffle(s.begin(), s.end(), eng);
+
+  for (size_t k : {size_t{0}, size_t{1}, size_t{10}, size_t{1000}, size_t{50000}, size_t{100000}, size_t{200000}}) {
+    auto top = parlay::top_k(s, k);
+    ASSERT_EQ(top.size(), std::min(k, s.size()));
+    for (size_t i = 0; i < top.size(); i++) ASSERT_EQ(top[i], i);
+  }
+}
+
+TEST(TestPrimitives, TestTopKDuplicates) {
+  for (size_t distinct : {1, 2, 10, 1000}) {
+    auto s = parlay::tabulate(100000, [&](size_t i) { return parlay::hash64(i) % distinct; });
+    auto sorted = parlay::sort(s);
+    for (size_t k : {1, 100, 5000}) {
+      auto top = parlay::top_k(s, k);
+      ASSERT_EQ(top, parlay::to_sequence(sorted.head(k)));
+    }
+  }
+}
+
+TEST(TestPrimitives, TestTopKCustomComp) {
+  auto s = parlay::tabulate(100000, [](size_t i) { return std::to_string(parlay::hash64(i) % 100000); });
+  auto sorted = parlay::sort(s, std::greater<>());
+  auto top = parlay::top_k(s, 777, std::greater<>());
+  ASSERT_EQ(top, parlay::to_sequence(sorted.head(777)));
+}
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <cmath>
 #include <deque>
 #include <numeric>
 
@@ -134,3 +135,53 @@ TEST(TestSampleSort, TestSortInplaceNonContiguous) {
   ASSERT_EQ(s, s2);
   ASSERT_TRUE(std::is_sorted(std::begin(s), std::end(s)));
 }
+
+// Skewed keys where a few values make up most of the input
+parlay::sequence<long long> skewed_keys(size_t n) {
+  return parlay::tabulate(n, [n](size_t i) -> long long {
+    double u = static_cast<double>(parlay::hash64(i) % (1 << 20)) / (1 << 20);
+    return static_cast<long long>(std::pow(static_cast<double>(n), u * u * u));
+  });
+}
+
+TEST(TestSampleSort, TestSortSkewed) {
+  auto s = skewed_keys(200000);
+  auto sorted = parlay::internal::sample_sort(parlay::make_slice(s), std::less<long long>());
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
+
+TEST(TestSampleSort, TestStableSortSkewed) {
+  auto keys = skewed_keys(200000);
+  auto s = parlay::tabulate(keys.size(), [&](size_t i) -> UnstablePair {
+    UnstablePair x;
+    x.x = static_cast<int>(keys[i]);
+    x.y = static_cast<int>(i);
+    return x;
+  });
+  auto sorted = parlay::internal::sample_sort(parlay::make_slice(s), std::less<UnstablePair>(), true);
+  std::stable_sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
+
+TEST(TestSampleSort, TestSortInplaceSkewed) {
+  auto s = skewed_keys(200000);
+  auto s2 = s;
+  parlay::internal::sample_sort_inplace(parlay::make_slice(s), std::less<long long>());
+  std::sort(std::begin(s2), std::end(s2));
+  ASSERT_EQ(s, s2);
+}
+
+TEST(TestSampleSort, TestSortFewDistinct) {
+  for (long long distinct : {1, 2, 3, 100}) {
+    auto s = parlay::tabulate(100000, [&](size_t i) -> long long {
+      return parlay::hash64(i) % distinct;
+    });
+    auto s2 = s;
+    auto sorted = parlay::internal::sample_sort(parlay::make_slice(s), std::greater<long long>());
+    parlay::internal::sample_sort_inplace(parlay::make_slice(s2), std::greater<long long>());
+    std::sort(std::rbegin(s), std::rend(s));
+    ASSERT_EQ(s, sorted);
+    ASSERT_EQ(s, s2);
+  }
+}
@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+#include <parlay/sketches.h>
+
+TEST(TestSketches, TestHyperLogLogEmpty) {
+  parlay::hyperloglog s;
+  ASSERT_EQ(s.estimate(), 0);
+}
+
+TEST(TestSketches, TestHyperLogLogSmall) {
+  auto s = parlay::build_hyperloglog(parlay::sequence<int>{1, 2, 3, 2, 1, 5});
+  ASSERT_NEAR(s.estimate(), 4, 0.1);
+}
+
+TEST(TestSketches, TestHyperLogLogLarge) {
+  size_t n = 2000000, distinct = 300000;
+  auto a = parlay::tabulate(n, [&](size_t i) { return parlay::hash64(i) % distinct; });
+  auto exact = static_cast<double>(parlay::remove_duplicates(a).size());
+  auto s = parlay::build_hyperloglog(a);
+  ASSERT_NEAR(s.estimate(), exact, 0.03 * exact);
+}
+
+TEST(TestSketches, TestHyperLogLogMerge) {
+  auto a = parlay::tabulate(100000, [](size_t i) { return i; });
+  auto b = parlay::tabulate(100000, [](size_t i) { return i + 50000; });
+  auto s = parlay::build_hyperloglog(a, 12);
+  s.merge(parlay::build_hyperloglog(b, 12));
+  ASSERT_NEAR(s.estimate(), 150000, 0.05 * 150000);
+}
+
+TEST(TestSketches, TestHyperLogLogReduce) {
+  auto parts = parlay::tabulate(10, [](size_t j) {
+    parlay::hyperloglog s(10);
+    for (size_t i = 0; i < 1000; i++) s.insert(j * 1000 + i);
+    return s;
+  });
+  auto s = parlay::reduce(parts, parlay::hyperloglog_monoid(10));
+  ASSERT_NEAR(s.estimate(), 10000, 0.1 * 10000);
+}
+
+TEST(TestSketches, TestCountMinNeverUnderestimates) {
+  size_t n = 1000000;
+  auto a = parlay::tabulate(n, [](size_t i) { return static_cast<unsigned int>(parlay::hash64(i) % 5000); });
+  auto sketch = parlay::build_count_min_sketch(a, 4096, 5);
+  auto exact = parlay::histogram_by_key(a);
+  size_t bound = static_cast<size_t>(std::exp(1.0) * static_cast<double>(n) / 4096);
+  size_t far_off = 0;
+  for (const auto& [k, c] : exact) {
+    size_t e = sketch.estimate(k);
+    ASSERT_GE(e, c);
+    far_off += (e > c + bound);
+  }
+  ASSERT_LE(far_off, exact.size() / 50);
+}
+
+static_assert(!std::is_convertible_v<size_t, parlay::count_min_sketch>);
+
+TEST(TestSketches, TestCountMinMerge) {
+  parlay::count_min_sketch a(256, 3), b(256, 3);
+  a.insert(std::string("x"), 5);
+  b.insert(std::string("x"), 7);
+  b.insert(std::string("y"));
+  a.merge(b);
+  ASSERT_GE(a.estimate(std::string("x")), 12);
+  ASSERT_GE(a.estimate(std::string("y")), 1);
+}
+
+TEST(TestSketches, TestSpaceSavingInsert) {
+  parlay::space_saving<int> s(3);
+  for (int x : {1, 1, 1, 2, 2, 3, 4, 1, 5})
+    s.insert(x);
+  auto top = s.top();
+  ASSERT_EQ(top.size(), 3);
+  ASSERT_EQ(top[0].key, 1);
+  ASSERT_EQ(top[0].count, 4);
+  ASSERT_GE(s.estimate(2), 2);
+}
+
+TEST(TestSketches, TestSpaceSavingHeavyHitters) {
+  // keys 0..9 are heavy, the rest of the keys appear a few times each
+  size_t n = 2000000;
+  auto a = parlay::tabulate(n, [](size_t i) -> unsigned long {
+    return (i % 4 == 0) ? (i / 4) % 10 : 10 + parlay::hash64(i) % 500000;
+  });
+  auto s = parlay::build_space_saving(a, 100);
+  auto top = s.top();
+  ASSERT_EQ(top.size(), 100);
+  auto exact = parlay::histogram_by_key(a);
+  for (unsigned long k = 0; k < 10; k++) {
+    ASSERT_LT(top[k].key, 10);
+    ASSERT_GE(top[k].count, n / 40);
+    ASSERT_LE(top[k].count - top[k].error, n / 40);
+  }
+  for (const auto& [k, c] : exact) ASSERT_GE(s.estimate(k), c);
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+
+#include <parlay/io.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+
+#include <parlay/internal/string_sort.h>
+
+// Strings over a small alphabet with lots of shared prefixes
+parlay::sequence<parlay::chars> make_strings(size_t n, size_t alphabet = 4, size_t max_len = 12) {
+  return parlay::tabulate(n, [&](size_t i) {
+    size_t len = parlay::hash64(i) % (max_len + 1);
+    return parlay::chars::from_function(len, [&](size_t j) -> char {
+      return static_cast<char>('a' + parlay::hash64(i * (max_len + 1) + j) % alphabet);
+    });
+  });
+}
+
+size_t naive_lcp(const parlay::chars& a, const parlay::chars& b) {
+  size_t i = 0;
+  while (i < a.size() && i < b.size() && a[i] == b[i]) i++;
+  return i;
+}
+
+TEST(TestStringSort, TestSort) {
+  auto s = make_strings(100000);
+  auto sorted = parlay::internal::string_sort(parlay::make_slice(s));
+  ASSERT_EQ(s.size(), sorted.size());
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
+
+TEST(TestStringSort, TestSortSmall) {
+  auto s = make_strings(1000);
+  auto sorted = parlay::internal::string_sort(parlay::make_slice(s));
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
+
+TEST(TestStringSort, TestSortEmpty) {
+  parlay::sequence<parlay::chars> s;
+  auto [sorted, lcp] = parlay::string_sort_lcp(s);
+  ASSERT_TRUE(sorted.empty());
+  ASSERT_TRUE(lcp.empty());
+}
+
+TEST(TestStringSort, TestSortInplace) {
+  auto s = make_strings(100000);
+  auto s2 = s;
+  parlay::string_sort_inplace(s);
+  std::sort(std::begin(s2), std::end(s2));
+  ASSERT_EQ(s, s2);
+}
+
+TEST(TestStringSort, TestLcp) {
+  auto s = make_strings(100000);
+  auto [sorted, lcp] = parlay::string_sort_lcp(s);
+  ASSERT_EQ(lcp.size(), s.size());
+  ASSERT_EQ(lcp[0], 0);
+  for (size_t i = 1; i < sorted.size(); i++) {
+    ASSERT_EQ(lcp[i], naive_lcp(sorted[i-1], sorted[i]));
+  }
+}
+
+TEST(TestStringSort, TestLongCommonPrefixes) {
+  // All strings share a long prefix and there are many duplicates
+  auto prefix = parlay::chars(100, 'x');
+  auto s = parlay::tabulate(50000, [&](size_t i) {
+    return parlay::append(prefix, parlay::to_chars(static_cast<long>(i % 1000)));
+  });
+  auto [sorted, lcp] = parlay::string_sort_lcp(s);
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+  for (size_t i = 1; i < sorted.size(); i++) {
+    ASSERT_EQ(lcp[i], naive_lcp(sorted[i-1], sorted[i]));
+  }
+}
+
+TEST(TestStringSort, TestIndex) {
+  auto s = make_strings(100000, 26, 8);
+  auto [perm, lcp] = parlay::string_sort_index(s);
+  ASSERT_EQ(perm.size(), s.size());
+  auto sorted = parlay::map(perm, [&](size_t i) { return s[i]; });
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
+
+TEST(TestStringSort, TestStdStrings) {
+  // Characters should compare as unsigned, i.e., the same as std::string
+  auto s = parlay::tabulate(50000, [](size_t i) {
+    std::string str;
+    size_t len = parlay::hash64(i) % 6;
+    for (size_t j = 0; j < len; j++)
+      str.push_back(static_cast<char>(parlay::hash64(7 * i + j) % 256));
+    return str;
+  });
+  auto sorted = parlay::string_sort(s);
+  std::sort(std::begin(s), std::end(s));
+  ASSERT_EQ(s, sorted);
+}
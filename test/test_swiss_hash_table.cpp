@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <parlay/hash_table.h>
+#include <parlay/parallel.h>
+#include <parlay/primitives.h>
+#include <parlay/sequence.h>
+#include <parlay/swiss_hash_table.h>
+
+struct hash_string {
+  using eType = std::string;
+  using kType = std::string;
+  eType empty() { return ""; }
+  const kType& getKey(const eType& v) { return v; }
+  size_t hash(const kType& v) { return parlay::hash64(std::hash<std::string>{}(v)); }
+  int cmp(const kType& a, const kType& b) { return a.compare(b); }
+};
+
+struct entry {
+  long key;
+  std::string name;
+};
+
+struct hash_entry {
+  using eType = entry;
+  using kType = long;
+  eType empty() { return {-1, ""}; }
+  kType getKey(const eType& v) { return v.key; }
+  size_t hash(kType v) { return parlay::hash64(v); }
+  int cmp(kType a, kType b) { return (a > b) ? 1 : ((a == b) ? 0 : -1); }
+};
+
+TEST(TestSwissHashtable, TestInsertFind) {
+  parlay::swiss_hashtable<parlay::hash_numeric<int>>
+    table(400000, parlay::hash_numeric<int>{});
+
+  parlay::parallel_for(1, 100000, [&](int i) {
+    ASSERT_TRUE(table.insert(i));
+  });
+  ASSERT_EQ(table.count(), 99999);
+
+  parlay::parallel_for(1, 200000, [&](int i) {
+    ASSERT_EQ(table.find(i), (i < 100000) ? i : -1);
+  });
+}
+
+TEST(TestSwissHashtable, TestDuplicates) {
+  parlay::swiss_hashtable<parlay::hash_numeric<int>>
+    table(100000, parlay::hash_numeric<int>{});
+
+  auto inserted = parlay::tabulate(100000, [&](int i) -> int {
+    return table.insert(i % 1000);
+  });
+  ASSERT_EQ(parlay::reduce(inserted), 1000);
+  ASSERT_EQ(table.count(), 1000);
+  auto entries = parlay::sort(table.entries());
+  ASSERT_EQ(entries, parlay::to_sequence(parlay::iota<int>(1000)));
+}
+
+TEST(TestSwissHashtable, TestFullLoad) {
+  // Every slot is used, so most probes have to go past full groups
+  size_t n = 1 << 16;
+  parlay::swiss_hashtable<parlay::hash_numeric<long>>
+    table(n, parlay::hash_numeric<long>{}, 1.0);
+
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_TRUE(table.insert(static_cast<long>(i)));
+  });
+  ASSERT_EQ(table.count(), n);
+  parlay::parallel_for(0, n, [&](size_t i) {
+    ASSERT_EQ(table.find(static_cast<long>(i)), static_cast<long>(i));
+  });
+  ASSERT_EQ(table.find(static_cast<long>(n)), -1);
+
+  // A full table tells a new key apart from one that is present
+  ASSERT_FALSE(table.insert(5));
+  ASSERT_THROW(table.insert(static_cast<long>(n)), std::length_error);
+  ASSERT_EQ(table.count(), n);
+}
+
+TEST(TestSwissHashtable, TestDelete) {
+  parlay::swiss_hashtable<parlay::hash_numeric<int>>
+    table(400000, parlay::hash_numeric<int>{});
+
+  parlay::parallel_for(1, 100000, [&](int i) {
+    table.insert(i);
+  });
+
+  parlay::parallel_for(1, 100000, [&](int i) {
+    if (i % 2 == 0) {
+      table.deleteVal(i);
+    }
+  });
+  ASSERT_EQ(table.count(), 50000);
+
+  parlay::parallel_for(1, 100000, [&](int i) {
+    ASSERT_EQ(table.find(i), (i % 2 == 1) ? i : -1);
+  });
+
+  // deleted keys can be inserted again
+  ASSERT_TRUE(table.insert(2));
+  ASSERT_EQ(table.find(2), 2);
+}
+
+TEST(TestSwissHashtable, TestStrings) {
+  parlay::swiss_hashtable<hash_string> table(100000, hash_string{});
+
+  parlay::parallel_for(0, 100000, [&](size_t i) {
+    table.insert("a longer string to defeat the small string optimization " + std::to_string(i % 50000));
+  });
+  ASSERT_EQ(table.count(), 50000);
+
+  parlay::parallel_for(0, 100000, [&](size_t i) {
+    auto key = "a longer string to defeat the small string optimization " + std::to_string(i);
+    ASSERT_EQ(table.find(key), (i < 50000) ? key : "");
+    ASSERT_EQ(table.contains(key), i < 50000);
+  });
+
+  parlay::parallel_for(0, 50000, [&](size_t i) {
+    if (i % 3 == 0) table.deleteVal("a longer string to defeat the small string optimization " + std::to_string(i));
+  });
+  ASSERT_EQ(table.count(), 50000 - 16667);
+}
+
+TEST(TestSwissHashtable, TestStructs) {
+  parlay::swiss_hashtable<hash_entry> table(10000, hash_entry{});
+
+  parlay::parallel_for(0, 10000, [&](size_t i) {
+    table.insert(entry{static_cast<long>(i), std::to_string(i)});
+  });
+
+  parlay::parallel_for(0, 10000, [&](size_t i) {
+    auto e = table.find(static_cast<long>(i));
+    ASSERT_EQ(e.key, static_cast<long>(i));
+    ASSERT_EQ(e.name, std::to_string(i));
+  });
+  ASSERT_EQ(table.find(10000).key, -1);
+}
+
+TEST(TestSwissHashtable, TestFindDuringInsert) {
+  // Searches can run concurrently with insertions
+  size_t n = 100000;
+  parlay::swiss_hashtable<parlay::hash_numeric<long>>
+    table(2 * n, parlay::hash_numeric<long>{});
+
+  parlay::parallel_for(0, n, [&](size_t i) {
+    table.insert(static_cast<long>(2 * i));
+  });
+
+  parlay::parallel_for(0, 2 * n, [&](size_t i) {
+    if (i % 2 == 0) {
+      ASSERT_EQ(table.find(static_cast<long>(i)), static_cast<long>(i));
+    } else {
+      table.insert(static_cast<long>(2 * n + i));
+    }
+  });
+  ASSERT_EQ(table.count(), 2 * n);
+}